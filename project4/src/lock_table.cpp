@@ -3,9 +3,9 @@
 #include <atomic>
 #include <cassert>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <tuple>
-#include <string>
 #include <unordered_map>
 
 class HashTableEntry;
@@ -26,11 +26,22 @@ namespace std
 template <>
 struct hash<table_record_t>
 {
-	size_t operator()(const table_record_t& key) const
+	size_t operator()(const table_record_t& key) const noexcept
 	{
 		auto [tid, rid] = key;
 
-		return std::hash<string>()(std::to_string(tid) + '|' + std::to_string(rid));
+		// splitmix64 finalizer over the record id, then the table id
+		auto mix = [](uint64_t x) {
+			x ^= x >> 30;
+			x *= 0xbf58476d1ce4e5b9ULL;
+			x ^= x >> 27;
+			x *= 0x94d049bb133111ebULL;
+			x ^= x >> 31;
+			return x;
+		};
+
+		return mix(mix(static_cast<uint64_t>(rid)) ^
+			(static_cast<uint32_t>(tid) + 0x9e3779b97f4a7c15ULL));
 	}
 };
 }
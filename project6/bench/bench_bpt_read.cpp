@@ -0,0 +1,150 @@
+// thread-scaling benchmark of b+ tree lookups, comparing the optimistic
+// traversal with the traversal holding the tree latch, and, when nothing is
+// written, with the traversal of the table opened read only from its map.
+//
+// workloads
+//   read-only : every operation is a find of an existing key
+//   read-95%  : 5% of the operations insert a new key
+//
+// usage: bench_bpt_read [num_keys] [ops_per_thread]
+
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+
+// large enough to hold the whole tree
+constexpr int NUM_BUF = 4096;
+
+bool prepare_table(int num_keys)
+{
+    CHECK_FAILURE(init_db(NUM_BUF, 0, 0, const_cast<char*>("bench.log"),
+                          const_cast<char*>("bench_logmsg.txt")) == SUCCESS);
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    char value[] = "value";
+    for (int key = 0; key < num_keys; ++key)
+    {
+        CHECK_FAILURE(db_insert(tid, key, value) == SUCCESS);
+    }
+
+    return shutdown_db() == SUCCESS;
+}
+
+double run(bool optimistic, bool read_only, int write_percent,
+           int num_threads, int num_keys, int ops_per_thread)
+{
+    DBConfig config;
+    config.optimistic_reads = optimistic;
+    init_db(NUM_BUF, 0, 0, const_cast<char*>("bench.log"),
+            const_cast<char*>("bench_logmsg.txt"), config);
+
+    const int tid =
+        read_only ? open_table_read_only(const_cast<char*>(TABLE_NAME))
+                  : open_table(const_cast<char*>(TABLE_NAME));
+    Table& table = *TblMgr().get_table(tid).value();
+
+    // new keys are placed above the prepared ones, and the ones inserted
+    // by the previous runs
+    static std::atomic<int64_t> next_key{ num_keys };
+
+    auto worker = [&](int seed) {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<int64_t> dist(0, num_keys - 1);
+        char value[] = "value";
+
+        for (int i = 0; i < ops_per_thread; ++i)
+        {
+            if (static_cast<int>(gen() % 100) < write_percent)
+            {
+                if (db_insert(tid, next_key++, value) != SUCCESS)
+                    std::abort();
+                continue;
+            }
+
+            if (!table.find(dist(gen), nullptr).has_value())
+                std::abort();
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+        threads.emplace_back(worker, i + 1);
+    for (auto& t : threads)
+        t.join();
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    shutdown_db();
+
+    return static_cast<double>(num_threads) * ops_per_thread /
+           elapsed.count();
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_keys = (argc > 1) ? std::atoi(argv[1]) : 100000;
+    const int ops_per_thread = (argc > 2) ? std::atoi(argv[2]) : 200000;
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    if (!prepare_table(num_keys))
+    {
+        std::fprintf(stderr, "failed to prepare %s\n", TABLE_NAME);
+        return 1;
+    }
+
+    std::printf("%-10s %-8s %14s %14s %14s\n", "workload", "threads",
+                "latched(op/s)", "olc(op/s)", "mmap(op/s)");
+
+    for (const auto& [name, write_percent] :
+         { std::make_pair("read-only", 0), std::make_pair("read-95%", 5) })
+    {
+        for (int threads : { 1, 2, 4, 8, 16 })
+        {
+            const double latched = run(false, false, write_percent, threads,
+                                       num_keys, ops_per_thread);
+            const double olc = run(true, false, write_percent, threads,
+                                   num_keys, ops_per_thread);
+
+            if (write_percent > 0)
+            {
+                std::printf("%-10s %-8d %14.0f %14.0f %14s\n", name, threads,
+                            latched, olc, "-");
+                continue;
+            }
+
+            const double mapped = run(true, true, write_percent, threads,
+                                      num_keys, ops_per_thread);
+
+            std::printf("%-10s %-8d %14.0f %14.0f %14.0f\n", name, threads,
+                        latched, olc, mapped);
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
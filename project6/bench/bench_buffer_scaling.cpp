@@ -0,0 +1,138 @@
+// thread-scaling benchmark of BufferManager::get_page.
+// every worker pins random pages of one table through buffer(), so the
+// numbers show how much the buffer pool latch limits concurrent readers.
+//
+// usage: bench_buffer_scaling [num_pages] [ops_per_thread]
+
+#include "buffer.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+
+bool prepare_table(int num_pages)
+{
+    DBConfig config;
+    CHECK_FAILURE(init_db(num_pages, 0, 0, const_cast<char*>("bench.log"),
+                          const_cast<char*>("bench_logmsg.txt"),
+                          config) == SUCCESS);
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    Table& table = *TblMgr().get_table(tid).value();
+    for (int i = 0; i < num_pages; ++i)
+    {
+        pagenum_t pagenum;
+        CHECK_FAILURE(BufMgr().create_page(table, true, pagenum));
+    }
+
+    return shutdown_db() == SUCCESS;
+}
+
+struct Result
+{
+    double ops_per_sec;
+    int partitions;
+};
+
+Result run(int num_buf, int num_partitions, int num_threads, int num_pages,
+           int ops_per_thread)
+{
+    DBConfig config;
+    config.buffer_partitions = num_partitions;
+    init_db(num_buf, 0, 0, const_cast<char*>("bench.log"),
+            const_cast<char*>("bench_logmsg.txt"), config);
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    Table& table = *TblMgr().get_table(tid).value();
+
+    auto worker = [&](int seed) {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<pagenum_t> dist(1, num_pages);
+
+        for (int i = 0; i < ops_per_thread; ++i)
+        {
+            const bool ok = buffer(
+                [](Page& page) { return page.header().is_leaf == 1; }, table,
+                dist(gen), PageLatch::SHARED);
+            if (!ok)
+                std::abort();
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+        threads.emplace_back(worker, i + 1);
+    for (auto& t : threads)
+        t.join();
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    const int partitions = BufMgr().num_partitions();
+
+    shutdown_db();
+
+    return { static_cast<double>(num_threads) * ops_per_thread /
+                 elapsed.count(),
+             partitions };
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_pages = (argc > 1) ? std::atoi(argv[1]) : 4096;
+    const int ops_per_thread = (argc > 2) ? std::atoi(argv[2]) : 200000;
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    if (!prepare_table(num_pages))
+    {
+        std::fprintf(stderr, "failed to prepare %s\n", TABLE_NAME);
+        return 1;
+    }
+
+    const int auto_partitions = 0;
+
+    std::printf("%-10s %-8s %-10s %14s %14s\n", "workload", "threads",
+                "partitions", "single(op/s)", "sharded(op/s)");
+
+    for (const auto& [name, num_buf] :
+         { std::make_pair("all-hit", num_pages + 1),
+           std::make_pair("miss-25%", (num_pages + 1) * 3 / 4) })
+    {
+        for (int threads : { 1, 2, 4, 8, 16 })
+        {
+            const Result single =
+                run(num_buf, 1, threads, num_pages, ops_per_thread);
+            const Result sharded = run(num_buf, auto_partitions, threads,
+                                       num_pages, ops_per_thread);
+
+            std::printf("%-10s %-8d %-10d %14.0f %14.0f\n", name, threads,
+                        sharded.partitions, single.ops_per_sec,
+                        sharded.ops_per_sec);
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
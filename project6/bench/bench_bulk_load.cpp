@@ -0,0 +1,131 @@
+// loading a table from records in key order: one db_insert per record
+// against db_bulk_load by fill factor. the time includes closing the
+// table, so that the pages inserted are written back as well.
+//
+// usage: bench_bulk_load [records]
+
+#include "bpt.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+constexpr int NUM_BUF = 4096;
+
+struct Method final
+{
+    const char* name;
+    // 0 for inserts
+    double fill_factor;
+};
+
+struct Source final
+{
+    int64_t next;
+    int64_t end;
+};
+
+int next_record(void* context, int64_t* key, char* value)
+{
+    Source& source = *static_cast<Source*>(context);
+    if (source.next == source.end)
+        return 0;
+
+    *key = source.next++;
+    std::strcpy(value, "value");
+    return 1;
+}
+
+uint64_t file_pages()
+{
+    struct stat st;
+    return (stat(TABLE_NAME, &st) == 0) ? st.st_size / PAGE_SIZE : 0;
+}
+
+bool run(const Method& method, int64_t num_records)
+{
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    CHECK_FAILURE(init_db(NUM_BUF, 0, 0, const_cast<char*>("bench.log"),
+                          const_cast<char*>("bench_logmsg.txt")) == SUCCESS);
+
+    int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (method.fill_factor == 0)
+    {
+        char value[] = "value";
+        for (int64_t key = 0; key < num_records; ++key)
+            CHECK_FAILURE(db_insert(tid, key, value) == SUCCESS);
+    }
+    else
+    {
+        Source source{ 0, num_records };
+        int64_t loaded = 0;
+        CHECK_FAILURE(db_bulk_load(tid, next_record, &source,
+                                   method.fill_factor, &loaded) == SUCCESS);
+        CHECK_FAILURE(loaded == num_records);
+    }
+
+    CHECK_FAILURE(close_table(tid) == SUCCESS);
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    const auto layout = TblMgr().get_table(tid).value()->leaf_layout();
+    CHECK_FAILURE(layout.has_value());
+    CHECK_FAILURE(shutdown_db() == SUCCESS);
+
+    std::printf("%-12s %10.1f %14.0f %8lu %10lu %9.3f\n", method.name,
+                elapsed.count() * 1000, num_records / elapsed.count(),
+                layout->num_leaves, file_pages(), layout->fragmentation());
+
+    return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int64_t num_records = (argc > 1) ? std::atoll(argv[1]) : 1000000;
+
+    const std::vector<Method> methods{
+        { "insert", 0 },
+        { "bulk-100", 1.0 },
+        { "bulk-90", 0.9 },
+        { "bulk-70", 0.7 },
+    };
+
+    std::printf("%-12s %10s %14s %8s %10s %9s\n", "method", "time(ms)",
+                "records/s", "leaves", "file pages", "fragment");
+
+    for (const auto& method : methods)
+    {
+        if (!run(method, num_records))
+        {
+            std::fprintf(stderr, "failed to run the benchmark\n");
+            return 1;
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
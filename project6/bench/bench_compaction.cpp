@@ -0,0 +1,177 @@
+// online compaction of a table after delete-heavy churn, by batch size.
+// a reader thread looks up the kept keys all along, its latency shows how
+// long the batches hold the tree latch.
+//
+// the table is built with ascending keys, then all but one key out of ten
+// are deleted in random order, leaving most leaves nearly empty.
+//
+// usage: bench_compaction [keys]
+
+#include "bpt.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+constexpr int NUM_BUF = 4096;
+constexpr int64_t KEEP_EVERY = 10;
+// a batch as large as the whole compaction
+constexpr int WHOLE = 1 << 30;
+
+bool init()
+{
+    return init_db(NUM_BUF, 0, 0, const_cast<char*>("bench.log"),
+                   const_cast<char*>("bench_logmsg.txt")) == SUCCESS;
+}
+
+uint64_t file_pages()
+{
+    struct stat st;
+    return (stat(TABLE_NAME, &st) == 0) ? st.st_size / PAGE_SIZE : 0;
+}
+
+bool build(int num_keys)
+{
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    CHECK_FAILURE(init());
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    char value[] = "value";
+    std::vector<int64_t> deleted;
+    for (int64_t key = 0; key < num_keys; ++key)
+    {
+        CHECK_FAILURE(db_insert(tid, key, value) == SUCCESS);
+        if (key % KEEP_EVERY != 0)
+            deleted.push_back(key);
+    }
+
+    std::mt19937 gen(1);
+    std::shuffle(begin(deleted), end(deleted), gen);
+    for (int64_t key : deleted)
+        CHECK_FAILURE(db_delete(tid, key) == SUCCESS);
+
+    return shutdown_db() == SUCCESS;
+}
+
+bool run(int num_keys, int batch_pages)
+{
+    CHECK_FAILURE(build(num_keys));
+    const uint64_t pages_before = file_pages();
+
+    unlink("bench.log");
+    CHECK_FAILURE(init());
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+    Table& table = *TblMgr().get_table(tid).value();
+
+    const auto layout_before = table.leaf_layout();
+    CHECK_FAILURE(layout_before.has_value());
+
+    std::atomic<bool> stop{ false };
+    std::vector<double> latencies;
+    std::thread reader([&] {
+        std::mt19937 gen(2);
+        while (!stop)
+        {
+            const int64_t key =
+                (gen() % (num_keys / KEEP_EVERY)) * KEEP_EVERY;
+
+            const auto start = std::chrono::steady_clock::now();
+            const auto record = table.find(key, nullptr);
+            const std::chrono::duration<double, std::micro> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            if (record.has_value())
+                latencies.push_back(elapsed.count());
+        }
+    });
+
+    CompactionStats total;
+    int num_batches = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    while (!total.done)
+    {
+        const auto stats = table.compact(batch_pages);
+        if (!stats.has_value())
+            break;
+
+        total += stats.value();
+        ++num_batches;
+
+        // the reader gets its turn between the batches
+        std::this_thread::yield();
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    stop = true;
+    reader.join();
+    CHECK_FAILURE(total.done);
+
+    const auto layout_after = table.leaf_layout();
+    CHECK_FAILURE(layout_after.has_value());
+    CHECK_FAILURE(shutdown_db() == SUCCESS);
+
+    std::sort(begin(latencies), end(latencies));
+    const double p99 =
+        latencies.empty() ? 0 : latencies[latencies.size() * 99 / 100];
+    const double max = latencies.empty() ? 0 : latencies.back();
+
+    const std::string batch =
+        (batch_pages == WHOLE) ? "whole" : std::to_string(batch_pages);
+
+    std::printf("%-8s %8d %10.1f %7lu->%-7lu %6lu->%-6lu %5.3f->%-5.3f "
+                "%10.1f %10.1f\n",
+                batch.c_str(), num_batches, elapsed.count(), pages_before,
+                file_pages(), layout_before->num_leaves,
+                layout_after->num_leaves, layout_before->fragmentation(),
+                layout_after->fragmentation(), p99, max);
+
+    return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_keys = (argc > 1) ? std::atoi(argv[1]) : 200000;
+
+    std::printf("%-8s %8s %10s %16s %14s %12s %10s %10s\n", "batch",
+                "batches", "time(ms)", "file pages", "leaves",
+                "fragment", "p99(us)", "max(us)");
+
+    for (int batch_pages : { 16, 256, WHOLE })
+    {
+        if (!run(num_keys, batch_pages))
+        {
+            std::fprintf(stderr, "failed to run the benchmark\n");
+            return 1;
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
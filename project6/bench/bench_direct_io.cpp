@@ -0,0 +1,192 @@
+// memory use and throughput of buffered against O_DIRECT table files.
+// with buffered i/o, a page read into the pool stays in the kernel page
+// cache as well. the page cache share of the table file is counted with
+// mincore, and dropped with posix_fadvise before every run.
+//
+// workloads (random page reads, after the pool is warmed up)
+//   pool = table   : every page fits in the pool
+//   pool = table/4 : misses are served by the page cache or the device
+//
+// usage: bench_direct_io [pages] [ops]
+
+#include "buffer.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+
+long rss_kb()
+{
+    std::ifstream status("/proc/self/status");
+
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+            return std::atol(line.c_str() + 6);
+    }
+
+    return -1;
+}
+
+// kilobytes of the table file in the kernel page cache
+long page_cache_kb()
+{
+    const int fd = open(TABLE_NAME, O_RDONLY);
+    if (fd == -1)
+        return -1;
+
+    const off_t size = lseek(fd, 0, SEEK_END);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED)
+        return -1;
+
+    const long page_size = sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> resident((size + page_size - 1) / page_size);
+
+    long count = 0;
+    if (mincore(addr, size, resident.data()) == 0)
+    {
+        for (unsigned char page : resident)
+            count += page & 1;
+    }
+
+    munmap(addr, size);
+
+    return count * page_size / 1024;
+}
+
+void drop_page_cache()
+{
+    const int fd = open(TABLE_NAME, O_RDONLY);
+    if (fd == -1)
+        return;
+
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+bool init(int num_buf, bool direct_io)
+{
+    DBConfig config;
+    config.direct_io = direct_io;
+    config.read_ahead_pages = 0;
+
+    return init_db(num_buf, 0, 0, const_cast<char*>("bench.log"),
+                   const_cast<char*>("bench_logmsg.txt"),
+                   config) == SUCCESS;
+}
+
+bool build(int num_pages)
+{
+    CHECK_FAILURE(init(1024, false));
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    Table& table = *TblMgr().get_table(tid).value();
+    for (int i = 0; i < num_pages; ++i)
+    {
+        pagenum_t pagenum;
+        CHECK_FAILURE(BufMgr().create_page(table, true, pagenum));
+    }
+
+    return shutdown_db() == SUCCESS;
+}
+
+bool read_pages(Table& table, int num_pages, int num_ops, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<pagenum_t> pagenum(1, num_pages);
+
+    for (int i = 0; i < num_ops; ++i)
+    {
+        std::optional<Page> page;
+        CHECK_FAILURE(BufMgr().get_page(table, pagenum(gen), page,
+                                        PageLatch::SHARED));
+    }
+
+    return true;
+}
+
+bool run(const char* name, int num_buf, bool direct_io, int num_pages,
+         int num_ops)
+{
+    drop_page_cache();
+
+    CHECK_FAILURE(init(num_buf, direct_io));
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+    Table& table = *TblMgr().get_table(tid).value();
+
+    // warm up, then measure
+    CHECK_FAILURE(read_pages(table, num_pages, num_ops, 1));
+
+    const auto start = std::chrono::steady_clock::now();
+    CHECK_FAILURE(read_pages(table, num_pages, num_ops, 2));
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    std::printf("%-16s %-9s %12.0f %12ld %14ld\n", name,
+                table.file()->is_direct() ? "direct" : "buffered",
+                num_ops / elapsed.count(), rss_kb(), page_cache_kb());
+
+    return shutdown_db() == SUCCESS;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_pages = (argc > 1) ? std::atoi(argv[1]) : 16384;
+    const int num_ops = (argc > 2) ? std::atoi(argv[2]) : 200000;
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    if (!build(num_pages))
+    {
+        std::fprintf(stderr, "failed to build the table\n");
+        return 1;
+    }
+
+    std::printf("%-16s %-9s %12s %12s %14s\n", "pool", "mode", "reads/s",
+                "rss(kB)", "page cache(kB)");
+
+    for (bool direct_io : { false, true })
+    {
+        if (!run("pool = table", num_pages + 1, direct_io, num_pages,
+                 num_ops) ||
+            !run("pool = table/4", num_pages / 4, direct_io, num_pages,
+                 num_ops))
+        {
+            std::fprintf(stderr, "failed to run the benchmark\n");
+            return 1;
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+// growth of a table file by one page at a time, against growth by extents.
+// every extent is allocated with one fallocate, and its pages are marked
+// free in the cached free space bitmap.
+//
+// workloads (from an empty table)
+//   create : new pages allocated back to back
+//   insert : ascending keys inserted, the leaves split as they fill up
+//
+// usage: bench_extent [pages] [keys]
+
+#include "buffer.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+constexpr int NUM_BUF = 1024;
+
+bool init(int extent_pages)
+{
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    DBConfig config;
+    config.file_extent_pages = extent_pages;
+
+    return init_db(NUM_BUF, 0, 0, const_cast<char*>("bench.log"),
+                   const_cast<char*>("bench_logmsg.txt"),
+                   config) == SUCCESS;
+}
+
+// returns operations per second, or a negative value on failure
+double create(int extent_pages, int num_pages)
+{
+    CHECK_FAILURE2(init(extent_pages), -1);
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE2(tid > 0, -1);
+    Table& table = *TblMgr().get_table(tid).value();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_pages; ++i)
+    {
+        pagenum_t pagenum;
+        CHECK_FAILURE2(BufMgr().create_page(table, true, pagenum), -1);
+    }
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    CHECK_FAILURE2(shutdown_db() == SUCCESS, -1);
+
+    return num_pages / elapsed.count();
+}
+
+double insert(int extent_pages, int num_keys)
+{
+    CHECK_FAILURE2(init(extent_pages), -1);
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE2(tid > 0, -1);
+
+    char value[] = "value";
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int key = 0; key < num_keys; ++key)
+        CHECK_FAILURE2(db_insert(tid, key, value) == SUCCESS, -1);
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    CHECK_FAILURE2(shutdown_db() == SUCCESS, -1);
+
+    return num_keys / elapsed.count();
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_pages = (argc > 1) ? std::atoi(argv[1]) : 20000;
+    const int num_keys = (argc > 2) ? std::atoi(argv[2]) : 200000;
+
+    std::printf("%-12s %14s %14s\n", "extent", "create(pg/s)",
+                "insert(op/s)");
+
+    for (int extent_pages : { 1, 64, 0 })
+    {
+        const double created = create(extent_pages, num_pages);
+        const double inserted = insert(extent_pages, num_keys);
+
+        if (created < 0 || inserted < 0)
+        {
+            std::fprintf(stderr, "failed to run the benchmark\n");
+            return 1;
+        }
+
+        if (extent_pages == 0)
+            std::printf("%-12s %14.0f %14.0f\n", "geometric", created,
+                        inserted);
+        else
+            std::printf("%-12d %14.0f %14.0f\n", extent_pages, created,
+                        inserted);
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+// looking up batches of random keys by batch size: one db_find per key
+// against db_find_many, each batch in a transaction, and the same without
+// transactions, which shows the cost of the traversals alone. pins are the
+// buffer pool lookups, hits and misses, per key.
+//
+// usage: bench_find_many [keys] [lookups]
+
+#include "buffer.h"
+#include "common.h"
+#include "dbapi.h"
+#include "file.h"
+#include "table.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+constexpr int NUM_BUF = 4096;
+
+struct Result final
+{
+    double keys_per_sec;
+    double pins_per_key;
+};
+
+uint64_t pins()
+{
+    const BufferStats stats = BufMgr().stats();
+    return stats.hits + stats.misses;
+}
+
+bool find_batch_unlocked(int tid, const std::vector<int64_t>& batch,
+                         bool many, int& found)
+{
+    Table& table = *TblMgr().get_table(tid).value();
+
+    if (many)
+    {
+        std::vector<std::optional<page_data_t>> records;
+        CHECK_FAILURE(table.find_many(batch, records, nullptr));
+        for (const auto& record : records)
+            found += record.has_value();
+    }
+    else
+    {
+        for (int64_t key : batch)
+            found += table.find(key, nullptr).has_value();
+    }
+
+    return true;
+}
+
+bool find_batch(int tid, const std::vector<int64_t>& batch, bool many,
+                int& found)
+{
+    static char values[1 << 12][PAGE_DATA_VALUE_SIZE];
+    static char* ret_vals[1 << 12];
+    static int found_flags[1 << 12];
+    CHECK_FAILURE(batch.size() <= (1 << 12));
+
+    const int trx_id = trx_begin();
+    CHECK_FAILURE(trx_id != 0);
+
+    if (many)
+    {
+        for (std::size_t i = 0; i < batch.size(); ++i)
+            ret_vals[i] = values[i];
+
+        CHECK_FAILURE(db_find_many(tid, batch.data(), batch.size(), ret_vals,
+                                   found_flags, trx_id) == SUCCESS);
+        for (std::size_t i = 0; i < batch.size(); ++i)
+            found += found_flags[i];
+    }
+    else
+    {
+        for (std::size_t i = 0; i < batch.size(); ++i)
+            found += db_find(tid, batch[i], values[i], trx_id) == SUCCESS;
+    }
+
+    return trx_commit(trx_id) == trx_id;
+}
+
+bool measure(int tid, int64_t num_keys, int batch_size, int num_lookups,
+             bool many, bool locked, Result& result, int& found)
+{
+    // the same keys for all
+    std::mt19937_64 gen(1);
+    std::vector<int64_t> batch(batch_size);
+
+    BufMgr().reset_stats();
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int done = 0; done < num_lookups; done += batch_size)
+    {
+        for (auto& key : batch)
+            key = gen() % num_keys;
+
+        CHECK_FAILURE(locked ? find_batch(tid, batch, many, found)
+                             : find_batch_unlocked(tid, batch, many, found));
+    }
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    result.keys_per_sec = num_lookups / elapsed.count();
+    result.pins_per_key = static_cast<double>(pins()) / num_lookups;
+
+    return true;
+}
+
+bool run(int tid, int64_t num_keys, int batch_size, int num_lookups)
+{
+    // db_find, db_find_many, then both without transactions
+    Result results[4];
+    int found[4] = { 0, 0, 0, 0 };
+
+    for (int method = 0; method < 4; ++method)
+    {
+        CHECK_FAILURE(measure(tid, num_keys, batch_size, num_lookups,
+                              method % 2 == 1, method < 2, results[method],
+                              found[method]));
+        CHECK_FAILURE(found[method] == found[0]);
+    }
+
+    std::printf("%6d %12.0f %12.0f %7.2fx %12.0f %12.0f %7.2fx %6.2f %6.2f\n",
+                batch_size, results[0].keys_per_sec, results[1].keys_per_sec,
+                results[1].keys_per_sec / results[0].keys_per_sec,
+                results[2].keys_per_sec, results[3].keys_per_sec,
+                results[3].keys_per_sec / results[2].keys_per_sec,
+                results[2].pins_per_key, results[3].pins_per_key);
+
+    return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int64_t num_keys = (argc > 1) ? std::atoll(argv[1]) : 300000;
+    const int num_lookups = (argc > 2) ? std::atoi(argv[2]) : 20000;
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    if (init_db(NUM_BUF, 0, 0, const_cast<char*>("bench.log"),
+                const_cast<char*>("bench_logmsg.txt")) != SUCCESS)
+        return 1;
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    if (tid <= 0)
+        return 1;
+
+    // every other key, so that half of the lookups miss
+    char value[] = "value";
+    for (int64_t key = 0; key < num_keys; key += 2)
+    {
+        if (db_insert(tid, key, value) != SUCCESS)
+            return 1;
+    }
+
+    std::printf("%6s %12s %12s %8s %12s %12s %8s %6s %6s\n", "batch",
+                "find/s", "many/s", "speedup", "find-nl/s", "many-nl/s",
+                "speedup", "pins", "pins");
+
+    for (int batch_size : { 1, 10, 100, 1000 })
+    {
+        if (!run(tid, num_keys, batch_size, num_lookups))
+        {
+            std::fprintf(stderr, "failed to run the benchmark\n");
+            return 1;
+        }
+    }
+
+    if (shutdown_db() != SUCCESS)
+        return 1;
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
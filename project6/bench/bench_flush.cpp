@@ -0,0 +1,115 @@
+// checkpoint and close time of a fully dirty buffer pool.
+// the baseline writes the same pages one durable write at a time, which is
+// what sync_all and close_table did before the batched write-back.
+//
+// usage: bench_flush [pages]
+
+#include "buffer.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+
+template <typename Function>
+double measure_ms(Function&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    if (!func())
+        return -1;
+
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+bool dirty_all(Table& table, int num_pages)
+{
+    for (int i = 1; i <= num_pages; ++i)
+    {
+        CHECK_FAILURE(buffer([](Page& page) { page.mark_dirty(); }, table, i));
+    }
+
+    return true;
+}
+
+bool run(int num_pages)
+{
+    CHECK_FAILURE(init_db(2 * num_pages, 0, 0,
+                          const_cast<char*>("bench.log"),
+                          const_cast<char*>("bench_logmsg.txt")) == SUCCESS);
+
+    int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    Table* table = TblMgr().get_table(tid).value();
+    for (int i = 0; i < num_pages; ++i)
+    {
+        pagenum_t pagenum;
+        CHECK_FAILURE(BufMgr().create_page(*table, true, pagenum));
+    }
+    CHECK_FAILURE(BufMgr().sync_all());
+
+    const double per_page = measure_ms([&] {
+        page_t page;
+        memset(&page, 0, sizeof(page));
+
+        for (int i = 1; i <= num_pages; ++i)
+            CHECK_FAILURE(table->file()->file_write_page(i, &page));
+
+        return true;
+    });
+
+    CHECK_FAILURE(dirty_all(*table, num_pages));
+    const double sync_all = measure_ms([] { return BufMgr().sync_all(); });
+
+    CHECK_FAILURE(dirty_all(*table, num_pages));
+    const double close =
+        measure_ms([tid] { return close_table(tid) == SUCCESS; });
+
+    std::printf("%8d %16.1f %16.1f %16.1f\n", num_pages, per_page, sync_all,
+                close);
+
+    return shutdown_db() == SUCCESS;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::printf("%8s %16s %16s %16s\n", "pages", "per-page(ms)",
+                "sync_all(ms)", "close(ms)");
+
+    std::vector<int> sizes{ 256, 1024, 4096 };
+    if (argc > 1)
+        sizes = { std::atoi(argv[1]) };
+
+    for (int num_pages : sizes)
+    {
+        unlink(TABLE_NAME);
+        unlink("bench.log");
+
+        if (!run(num_pages))
+        {
+            std::fprintf(stderr, "failed to run the benchmark\n");
+            return 1;
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
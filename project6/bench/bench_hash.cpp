@@ -0,0 +1,149 @@
+// latency of the hashes of table_page_t and HierarchyID, and of the two
+// hot paths keyed by them: BufferManager::get_page and LockManager::acquire.
+// the string based hashes used before are kept here as the baseline.
+//
+// usage: bench_hash [iterations]
+
+#include "buffer.h"
+#include "common.h"
+#include "dbapi.h"
+#include "lock.h"
+#include "table.h"
+#include "xact.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+constexpr int NUM_PAGES = 1024;
+
+struct StringHash final
+{
+    std::size_t operator()(const table_page_t& tpid) const
+    {
+        auto [tid, pid] = tpid;
+
+        return std::hash<std::string>()(std::to_string(tid) + '|' +
+                                        std::to_string(pid));
+    }
+
+    std::size_t operator()(const HierarchyID& hid) const
+    {
+        return std::hash<std::string>()(std::to_string(hid.table_id) + '|' +
+                                        std::to_string(hid.pagenum) + '|' +
+                                        std::to_string(hid.offset));
+    }
+};
+
+template <typename Function>
+double measure_ns(int iterations, Function&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i)
+        func(i);
+
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / iterations;
+}
+
+// keeps the compiler from dropping the hashed values
+volatile std::size_t sink;
+
+void bench_hash(int iterations)
+{
+    const double string_tpid = measure_ns(iterations, [](int i) {
+        sink = sink + StringHash()(table_page_t{ 1, i });
+    });
+    const double int_tpid = measure_ns(iterations, [](int i) {
+        sink = sink + std::hash<table_page_t>()(table_page_t{ 1, i });
+    });
+
+    const double string_hid = measure_ns(iterations, [](int i) {
+        sink = sink + StringHash()(HierarchyID(1, i / 32, i % 32));
+    });
+    const double int_hid = measure_ns(iterations, [](int i) {
+        sink = sink + std::hash<HierarchyID>()(HierarchyID(1, i / 32, i % 32));
+    });
+
+    std::printf("%-24s %12s %12s\n", "hash (ns/op)", "string", "integer");
+    std::printf("%-24s %12.1f %12.1f\n", "table_page_t", string_tpid,
+                int_tpid);
+    std::printf("%-24s %12.1f %12.1f\n", "HierarchyID", string_hid, int_hid);
+}
+
+bool bench_hot_paths(int iterations)
+{
+    // twice the pages, the partitions do not get exactly the same share
+    CHECK_FAILURE(init_db(2 * NUM_PAGES, 0, 0, const_cast<char*>("bench.log"),
+                          const_cast<char*>("bench_logmsg.txt")) == SUCCESS);
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    Table& table = *TblMgr().get_table(tid).value();
+    for (int i = 0; i < NUM_PAGES; ++i)
+    {
+        pagenum_t pagenum;
+        CHECK_FAILURE(BufMgr().create_page(table, true, pagenum));
+    }
+
+    // every page is cached, so this is the lookup path only
+    const double get_page = measure_ns(iterations, [&](int i) {
+        std::optional<Page> page;
+        if (!BufMgr().get_page(table, 1 + i % NUM_PAGES, page,
+                               PageLatch::NONE))
+            std::abort();
+    });
+
+    Xact* xact = XactMgr().get(trx_begin());
+    CHECK_FAILURE(xact != nullptr);
+
+    const double acquire = measure_ns(iterations, [&](int i) {
+        auto [lock_obj, result] = LockMgr().acquire(
+            HierarchyID(tid, 1 + i % NUM_PAGES, i % 32), xact,
+            LockType::SHARED);
+        if (result != LockAcquireResult::ACQUIRED ||
+            !LockMgr().release(lock_obj))
+            std::abort();
+    });
+
+    CHECK_FAILURE(trx_commit(xact->id()) != 0);
+
+    std::printf("\n%-24s %12s\n", "hot path (ns/op)", "latency");
+    std::printf("%-24s %12.1f\n", "get_page (hit)", get_page);
+    std::printf("%-24s %12.1f\n", "acquire + release", acquire);
+
+    return shutdown_db() == SUCCESS;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int iterations = (argc > 1) ? std::atoi(argv[1]) : 2000000;
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    bench_hash(iterations);
+
+    if (!bench_hot_paths(iterations))
+    {
+        std::fprintf(stderr, "failed to run the hot path benchmark\n");
+        return 1;
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+// page i/o throughput of the i/o backends with 1 to 64 workers.
+// the pool is far smaller than the table, so nearly every random page
+// access is a miss read by the backend, and dirtied pages are written back
+// on eviction.
+//
+// workloads
+//   read       : random page reads
+//   read/write : random page reads, every fifth page is dirtied
+//
+// usage: bench_io [ops]
+
+#include "buffer.h"
+#include "common.h"
+#include "dbapi.h"
+#include "file.h"
+#include "table.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+constexpr int NUM_BUF = 256;
+constexpr int NUM_PAGES = 8192;
+
+const char* name_of(IOBackendType backend)
+{
+    switch (backend)
+    {
+        case IOBackendType::PREAD:
+            return "pread";
+        case IOBackendType::IO_URING:
+            return "io_uring";
+        case IOBackendType::THREAD_POOL:
+            return "thread pool";
+    }
+
+    return "";
+}
+
+bool init(IOBackendType backend)
+{
+    DBConfig config;
+    config.io_backend = backend;
+    config.read_ahead_pages = 0;
+
+    return init_db(NUM_BUF, 0, 0, const_cast<char*>("bench.log"),
+                   const_cast<char*>("bench_logmsg.txt"),
+                   config) == SUCCESS;
+}
+
+bool build()
+{
+    CHECK_FAILURE(init(IOBackendType::PREAD));
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    Table& table = *TblMgr().get_table(tid).value();
+    for (int i = 0; i < NUM_PAGES; ++i)
+    {
+        pagenum_t pagenum;
+        CHECK_FAILURE(BufMgr().create_page(table, true, pagenum));
+    }
+
+    return shutdown_db() == SUCCESS;
+}
+
+// returns pages per second
+double run(Table& table, int num_workers, int num_ops, int write_every)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < num_workers; ++w)
+    {
+        workers.emplace_back([&, w] {
+            std::mt19937 gen(w);
+            std::uniform_int_distribution<pagenum_t> pagenum(1, NUM_PAGES);
+
+            for (int i = 0; i < num_ops / num_workers; ++i)
+            {
+                const bool write = write_every > 0 && i % write_every == 0;
+
+                std::optional<Page> page;
+                if (!BufMgr().get_page(table, pagenum(gen), page,
+                                       write ? PageLatch::EXCLUSIVE
+                                             : PageLatch::SHARED))
+                    std::abort();
+
+                if (write)
+                    page->mark_dirty();
+            }
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return num_ops / elapsed.count();
+}
+
+bool bench(IOBackendType backend, int num_ops)
+{
+    CHECK_FAILURE(init(backend));
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+    Table& table = *TblMgr().get_table(tid).value();
+
+    for (int num_workers : { 1, 4, 16, 64 })
+    {
+        const double read = run(table, num_workers, num_ops, 0);
+        const double read_write = run(table, num_workers, num_ops, 5);
+
+        std::printf("%-12s %8d %14.0f %14.0f\n", name_of(FileMgr().io().type()),
+                    num_workers, read, read_write);
+    }
+
+    return shutdown_db() == SUCCESS;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_ops = (argc > 1) ? std::atoi(argv[1]) : 20000;
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    if (!build())
+    {
+        std::fprintf(stderr, "failed to build the table\n");
+        return 1;
+    }
+
+    std::printf("%-12s %8s %14s %14s\n", "backend", "workers", "read(op/s)",
+                "rw(op/s)");
+
+    for (IOBackendType backend :
+         { IOBackendType::PREAD, IOBackendType::THREAD_POOL,
+           IOBackendType::IO_URING })
+    {
+        if (!bench(backend, num_ops))
+        {
+            std::fprintf(stderr, "failed to run the benchmark\n");
+            return 1;
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
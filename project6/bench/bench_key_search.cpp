@@ -0,0 +1,163 @@
+// latency of a search in the keys of a full node: an inlined std::lower_bound
+// or std::upper_bound against key_search with each kernel the cpu supports.
+// the nodes are random pages, either a few ones staying in the cache or many
+// more of them.
+//
+// searches
+//   leaf  : the lower bound of a key in the records of a leaf
+//   inner : the upper bound of a key in the branches of an inner node
+//   child : the branch pointing to a child, a linear search before
+//
+// usage: bench_key_search [searches]
+
+#include "file.h"
+#include "key_search.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr int LEAF_SIZE = PAGE_DATA_IN_PAGE;
+constexpr int INNER_SIZE = PAGE_BRANCHES_IN_PAGE;
+
+constexpr SearchKernel KERNELS[] = { SearchKernel::SCALAR,
+                                     SearchKernel::SSE42,
+                                     SearchKernel::AVX2 };
+
+// keeps the compiler from dropping the searches
+volatile int sink;
+
+struct Search final
+{
+    int page;
+    int64_t key;
+};
+
+template <typename Function>
+double measure(const std::vector<Search>& searches, Function&& func)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for (const Search& search : searches)
+        sink = sink + func(search);
+
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / searches.size();
+}
+
+// the kernels measured, -1 for the ones the cpu does not support
+template <typename Function>
+void print(const char* name, int num_pages, double std_ns, Function&& func)
+{
+    std::printf("%-6s %8d %10.1f", name, num_pages, std_ns);
+
+    for (SearchKernel kernel : KERNELS)
+    {
+        if (key_search::set_kernel(kernel))
+            std::printf(" %10.1f", func());
+        else
+            std::printf(" %10s", "n/a");
+    }
+
+    std::printf("\n");
+}
+
+void run(int num_pages, int num_searches)
+{
+    std::mt19937_64 gen(num_pages);
+
+    std::vector<page_t> leaves(num_pages);
+    std::vector<page_t> inners(num_pages);
+    for (int i = 0; i < num_pages; ++i)
+    {
+        std::vector<int64_t> keys(INNER_SIZE);
+        for (auto& key : keys)
+            key = gen() % (INNER_SIZE * 16);
+        std::sort(begin(keys), end(keys));
+
+        for (int j = 0; j < INNER_SIZE; ++j)
+        {
+            inners[i].node.branch[j].key = keys[j];
+            inners[i].node.branch[j].child_page_number = j * 7 + 1;
+        }
+
+        for (int j = 0; j < LEAF_SIZE; ++j)
+            leaves[i].node.data[j].key = keys[j * (INNER_SIZE / LEAF_SIZE)];
+    }
+
+    std::vector<Search> searches(num_searches);
+    for (auto& search : searches)
+        search = { static_cast<int>(gen() % num_pages),
+                   static_cast<int64_t>(gen() % (INNER_SIZE * 16)) };
+
+    const double leaf_std = measure(searches, [&](const Search& search) {
+        const page_data_t* data = leaves[search.page].node.data;
+        return std::lower_bound(data, data + LEAF_SIZE, search.key,
+                                [](const page_data_t& lhs, int64_t rhs) {
+                                    return lhs.key < rhs;
+                                }) -
+               data;
+    });
+    print("leaf", num_pages, leaf_std, [&] {
+        return measure(searches, [&](const Search& search) {
+            return key_search::lower_bound(leaves[search.page].node.data,
+                                           LEAF_SIZE, search.key);
+        });
+    });
+
+    const double inner_std = measure(searches, [&](const Search& search) {
+        const page_branch_t* branches = inners[search.page].node.branch;
+        return std::upper_bound(branches, branches + INNER_SIZE, search.key,
+                                [](int64_t lhs, const page_branch_t& rhs) {
+                                    return lhs < rhs.key;
+                                }) -
+               branches;
+    });
+    print("inner", num_pages, inner_std, [&] {
+        return measure(searches, [&](const Search& search) {
+            return key_search::upper_bound(inners[search.page].node.branch,
+                                           INNER_SIZE, search.key);
+        });
+    });
+
+    // the key of a search picks the child
+    const auto child_of = [](const Search& search) -> pagenum_t {
+        return (search.key % INNER_SIZE) * 7 + 1;
+    };
+    const double child_std = measure(searches, [&](const Search& search) {
+        const page_branch_t* branches = inners[search.page].node.branch;
+        const pagenum_t child = child_of(search);
+        return std::find_if(branches, branches + INNER_SIZE,
+                            [&](const page_branch_t& branch) {
+                                return branch.child_page_number == child;
+                            }) -
+               branches;
+    });
+    print("child", num_pages, child_std, [&] {
+        return measure(searches, [&](const Search& search) {
+            return key_search::find_child(inners[search.page].node.branch,
+                                          INNER_SIZE, child_of(search));
+        });
+    });
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_searches = (argc > 1) ? std::atoi(argv[1]) : 2000000;
+
+    std::printf("%-6s %8s %10s %10s %10s %10s\n", "search", "pages",
+                "std(ns)", "scalar(ns)", "sse4.2(ns)", "avx2(ns)");
+
+    for (int num_pages : { 16, 16384 })
+        run(num_pages, num_searches);
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+// placement of the b+ tree leaves with and without split placement, and a
+// scan of the leaves along the sibling chain with cold caches.
+//
+// workloads
+//   append : ascending keys
+//   random : keys in random order
+//   refill : even keys ascending, every other block of them deleted, then
+//            the odd keys in random order, splitting leaves everywhere
+//
+// usage: bench_leaf_layout [keys]
+
+#include "bpt.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+constexpr int64_t DELETE_BLOCK = 2000;
+
+bool init(int num_buf, bool split_placement)
+{
+    DBConfig config;
+    config.split_placement = split_placement;
+
+    return init_db(num_buf, 0, 0, const_cast<char*>("bench.log"),
+                   const_cast<char*>("bench_logmsg.txt"),
+                   config) == SUCCESS;
+}
+
+bool insert_all(int tid, std::vector<int64_t> keys)
+{
+    char value[] = "value";
+    for (int64_t key : keys)
+        CHECK_FAILURE(db_insert(tid, key, value) == SUCCESS);
+
+    return true;
+}
+
+std::vector<int64_t> keys_of(int64_t first, int64_t last, int64_t step)
+{
+    std::vector<int64_t> keys;
+    for (int64_t key = first; key < last; key += step)
+        keys.push_back(key);
+
+    return keys;
+}
+
+bool build(const char* workload, int num_keys, bool split_placement)
+{
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    CHECK_FAILURE(init(4096, split_placement));
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    std::mt19937 gen(1);
+    const std::string name = workload;
+
+    if (name == "append")
+    {
+        CHECK_FAILURE(insert_all(tid, keys_of(0, num_keys, 1)));
+    }
+    else if (name == "random")
+    {
+        auto keys = keys_of(0, num_keys, 1);
+        std::shuffle(begin(keys), end(keys), gen);
+        CHECK_FAILURE(insert_all(tid, keys));
+    }
+    else
+    {
+        CHECK_FAILURE(insert_all(tid, keys_of(0, num_keys, 2)));
+
+        for (int64_t key = 0; key < num_keys; key += 2)
+        {
+            if ((key / DELETE_BLOCK) % 2 == 1)
+                CHECK_FAILURE(db_delete(tid, key) == SUCCESS);
+        }
+
+        auto keys = keys_of(1, num_keys, 2);
+        std::shuffle(begin(keys), end(keys), gen);
+        CHECK_FAILURE(insert_all(tid, keys));
+    }
+
+    return shutdown_db() == SUCCESS;
+}
+
+void drop_page_cache()
+{
+    const int fd = open(TABLE_NAME, O_RDONLY);
+    if (fd == -1)
+        return;
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+bool run(const char* workload, int num_keys, bool split_placement)
+{
+    CHECK_FAILURE(build(workload, num_keys, split_placement));
+
+    drop_page_cache();
+    unlink("bench.log");
+
+    // a small pool, so that every leaf is read from the file
+    CHECK_FAILURE(init(256, split_placement));
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+    Table& table = *TblMgr().get_table(tid).value();
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto layout = table.leaf_layout();
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    CHECK_FAILURE(layout.has_value());
+
+    const uint64_t siblings =
+        std::max<uint64_t>(layout->num_leaves, 2) - 1;
+    std::printf("%-8s %-10s %8lu %14.3f %12.1f %12.1f\n", workload,
+                split_placement ? "placed" : "any", layout->num_leaves,
+                layout->fragmentation(),
+                static_cast<double>(layout->total_distance) / siblings,
+                elapsed.count());
+
+    return shutdown_db() == SUCCESS;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_keys = (argc > 1) ? std::atoi(argv[1]) : 100000;
+
+    std::printf("%-8s %-10s %8s %14s %12s %12s\n", "workload", "split",
+                "leaves", "fragmentation", "distance", "scan(ms)");
+
+    for (const char* workload : { "append", "random", "refill" })
+    {
+        for (bool split_placement : { false, true })
+        {
+            if (!run(workload, num_keys, split_placement))
+            {
+                std::fprintf(stderr, "failed to run the benchmark\n");
+                return 1;
+            }
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
@@ -0,0 +1,203 @@
+// lookup latency of the buffer pool page table against the std::unordered_map
+// it replaced. cache misses come from perf_event_open, and are shown as n/a
+// when the kernel does not allow counting them.
+//
+// workloads (the table holds as many pages as a partition has frames)
+//   lookup : finds of mapped pages in random order
+//   churn  : an eviction, erase of one page and insert of another
+//
+// usage: bench_page_table [lookups]
+
+#include "page_table.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+class CacheMissCounter final
+{
+ public:
+    CacheMissCounter()
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        fd_ = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~CacheMissCounter()
+    {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    void start()
+    {
+        if (fd_ < 0)
+            return;
+
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    // -1 when not available
+    long long stop()
+    {
+        if (fd_ < 0)
+            return -1;
+
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+
+        long long count;
+        if (read(fd_, &count, sizeof(count)) != sizeof(count))
+            return -1;
+
+        return count;
+    }
+
+ private:
+    int fd_{ -1 };
+};
+
+struct Result final
+{
+    double ns_per_op;
+    double misses_per_op;
+};
+
+BufferBlock* fake_block(std::size_t i)
+{
+    // never dereferenced
+    return reinterpret_cast<BufferBlock*>((i + 1) * 64);
+}
+
+// keeps the compiler from dropping the lookups
+volatile std::size_t sink;
+
+template <typename Function>
+Result measure(int num_ops, Function&& func)
+{
+    CacheMissCounter counter;
+
+    counter.start();
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < num_ops; ++i)
+        func(i);
+
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    const long long misses = counter.stop();
+
+    return { elapsed.count() / num_ops,
+             (misses < 0) ? -1.0 : static_cast<double>(misses) / num_ops };
+}
+
+void format_misses(const Result& result, char* out, std::size_t size)
+{
+    if (result.misses_per_op < 0)
+        snprintf(out, size, "n/a");
+    else
+        snprintf(out, size, "%.2f", result.misses_per_op);
+}
+
+void print(const char* name, std::size_t num_pages, const Result& map,
+           const Result& table)
+{
+    char map_misses[32], table_misses[32];
+    format_misses(map, map_misses, sizeof(map_misses));
+    format_misses(table, table_misses, sizeof(table_misses));
+
+    std::printf("%-8s %10zu %12.1f %12.1f %12s %12s\n", name, num_pages,
+                map.ns_per_op, table.ns_per_op, map_misses, table_misses);
+}
+
+void run(std::size_t num_pages, int num_ops)
+{
+    std::mt19937 gen(num_pages);
+
+    // pages of a few tables, spread like the page numbers of real files
+    std::vector<table_page_t> mapped;
+    for (std::size_t i = 0; i < num_pages; ++i)
+        mapped.emplace_back(1 + i % 4, gen() % (16 * num_pages));
+
+    std::unordered_map<table_page_t, BufferBlock*> map;
+    PageTable table(num_pages);
+    for (std::size_t i = 0; i < num_pages; ++i)
+    {
+        if (map.count(mapped[i]) > 0)
+        {
+            // keep the pages unique
+            mapped[i] = { 0, i };
+        }
+
+        map.emplace(mapped[i], fake_block(i));
+        table.insert(mapped[i], fake_block(i));
+    }
+
+    std::vector<std::size_t> order(num_ops);
+    for (auto& index : order)
+        index = gen() % num_pages;
+
+    const Result map_lookup = measure(num_ops, [&](int i) {
+        sink = sink + reinterpret_cast<std::size_t>(
+                          map.find(mapped[order[i]])->second);
+    });
+    const Result table_lookup = measure(num_ops, [&](int i) {
+        sink = sink +
+               reinterpret_cast<std::size_t>(table.find(mapped[order[i]]));
+    });
+    print("lookup", num_pages, map_lookup, table_lookup);
+
+    // every op evicts one mapped page and maps a page never seen before
+    std::vector<table_page_t> map_pages = mapped;
+    std::vector<table_page_t> table_pages = mapped;
+    const pagenum_t first_new = 16 * num_pages + 1;
+
+    const Result map_churn = measure(num_ops, [&](int i) {
+        table_page_t& victim = map_pages[order[i]];
+        map.erase(victim);
+        victim = { 1, first_new + i };
+        map.emplace(victim, fake_block(i));
+    });
+    const Result table_churn = measure(num_ops, [&](int i) {
+        table_page_t& victim = table_pages[order[i]];
+        table.erase(victim);
+        victim = { 1, first_new + i };
+        table.insert(victim, fake_block(i));
+    });
+    print("churn", num_pages, map_churn, table_churn);
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_ops = (argc > 1) ? std::atoi(argv[1]) : 2000000;
+
+    std::printf("%-8s %10s %12s %12s %12s %12s\n", "workload", "pages",
+                "map(ns)", "table(ns)", "map(miss)", "table(miss)");
+
+    for (std::size_t num_pages : { 1024, 65536, 1048576 })
+    {
+        run(num_pages, num_ops);
+    }
+
+    return 0;
+}
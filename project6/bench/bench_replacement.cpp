@@ -0,0 +1,165 @@
+// compares hit rate and throughput of the buffer replacement policies.
+//
+// workloads (page numbers of one table, pool holds 1/4 of the pages)
+//   skewed   : 95% of accesses go to 1/8 of the pages
+//   scan     : skewed accesses interleaved with a sequential scan over the
+//              whole table, every other access belongs to the scan
+//   traverse : a root-to-leaf like pattern, a few hot upper pages followed
+//              by one uniformly chosen page
+//
+// usage: bench_replacement [num_pages] [ops_per_thread] [threads]
+
+#include "buffer.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+
+using Workload = std::function<pagenum_t(std::mt19937&, int, int)>;
+
+bool prepare_table(int num_pages)
+{
+    CHECK_FAILURE(init_db(num_pages, 0, 0, const_cast<char*>("bench.log"),
+                          const_cast<char*>("bench_logmsg.txt")) == SUCCESS);
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    Table& table = *TblMgr().get_table(tid).value();
+    for (int i = 0; i < num_pages; ++i)
+    {
+        pagenum_t pagenum;
+        CHECK_FAILURE(BufMgr().create_page(table, true, pagenum));
+    }
+
+    return shutdown_db() == SUCCESS;
+}
+
+void run(const char* name, ReplacementPolicy policy, const Workload& workload,
+         int num_pages, int ops_per_thread, int num_threads)
+{
+    DBConfig config;
+    config.replacement_policy = policy;
+    init_db(num_pages / 4, 0, 0, const_cast<char*>("bench.log"),
+            const_cast<char*>("bench_logmsg.txt"), config);
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    Table& table = *TblMgr().get_table(tid).value();
+
+    BufMgr().reset_stats();
+
+    auto worker = [&](int thread) {
+        std::mt19937 gen(thread);
+        for (int i = 0; i < ops_per_thread; ++i)
+        {
+            const bool ok = buffer(
+                [](Page& page) { return page.header().is_leaf == 1; }, table,
+                workload(gen, thread, i), PageLatch::SHARED);
+            if (!ok)
+                std::abort();
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+        threads.emplace_back(worker, i);
+    for (auto& t : threads)
+        t.join();
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    const BufferStats stats = BufMgr().stats();
+    const double hit_rate = 100.0 * stats.hits / (stats.hits + stats.misses);
+
+    static const char* policy_names[] = { "LRU", "CLOCK", "2Q" };
+    std::printf("%-9s %-6s %9.2f%% %14.0f\n", name,
+                policy_names[static_cast<int>(policy)], hit_rate,
+                num_threads * ops_per_thread / elapsed.count());
+
+    shutdown_db();
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_pages = (argc > 1) ? std::atoi(argv[1]) : 4096;
+    const int ops_per_thread = (argc > 2) ? std::atoi(argv[2]) : 200000;
+    const int num_threads = (argc > 3) ? std::atoi(argv[3]) : 4;
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    if (!prepare_table(num_pages))
+    {
+        std::fprintf(stderr, "failed to prepare %s\n", TABLE_NAME);
+        return 1;
+    }
+
+    const int hot_pages = num_pages / 8;
+
+    const Workload skewed = [=](std::mt19937& gen, int, int) -> pagenum_t {
+        if (gen() % 20 != 0)
+            return 1 + gen() % hot_pages;
+        return 1 + gen() % num_pages;
+    };
+
+    const Workload scan = [=](std::mt19937& gen, int thread,
+                              int i) -> pagenum_t {
+        if (i % 2 == 0)
+        {
+            const int start = thread * num_pages / num_threads;
+            return 1 + (start + i / 2) % num_pages;
+        }
+        return skewed(gen, thread, i);
+    };
+
+    const Workload traverse = [=](std::mt19937& gen, int,
+                                  int i) -> pagenum_t {
+        // 1 root, 16 internal pages, then leaves
+        switch (i % 3)
+        {
+            case 0:
+                return 1;
+            case 1:
+                return 2 + gen() % 16;
+            default:
+                return 18 + gen() % (num_pages - 17);
+        }
+    };
+
+    std::printf("%-9s %-6s %10s %14s\n", "workload", "policy", "hit-rate",
+                "ops/s");
+
+    for (const auto& [name, workload] :
+         { std::make_pair("skewed", skewed), std::make_pair("scan", scan),
+           std::make_pair("traverse", traverse) })
+    {
+        for (auto policy : { ReplacementPolicy::LRU, ReplacementPolicy::CLOCK,
+                             ReplacementPolicy::TWO_Q })
+        {
+            run(name, policy, workload, num_pages, ops_per_thread,
+                num_threads);
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+// reading the records in [lo, hi] by range size: one find per key of the
+// range against a scan along the leaf sibling chain. the reads are done in
+// a transaction, which locks the records it reads, and without one, which
+// shows the cost of the traversals alone.
+//
+// usage: bench_scan [keys] [ranges]
+
+#include "common.h"
+#include "dbapi.h"
+#include "file.h"
+#include "table.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+constexpr int NUM_BUF = 4096;
+
+// records read, -1 when something fails
+int64_t find_range(int tid, int64_t lo, int64_t hi)
+{
+    const int trx_id = trx_begin();
+
+    int64_t count = 0;
+    char value[PAGE_DATA_VALUE_SIZE];
+    for (int64_t key = lo; key <= hi; ++key)
+    {
+        if (db_find(tid, key, value, trx_id) == SUCCESS)
+            ++count;
+    }
+
+    return (trx_commit(trx_id) == trx_id) ? count : -1;
+}
+
+int64_t scan_range(int tid, int64_t lo, int64_t hi)
+{
+    const int trx_id = trx_begin();
+    const int scan_id = db_scan_open(tid, lo, hi, trx_id);
+    if (scan_id == 0)
+        return -1;
+
+    int64_t count = 0;
+    int64_t key;
+    char value[PAGE_DATA_VALUE_SIZE];
+    while (db_scan_next(scan_id, &key, value) == SUCCESS)
+        ++count;
+
+    if (db_scan_close(scan_id) != SUCCESS)
+        return -1;
+
+    return (trx_commit(trx_id) == trx_id) ? count : -1;
+}
+
+int64_t find_range_unlocked(int tid, int64_t lo, int64_t hi)
+{
+    Table& table = *TblMgr().get_table(tid).value();
+
+    int64_t count = 0;
+    for (int64_t key = lo; key <= hi; ++key)
+    {
+        if (table.find(key, nullptr).has_value())
+            ++count;
+    }
+
+    return count;
+}
+
+int64_t scan_range_unlocked(int tid, int64_t lo, int64_t hi)
+{
+    Table& table = *TblMgr().get_table(tid).value();
+
+    ScanCursor cursor;
+    cursor.next_key = lo;
+    cursor.hi = hi;
+
+    int64_t count = 0;
+    while (!cursor.done)
+    {
+        if (!table.scan(cursor, nullptr))
+            return -1;
+
+        count += cursor.records.size();
+    }
+
+    return count;
+}
+
+using RangeRead = int64_t (*)(int tid, int64_t lo, int64_t hi);
+
+bool run(int tid, int64_t num_keys, int64_t range, int num_ranges)
+{
+    const RangeRead methods[] = { find_range, scan_range,
+                                  find_range_unlocked, scan_range_unlocked };
+
+    double elapsed[4];
+    int64_t records[4] = { 0, 0, 0, 0 };
+
+    for (int method = 0; method < 4; ++method)
+    {
+        // the same ranges for all
+        std::mt19937_64 gen(1);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_ranges; ++i)
+        {
+            const int64_t lo = gen() % (num_keys - range);
+            const int64_t count = methods[method](tid, lo, lo + range - 1);
+            CHECK_FAILURE(count >= 0);
+
+            records[method] += count;
+        }
+
+        const std::chrono::duration<double, std::milli> time =
+            std::chrono::steady_clock::now() - start;
+        elapsed[method] = time.count();
+
+        CHECK_FAILURE(records[method] == records[0]);
+    }
+
+    std::printf("%8ld %10.1f %10.1f %8.1fx %10.1f %10.1f %8.1fx\n", range,
+                elapsed[0], elapsed[1], elapsed[0] / elapsed[1], elapsed[2],
+                elapsed[3], elapsed[2] / elapsed[3]);
+
+    return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int64_t num_keys = (argc > 1) ? std::atoll(argv[1]) : 1000000;
+    const int num_ranges = (argc > 2) ? std::atoi(argv[2]) : 200;
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    if (init_db(NUM_BUF, 0, 0, const_cast<char*>("bench.log"),
+                const_cast<char*>("bench_logmsg.txt")) != SUCCESS)
+        return 1;
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    if (tid <= 0)
+        return 1;
+
+    // every other key, so that half of the finds miss
+    char value[] = "value";
+    for (int64_t key = 0; key < num_keys; key += 2)
+    {
+        if (db_insert(tid, key, value) != SUCCESS)
+            return 1;
+    }
+
+    std::printf("%8s %10s %10s %9s %10s %10s %9s\n", "range", "find(ms)",
+                "scan(ms)", "speedup", "find-nl", "scan-nl", "speedup");
+
+    for (int64_t range : { 10, 100, 1000 })
+    {
+        if (!run(tid, num_keys, range, num_ranges))
+        {
+            std::fprintf(stderr, "failed to run the benchmark\n");
+            return 1;
+        }
+    }
+
+    if (shutdown_db() != SUCCESS)
+        return 1;
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
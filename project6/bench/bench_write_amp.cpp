@@ -0,0 +1,222 @@
+// write amplification of the b+ tree by split and merge policy: the bytes
+// written to the table file, from the evictions, the page cleaner and the
+// flush at shutdown, over the bytes of the records inserted or deleted.
+//
+// workloads
+//   append  : ascending keys inserted
+//   random  : after a preload of random keys, a random key inserted and a
+//             random one deleted, one after the other
+//   sliding : ascending keys inserted, the key a window behind deleted
+//
+// usage: bench_write_amp [operations]
+
+#include "bpt.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+// a pool much smaller than the table, so that pages are written back as
+// they are modified
+constexpr int NUM_BUF = 256;
+
+struct Policy final
+{
+    const char* name;
+    TreePolicy policy;
+};
+
+// bytes written by this process so far
+uint64_t written_bytes()
+{
+    std::ifstream io("/proc/self/io");
+
+    std::string field;
+    uint64_t value;
+    while (io >> field >> value)
+    {
+        if (field == "wchar:")
+            return value;
+    }
+
+    return 0;
+}
+
+class Workload final
+{
+ public:
+    Workload(int table_id, int num_operations)
+        : table_id_(table_id), num_operations_(num_operations)
+    {
+    }
+
+    bool insert(int64_t key)
+    {
+        return db_insert(table_id_, key, value_) == SUCCESS;
+    }
+
+    bool remove(int64_t key)
+    {
+        return db_delete(table_id_, key) == SUCCESS;
+    }
+
+    bool append()
+    {
+        for (int64_t key = 0; key < num_operations_; ++key)
+            CHECK_FAILURE(insert(key));
+
+        return true;
+    }
+
+    bool preload_random()
+    {
+        keys_.clear();
+        for (int i = 0; i < num_operations_ / 2; ++i)
+        {
+            const int64_t key = gen_();
+            if (insert(key))
+                keys_.push_back(key);
+        }
+
+        return true;
+    }
+
+    bool random()
+    {
+        for (int i = 0; i < num_operations_ / 2; ++i)
+        {
+            const int64_t key = gen_();
+            if (insert(key))
+                keys_.push_back(key);
+
+            const std::size_t victim = gen_() % keys_.size();
+            CHECK_FAILURE(remove(keys_[victim]));
+            keys_[victim] = keys_.back();
+            keys_.pop_back();
+        }
+
+        return true;
+    }
+
+    bool sliding()
+    {
+        const int64_t window = num_operations_ / 20;
+        for (int64_t key = 0; key < num_operations_ / 2; ++key)
+        {
+            CHECK_FAILURE(insert(key));
+            if (key >= window)
+                CHECK_FAILURE(remove(key - window));
+        }
+
+        return true;
+    }
+
+ private:
+    int table_id_;
+    int num_operations_;
+
+    char value_[PAGE_DATA_VALUE_SIZE] = "value";
+    std::mt19937_64 gen_{ 1 };
+    std::vector<int64_t> keys_;
+};
+
+bool run(const std::string& workload, const Policy& policy,
+         int num_operations)
+{
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    DBConfig config;
+    config.tree_policy = policy.policy;
+    CHECK_FAILURE(init_db(NUM_BUF, 0, 0, const_cast<char*>("bench.log"),
+                          const_cast<char*>("bench_logmsg.txt"),
+                          config) == SUCCESS);
+
+    const int tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    Workload ops(tid, num_operations);
+    if (workload == "random")
+    {
+        // the preload is written before the measurement
+        CHECK_FAILURE(ops.preload_random());
+        CHECK_FAILURE(close_table(tid) == SUCCESS);
+        CHECK_FAILURE(open_table(const_cast<char*>(TABLE_NAME)) == tid);
+    }
+
+    const uint64_t written_before = written_bytes();
+    const auto start = std::chrono::steady_clock::now();
+
+    if (workload == "append")
+        CHECK_FAILURE(ops.append());
+    if (workload == "random")
+        CHECK_FAILURE(ops.random());
+    if (workload == "sliding")
+        CHECK_FAILURE(ops.sliding());
+
+    const auto layout = TblMgr().get_table(tid).value()->leaf_layout();
+    CHECK_FAILURE(layout.has_value());
+
+    CHECK_FAILURE(close_table(tid) == SUCCESS);
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    const uint64_t written = written_bytes() - written_before;
+
+    CHECK_FAILURE(shutdown_db() == SUCCESS);
+
+    std::printf("%-8s %-16s %12lu %10.2f %8lu %10.1f\n", workload.c_str(),
+                policy.name, written / PAGE_SIZE,
+                static_cast<double>(written) /
+                    (static_cast<double>(num_operations) *
+                     sizeof(page_data_t)),
+                layout->num_leaves, elapsed.count());
+
+    return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_operations = (argc > 1) ? std::atoi(argv[1]) : 100000;
+
+    const std::vector<Policy> policies{
+        { "default", { 0, 0, 0.5 } },
+        { "fill-90", { 0, 0, 0.9 } },
+        { "merge-25", { 0.25, 0, 0.5 } },
+        { "merge-25,bias-25", { 0.25, 0.25, 0.5 } },
+    };
+
+    std::printf("%-8s %-16s %12s %10s %8s %10s\n", "workload", "policy",
+                "pages", "write-amp", "leaves", "time(ms)");
+
+    for (const char* workload : { "append", "random", "sliding" })
+    {
+        for (const auto& policy : policies)
+        {
+            if (!run(workload, policy, num_operations))
+            {
+                std::fprintf(stderr, "failed to run the benchmark\n");
+                return 1;
+            }
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+// writing random keys by batch size: one db_insert per record against
+// db_insert_batch into a table filled up to half, and one db_update per
+// record against db_update_batch, each batch of updates in a transaction.
+// the log bytes are those appended per update.
+//
+// usage: bench_write_batch [keys] [records]
+
+#include "common.h"
+#include "dbapi.h"
+#include "file.h"
+#include "log.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr const char* TABLE_NAME = "DATA1";
+constexpr int NUM_BUF = 4096;
+
+struct Result final
+{
+    double records_per_sec;
+    double log_bytes;
+};
+
+bool write_batch(int tid, const std::vector<int64_t>& keys, char** values,
+                 bool update, bool batched)
+{
+    const int num_records = keys.size();
+
+    if (!update)
+    {
+        if (batched)
+        {
+            return db_insert_batch(tid, keys.data(), values, num_records,
+                                   nullptr) == SUCCESS;
+        }
+
+        // the keys already in the table are not inserted again
+        for (int i = 0; i < num_records; ++i)
+            db_insert(tid, keys[i], values[i]);
+
+        return true;
+    }
+
+    const int trx_id = trx_begin();
+    CHECK_FAILURE(trx_id != 0);
+
+    if (batched)
+    {
+        CHECK_FAILURE(db_update_batch(tid, keys.data(), values, num_records,
+                                      nullptr, trx_id) == SUCCESS);
+    }
+    else
+    {
+        for (int i = 0; i < num_records; ++i)
+            CHECK_FAILURE(db_update(tid, keys[i], values[i], trx_id) ==
+                          SUCCESS);
+    }
+
+    return trx_commit(trx_id) == trx_id;
+}
+
+bool measure(int tid, int64_t num_keys, int batch_size, int num_records,
+             bool update, bool batched, Result& result)
+{
+    // the same keys for both, odd ones for the inserts
+    std::mt19937_64 gen(batch_size);
+
+    std::vector<int64_t> keys(batch_size);
+    std::vector<std::string> values(batch_size, "value");
+    std::vector<char*> pointers;
+    for (auto& value : values)
+        pointers.push_back(value.data());
+
+    const lsn_t first_lsn = LogMgr().next_lsn();
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int done = 0; done < num_records; done += batch_size)
+    {
+        for (auto& key : keys)
+            key = (gen() % (num_keys / 2)) * 2 + !update;
+
+        CHECK_FAILURE(
+            write_batch(tid, keys, pointers.data(), update, batched));
+    }
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    result.records_per_sec = num_records / elapsed.count();
+    result.log_bytes =
+        static_cast<double>(LogMgr().next_lsn() - first_lsn) / num_records;
+
+    return true;
+}
+
+// a fresh table of the even keys
+bool fill_table(int64_t num_keys, int& tid)
+{
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+
+    CHECK_FAILURE(init_db(NUM_BUF, 0, 0, const_cast<char*>("bench.log"),
+                          const_cast<char*>("bench_logmsg.txt")) == SUCCESS);
+
+    tid = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(tid > 0);
+
+    char value[] = "value";
+    for (int64_t key = 0; key < num_keys; key += 2)
+        CHECK_FAILURE(db_insert(tid, key, value) == SUCCESS);
+
+    return true;
+}
+
+// the inserts go to a fresh table each, the updates to the second one
+bool run(int64_t num_keys, int batch_size, int num_records)
+{
+    Result results[4];
+    int tid;
+
+    CHECK_FAILURE(fill_table(num_keys, tid));
+    CHECK_FAILURE(measure(tid, num_keys, batch_size, num_records, false,
+                          false, results[0]));
+    CHECK_FAILURE(shutdown_db() == SUCCESS);
+
+    CHECK_FAILURE(fill_table(num_keys, tid));
+    CHECK_FAILURE(measure(tid, num_keys, batch_size, num_records, false,
+                          true, results[1]));
+    CHECK_FAILURE(measure(tid, num_keys, batch_size, num_records, true,
+                          false, results[2]));
+    CHECK_FAILURE(measure(tid, num_keys, batch_size, num_records, true,
+                          true, results[3]));
+    CHECK_FAILURE(shutdown_db() == SUCCESS);
+
+    std::printf("%6d %12.0f %12.0f %7.2fx %12.0f %12.0f %7.2fx %8.1f\n",
+                batch_size, results[0].records_per_sec,
+                results[1].records_per_sec,
+                results[1].records_per_sec / results[0].records_per_sec,
+                results[2].records_per_sec, results[3].records_per_sec,
+                results[3].records_per_sec / results[2].records_per_sec,
+                results[3].log_bytes);
+
+    return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int64_t num_keys = (argc > 1) ? std::atoll(argv[1]) : 400000;
+    const int num_records = (argc > 2) ? std::atoi(argv[2]) : 20000;
+
+    std::printf("%6s %12s %12s %8s %12s %12s %8s %8s\n", "batch",
+                "insert/s", "batch/s", "speedup", "update/s", "batch/s",
+                "speedup", "log/rec");
+
+    for (int batch_size : { 10, 100, 1000 })
+    {
+        if (!run(num_keys, batch_size, num_records))
+        {
+            std::fprintf(stderr, "failed to run the benchmark\n");
+            return 1;
+        }
+    }
+
+    unlink(TABLE_NAME);
+    unlink("bench.log");
+    unlink("bench_logmsg.txt");
+
+    return 0;
+}
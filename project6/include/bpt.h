@@ -1,26 +1,69 @@
 #ifndef BPT_H_
 #define BPT_H_
 
+#include "config.h"
 #include "page.h"
 #include "table.h"
 #include "xact.h"
 
+#include <functional>
 #include <optional>
 #include <string>
 #include <vector>
 
+// how the leaves are placed in the file, taken in key order
+struct LeafLayout final
+{
+    uint64_t num_leaves{ 0 };
+    // leaves followed in the file by their right sibling
+    uint64_t sequential{ 0 };
+    // leaves whose right sibling is placed before them
+    uint64_t backward{ 0 };
+    // sum of the distances in pages from the leaves to their right siblings
+    uint64_t total_distance{ 0 };
+
+    // share of the right siblings not following their leaf, 0 when the
+    // leaves are in key order in the file
+    [[nodiscard]] double fragmentation() const;
+};
+
+// what a batch of BPTree::compact() has done
+struct CompactionStats final
+{
+    // leaves merged into their left sibling, whose pages are free now
+    uint64_t merged_leaves{ 0 };
+    // nodes moved to a free page before them
+    uint64_t moved_pages{ 0 };
+    // free pages cut off the end of the file
+    uint64_t truncated_pages{ 0 };
+    // the table is compacted, the next batch starts over
+    bool done{ false };
+
+    // bytes returned to the file system
+    [[nodiscard]] uint64_t reclaimed_bytes() const;
+
+    CompactionStats& operator+=(const CompactionStats& other);
+};
+
 class BPTree
 {
  public:
     static constexpr int INTERNAL_ORDER = PAGE_BRANCHES_IN_PAGE + 1;
     static constexpr int LEAF_ORDER = PAGE_DATA_IN_PAGE + 1;
 
-    static constexpr int MERGE_THRESHOLD = 0;
+    // neighbouring leaves are merged by compact() when their records fit
+    // in this many, the rest of the leaf is left for inserts
+    static constexpr int COMPACTION_LEAF_FILL = (LEAF_ORDER - 1) * 3 / 4;
+
+    // optimistic traversals restarted this often fall back to the tree latch
+    static constexpr int MAX_OPTIMISTIC_RETRIES = 16;
 
  public:
-    [[nodiscard]] static bool initialize(int num_buf);
+    [[nodiscard]] static bool initialize(int num_buf,
+                                         const DBConfig& config);
     [[nodiscard]] static bool shutdown();
 
+    // the table is opened with DBConfig::tree_policy
     [[nodiscard]] static bool open_table(Table& table);
     [[nodiscard]] static bool close_table(Table& table);
 
@@ -32,14 +75,126 @@ class BPTree
     [[nodiscard]] static bool update(Table& table, int64_t key,
                                      const char* value, Xact* xact = nullptr);
 
+    // fails when a share of the policy is out of its range
+    [[nodiscard]] static bool set_policy(Table& table,
+                                         const TreePolicy& policy);
+
+    // walks the leaves along the sibling chain
+    [[nodiscard]] static std::optional<LeafLayout> leaf_layout(Table& table);
+
+    // runs a batch of the online compaction of the table, which holds the
+    // tree latch for at most max_pages leaves visited and pages merged or
+    // moved. the leaves are merged with their right sibling when both fit
+    // in COMPACTION_LEAF_FILL records and moved into key order, then the
+    // nodes at the end of the file are moved before it and the free pages
+    // after them cut off. the batch does nothing while a transaction is
+    // active, as records are locked by their page and slot.
+    [[nodiscard]] static std::optional<CompactionStats> compact(
+        Table& table, int max_pages);
+
+    // fills the cursor with the records in range of the next leaves, up to
+    // the first one holding any, and none once the scan is done. the
+    // records are locked shared by the transaction, if any, as they are
+    // copied. fails when it is aborted on a deadlock.
+    [[nodiscard]] static bool scan(Table& table, ScanCursor& cursor,
+                                   Xact* xact = nullptr);
+
+    // looks the keys up in one descent, in key order. a node is pinned
+    // once for the keys passing through it and a leaf once for the keys in
+    // it. records[i] is the record of keys[i], if any. the records are
+    // locked shared by the transaction, if any. fails when it is aborted on
+    // a deadlock.
+    [[nodiscard]] static bool find_many(
+        Table& table, const std::vector<int64_t>& keys,
+        std::vector<std::optional<page_data_t>>& records,
+        Xact* xact = nullptr);
+
+    // inserts the records in key order, a group per leaf under one pin and
+    // latch. the record splitting its leaf is inserted alone, as by
+    // insert(). inserted[i] is whether records[i] is, it is not when its
+    // key is already in the table or given before.
+    [[nodiscard]] static bool insert_many(
+        Table& table, const std::vector<page_data_t>& records,
+        std::vector<bool>& inserted);
+    // updates the records in key order, a group per leaf under one pin and
+    // latch, whose locks are taken in one round trip to the lock manager and
+    // whose update records are logged together. updated[i] is whether the
+    // key of records[i] is found. fails when the transaction is aborted on a
+    // deadlock.
+    [[nodiscard]] static bool update_many(
+        Table& table, const std::vector<page_data_t>& records,
+        std::vector<bool>& updated, Xact* xact);
+
+    // builds the tree of an empty table from the records next() gives
+    // until it returns false, in increasing key order, see BulkLoader.
+    // the number of records is returned, and nullopt when the table is not
+    // empty or a key is out of order, the table is left empty then.
+    [[nodiscard]] static std::optional<uint64_t> bulk_load(
+        Table& table, const std::function<bool(page_data_t&)>& next,
+        double fill_factor);
+
  private:
-    [[nodiscard]] static pagenum_t make_node(Table& table, bool is_leaf);
+    // near is the node the new one is split off, see split_placement
+    [[nodiscard]] static pagenum_t make_node(Table& table, bool is_leaf,
+                                             pagenum_t near = NULL_PAGE_NUM);
     [[nodiscard]] static pagenum_t find_leaf(Table& table, int64_t key);
+    [[nodiscard]] static pagenum_t find_leftmost_leaf(Table& table);
+    // the traversal of a read only table, without the buffer and latches
+    [[nodiscard]] static const page_t* find_leaf(const MappedFile& file,
+                                                 int64_t key);
+    [[nodiscard]] static bool scan_mapped(const MappedFile& file,
+                                          ScanCursor& cursor);
+
+    // the keys of a batch in key order, and where its descent stopped
+    struct KeyBatch;
+    struct FindMany;
+    struct WriteMany;
+    // calls func(leaf, first, last) for each leaf under the root holding the
+    // keys in [first, last) of the order of the batch from resolved on,
+    // latched with the given mode, until the batch is stopped. the inner
+    // nodes are pinned once for the keys passing through them. the caller
+    // holds the tree latch.
+    template <typename Batch, typename Function>
+    [[nodiscard]] static bool for_each_leaf(Table& table, Batch& batch,
+                                            PageLatch latch, Function&& func);
+    template <typename Batch, typename Function>
+    [[nodiscard]] static bool for_each_leaf(Table& table, pagenum_t node,
+                                            int depth, Batch& batch,
+                                            std::size_t first,
+                                            std::size_t last, PageLatch latch,
+                                            Function&& func);
+    static void find_in_leaf(Table& table, Page& leaf, FindMany& batch,
+                             std::size_t first, std::size_t last);
+    static void update_in_leaf(Table& table, Page& leaf, WriteMany& batch,
+                               std::size_t first, std::size_t last);
+    [[nodiscard]] static std::optional<page_data_t> find_mapped(
+        const MappedFile& file, int64_t key);
+    [[nodiscard]] static std::optional<pagenum_t> find_leaf_optimistic(
+        Table& table, int64_t key, version_t tree_version);
+
+    // calls func with the leaf that may hold the key, latched with the given
+    // mode. returns false when the tree is empty.
+    template <typename Function>
+    [[nodiscard]] static bool with_leaf(Table& table, int64_t key,
+                                        PageLatch latch, Function&& func);
     [[nodiscard]] static int path_to_root(Table& table, pagenum_t child);
 
+    // most keys a node is merged or redistributed with, see TreePolicy
+    [[nodiscard]] static int merge_threshold(const Table& table,
+                                             bool is_leaf);
+    // entries kept by the left node of a split of length entries, within
+    // [min, max]
+    [[nodiscard]] static int split_pivot(const Table& table, int length,
+                                         int min, int max);
+
     // insert operation helper methods
+    // returns std::nullopt when the leaf has to be split
+    [[nodiscard]] static std::optional<bool> try_insert_into_leaf(
+        Table& table, const page_data_t& record);
     [[nodiscard]] static bool insert_into_leaf(Table& table, pagenum_t leaf,
                                                const page_data_t& record);
+    [[nodiscard]] static bool insert_into_leaf(Page& leaf,
+                                               const page_data_t& record);
     [[nodiscard]] static bool insert_into_parent(Table& table, pagenum_t left,
                                                  pagenum_t right, int64_t key);
     [[nodiscard]] static bool insert_into_new_root(Table& table, pagenum_t left,
@@ -57,6 +212,9 @@ class BPTree
                                                                int64_t key);
 
     // delete operation helper methods
+    // returns std::nullopt when the leaf may have to be merged
+    [[nodiscard]] static std::optional<bool> try_remove_from_leaf(
+        Table& table, int64_t key);
     [[nodiscard]] static bool delete_entry(Table& table, pagenum_t node,
                                            int64_t key);
     static void remove_branch_from_internal(Page& node, int64_t key);
@@ -76,6 +234,30 @@ class BPTree
     [[nodiscard]] static bool redistribute_nodes_to_right(
         Table& table, Page& parent, Page& left, Page& right, int k_prime_index,
         int64_t k_prime);
+
+    // compaction helper methods
+    [[nodiscard]] static bool compact_leaves(Table& table,
+                                             CompactionCursor& cursor,
+                                             int& budget,
+                                             CompactionStats& stats);
+    [[nodiscard]] static bool compact_nodes(Table& table,
+                                            CompactionCursor& cursor,
+                                            int& budget,
+                                            CompactionStats& stats);
+    // merges the right sibling into the leaf when they share the parent and
+    // fit in COMPACTION_LEAF_FILL records
+    [[nodiscard]] static bool try_merge_leaf(Table& table, pagenum_t leaf,
+                                             bool& merged);
+    // moves the node to the first free page in [first, node) and points its
+    // parent, children or left sibling to it. to is NULL_PAGE_NUM when no
+    // page is free there.
+    [[nodiscard]] static bool move_node(Table& table, pagenum_t node,
+                                        pagenum_t first, pagenum_t& to);
+
+ private:
+    inline static TreePolicy tree_policy_;
+    inline static bool optimistic_reads_{ true };
+    inline static bool split_placement_{ true };
 };
 
 #endif  // BPT_H_
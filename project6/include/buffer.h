@@ -2,22 +2,45 @@
 #define BUFFER_H_
 
 #include "common.h"
+#include "config.h"
 #include "file.h"
+#include "frame_arena.h"
+#include "latch.h"
 #include "page.h"
+#include "page_table.h"
+#include "replacer.h"
 #include "table.h"
 
 #include <atomic>
+#include <chrono>
+#include <array>
+#include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <thread>
 #include <type_traits>
-#include <unordered_map>
+#include <vector>
 
-class BufferBlock final
+class BufferPartition;
+
+// the descriptors of a partition sit in one array, every one on its own
+// cache lines so that pinning a frame does not contend with its neighbours
+class alignas(64) BufferBlock final
 {
  public:
-    void lock(bool lock);
-    void unlock();
+    // TwoQReplacer queue tags
+    static constexpr int QUEUE_NONE = 0;
+    static constexpr int QUEUE_A1IN = 1;
+    static constexpr int QUEUE_AM = 2;
+
+ public:
+    // the block must be pinned by get_block() before it is latched
+    void lock(PageLatch latch);
+    // releases the latch and the pin
+    void unlock(PageLatch latch);
 
     [[nodiscard]] page_t& frame();
 
@@ -34,6 +57,7 @@ class BufferBlock final
 
  private:
     void clear();
+    void pin();
     int pin_count() const;
 
  private:
@@ -41,58 +65,283 @@ class BufferBlock final
     table_id_t table_id_{ -1 };
     pagenum_t pagenum_{ NULL_PAGE_NUM };
 
-    bool is_dirty_{ false };
+    std::atomic<bool> is_dirty_{ false };
     std::atomic<int> pin_count_{ 0 };
-    std::mutex mutex_;
+    std::shared_mutex latch_;
+    SeqVersion version_;
 
+    // set while the frame is read or written back without the partition
+    // latch. guarded by the partition latch, waiters sleep on cond_.
+    bool io_in_progress_{ false };
+    std::condition_variable cond_;
+
+    BufferPartition* partition_{ nullptr };
+
+    // replacement policy state, see replacer.h
     BufferBlock* prev_{ nullptr };
     BufferBlock* next_{ nullptr };
+    std::atomic<bool> referenced_{ false };
+    int queue_{ QUEUE_NONE };
 
+    // loaded by a prefetch and not requested since. guarded by the
+    // partition latch.
+    bool read_ahead_{ false };
+
+    friend class Page;
+    friend class BufferPartition;
     friend class BufferManager;
+    friend class BlockList;
+    friend class LRUReplacer;
+    friend class ClockReplacer;
+    friend class TwoQReplacer;
+    // sets the page and the pins of blocks without a partition,
+    // see unittest/unittest_replacer.cpp
+    friend class ReplacerTestAccess;
+};
+
+struct BufferStats final
+{
+    uint64_t hits{ 0 };
+    uint64_t misses{ 0 };
+    uint64_t evictions{ 0 };
+    // dirty victims written back by the thread that missed
+    uint64_t writebacks{ 0 };
+    // pages written ahead of eviction by the page cleaner
+    uint64_t cleaned{ 0 };
+    // pages read ahead by a prefetch
+    uint64_t prefetched{ 0 };
+};
+
+// a slice of the buffer pool. every partition has its own latch, page table
+// and replacement list, so a miss in one partition never blocks a hit in
+// another.
+class BufferPartition final
+{
+ public:
+    // how long a miss waits for a frame when every frame is pinned
+    static constexpr std::chrono::seconds MAX_EVICTION_WAIT{ 5 };
+
+ public:
+    BufferPartition() = default;
+    BufferPartition(const BufferPartition&) = delete;
+    BufferPartition& operator=(const BufferPartition&) = delete;
+
+    [[nodiscard]] bool init_frames(page_t* frames, int num_frames,
+                                   ReplacementPolicy policy);
+    [[nodiscard]] bool shutdown_frames();
+
+    [[nodiscard]] bool close_table(table_id_t table_id);
+    // drops the frames of the table's pages in [first, end) without writing
+    // them back, they are free pages cut off the file or overwritten on disk
+    [[nodiscard]] bool drop_pages(table_id_t table_id, pagenum_t first,
+                                  pagenum_t end);
+
+    // pins the unpinned dirty frames of the table, or of every table when
+    // table_id is -1, and marks them clean and in i/o for a batch write-back.
+    // page_lsn is raised to the latest page LSN among them.
+    void begin_flush(table_id_t table_id, std::vector<BufferBlock*>& blocks,
+                     lsn_t& page_lsn);
+    // releases a block of begin_flush(), dirty again when it was not written
+    void end_flush(BufferBlock* block, bool written);
+    // writes back the dirty frames a batch left out, of the table or of
+    // every table when table_id is -1. waits for the pinned ones and the
+    // ones in i/o.
+    [[nodiscard]] bool write_back_table(table_id_t table_id);
+
+    // returns the pinned block holding the page. the page latch is taken by
+    // the caller after the partition latch is released.
+    // read_ahead is set when the page was read for this request, or read
+    // ahead and requested for the first time.
+    [[nodiscard]] BufferBlock* get_block(Table& table, pagenum_t pagenum,
+                                         bool& read_ahead);
+
+    // reads the page into an unpinned frame, unless it is cached already.
+    // never waits for a frame. next_leaf is the right sibling of the page if
+    // it is a leaf, and NULL_PAGE_NUM otherwise.
+    [[nodiscard]] bool prefetch_block(Table& table, pagenum_t pagenum,
+                                      pagenum_t& next_leaf);
+
+    // writes back the coldest dirty, unpinned frames. returns the number of
+    // written pages.
+    std::size_t clean(double dirty_ratio, std::size_t max_pages);
+
+    void add_stats(BufferStats& stats);
+    void reset_stats();
+
+    // called by BufferBlock when its last pin is released
+    void notify_unpinned();
+
+ private:
+    [[nodiscard]] BufferBlock* find_victim();
+    [[nodiscard]] BufferBlock* eviction(BufferBlock* block);
+
+    // maps the page to the victim and reads it without the partition latch.
+    // the victim is left pinned.
+    [[nodiscard]] bool read_page(std::unique_lock<std::mutex>& lock,
+                                 BufferBlock* victim, Table& table,
+                                 pagenum_t pagenum);
+
+    [[nodiscard]] bool write_back(std::unique_lock<std::mutex>& lock,
+                                  BufferBlock* block);
+    void wait_unpinned(std::unique_lock<std::mutex>& lock,
+                       BufferBlock* block);
+    [[nodiscard]] bool wait_any_unpinned(
+        std::unique_lock<std::mutex>& lock,
+        std::chrono::steady_clock::time_point deadline);
+
+    template <typename Pred>
+    [[nodiscard]] bool drop_blocks(std::unique_lock<std::mutex>& lock,
+                                   Pred&& pred, bool write_back = true);
+
+    [[nodiscard]] bool flush_block(BufferBlock* block);
+    [[nodiscard]] bool clear_block(BufferBlock* block);
+
+ private:
+    std::mutex mutex_;
+
+    std::vector<BufferBlock> blocks_;
+    std::vector<BufferBlock*> free_blocks_;
+    std::unique_ptr<Replacer> replacer_;
+
+    PageTable block_tbl_;
+
+    // threads sleeping until a frame of this partition is unpinned
+    std::atomic<int> waiters_{ 0 };
+    std::condition_variable unpin_cond_;
+
+    BufferStats stats_;
 };
 
 class BufferManager final
 {
  public:
-    [[nodiscard]] static bool initialize(int num_buf);
+    static constexpr int MIN_FRAMES_PER_PARTITION = 64;
+
+    // prefetch requests beyond this are dropped
+    static constexpr std::size_t MAX_PREFETCH_QUEUE = 4096;
+    // consecutive pages read before the read-ahead starts
+    static constexpr int READ_AHEAD_TRIGGER = 4;
+    // farthest a page created near another one is placed from it
+    static constexpr uint64_t PLACEMENT_DISTANCE = 64;
+
+ public:
+    [[nodiscard]] static bool initialize(int num_buf, const DBConfig& config);
     [[nodiscard]] static bool shutdown();
 
     [[nodiscard]] static BufferManager& get_instance();
 
+    // every dirty frame is written to its table file when it returns true,
+    // the pinned ones once they are unpinned. the caller must not hold a
+    // pin. the files are not synced.
     [[nodiscard]] bool sync_all();
 
     [[nodiscard]] bool open_table(Table& table);
     [[nodiscard]] bool close_table(Table& table);
 
+    // near is a page the new one should be placed close to, it is taken
+    // from the free pages within PLACEMENT_DISTANCE of it when there are
     [[nodiscard]] bool create_page(Table& table, bool is_leaf,
-                                   pagenum_t& pagenum);
+                                   pagenum_t& pagenum,
+                                   pagenum_t near = NULL_PAGE_NUM);
     [[nodiscard]] bool free_page(Table& table, pagenum_t pagenum);
+    // copies the page to the first free page in [first, from) and frees it.
+    // to is NULL_PAGE_NUM when no page is free there.
+    [[nodiscard]] bool move_page(Table& table, pagenum_t from, pagenum_t first,
+                                 pagenum_t& to);
+    // cuts the free pages off the end of the table file, and the bitmap
+    // pages of them. num_pages is set to the number of pages cut off.
+    [[nodiscard]] bool trim_file(Table& table, uint64_t& num_pages);
+    // takes count consecutive free pages, growing the file when none are,
+    // for pages written to the file around the pool. the frames left of
+    // them are dropped.
+    [[nodiscard]] bool allocate_run(Table& table, uint64_t count,
+                                    pagenum_t& first);
 
     [[nodiscard]] bool get_page(Table& table, pagenum_t pagenum,
-                                std::optional<Page>& page, bool page_lock);
+                                std::optional<Page>& page, PageLatch latch);
+
+    // reads the pages in the background without pinning them. cached pages
+    // keep their place in the replacement order.
+    void prefetch(Table& table, pagenum_t pagenum);
+    void prefetch(Table& table, const std::vector<pagenum_t>& pagenums);
+    // reads the leaf and at most depth - 1 of its right siblings
+    void prefetch_siblings(Table& table, pagenum_t leaf, int depth);
+
+    [[nodiscard]] int num_partitions() const;
+
+    [[nodiscard]] BufferStats stats();
+    void reset_stats();
 
  private:
     BufferManager() = default;
-    [[nodiscard]] bool init_lru(int num_buf);
-    [[nodiscard]] bool shutdown_lru();
+    [[nodiscard]] bool init_partitions(int num_buf, const DBConfig& config);
+    [[nodiscard]] bool shutdown_partitions();
 
-    void enqueue(BufferBlock* block);
-    void unlink_and_enqueue(BufferBlock* block);
+    [[nodiscard]] BufferPartition& partition(table_id_t table_id,
+                                             pagenum_t pagenum);
 
-    [[nodiscard]] BufferBlock* eviction();
-    [[nodiscard]] BufferBlock* eviction(BufferBlock* block);
+    void cleaner_main(DBConfig config);
+    void stop_cleaner();
 
-    [[nodiscard]] bool clear_block(BufferBlock* block);
+    // writes back the dirty pages of the table, or of every table when
+    // table_id is -1, with one batch of vectored writes per table
+    [[nodiscard]] bool flush_batch(table_id_t table_id);
+
+    // copies the free bits of the pages from the table's FreeSpaceMap to
+    // the header page and the bitmap pages holding them
+    [[nodiscard]] bool store_free_bits(Table& table, Page& header,
+                                       pagenum_t first, uint64_t count);
+
+    struct PrefetchRequest final
+    {
+        Table* table;
+        pagenum_t pagenum;
+        // number of leaves read along the sibling chain
+        int depth;
+    };
+
+    // sequential access of a table, seen on its reads
+    struct ReadAhead final
+    {
+        pagenum_t last_pagenum{ NULL_PAGE_NUM };
+        int run{ 0 };
+        pagenum_t ahead_until{ NULL_PAGE_NUM };
+
+        pagenum_t next_leaf{ NULL_PAGE_NUM };
+        int leaf_run{ 0 };
+        int leaves_ahead{ 0 };
+    };
+
+    void enqueue_prefetch(const PrefetchRequest& request);
+    void prefetcher_main();
+    void stop_prefetcher();
+    // drops the queued requests of the table and waits for the running one
+    void cancel_prefetch(Table& table);
+
+    // starts a read-ahead along the file or the sibling chain when the
+    // table is read sequentially
+    void detect_sequential(Table& table, Page& page, PageLatch latch);
 
  private:
-    std::mutex mutex_;
+    FrameArena frame_arena_;
+
+    std::vector<std::unique_ptr<BufferPartition>> partitions_;
 
-    BufferBlock* head_{ nullptr };
-    BufferBlock* tail_{ nullptr };
+    std::thread cleaner_;
+    std::mutex cleaner_mutex_;
+    std::condition_variable cleaner_cond_;
+    bool stop_cleaner_{ false };
 
-    page_t* page_arr_{ nullptr };
+    std::thread prefetcher_;
+    std::mutex prefetch_mutex_;
+    std::condition_variable prefetch_cond_;
+    std::deque<PrefetchRequest> prefetch_queue_;
+    Table* prefetching_{ nullptr };
+    bool stop_prefetcher_{ false };
 
-    std::unordered_map<table_page_t, BufferBlock*> block_tbl_;
+    int read_ahead_pages_{ 0 };
+    std::mutex read_ahead_mutex_;
+    std::array<ReadAhead, TableManager::MAX_TABLE_COUNT + 1> read_ahead_;
 
     inline static BufferManager* instance_{ nullptr };
 };
@@ -104,10 +353,11 @@ inline BufferManager& BufMgr()
 
 template <typename Function>
 [[nodiscard]] bool buffer(Function&& func, Table& table,
-                          pagenum_t pagenum = NULL_PAGE_NUM, bool page_lock = true)
+                          pagenum_t pagenum = NULL_PAGE_NUM,
+                          PageLatch latch = PageLatch::EXCLUSIVE)
 {
     std::optional<Page> opt;
-    CHECK_FAILURE(BufMgr().get_page(table, pagenum, opt, page_lock));
+    CHECK_FAILURE(BufMgr().get_page(table, pagenum, opt, latch));
 
     if constexpr (std::is_void<decltype(func(opt.value()))>::value)
     {
@@ -0,0 +1,98 @@
+#ifndef BULK_LOAD_H_
+#define BULK_LOAD_H_
+
+#include "file.h"
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class Table;
+
+// builds the b+ tree of an empty table bottom-up from records in
+// increasing key order. the nodes are filled to the fill factor and
+// written to the file around the buffer pool, the leaves and the inner
+// nodes each in runs of consecutive pages, so that the leaves are in key
+// order. the caller holds the tree latch of the table.
+class BulkLoader final
+{
+ public:
+    // pages taken from the free space at once
+    static constexpr uint64_t RUN_PAGES = 64;
+    // pages written to the file at once
+    static constexpr std::size_t WRITE_BATCH = 256;
+
+ public:
+    // fill_factor is the share of a node filled, in (0, 1]. an inner node
+    // keeps a slot for the last child of its level.
+    BulkLoader(Table& table, double fill_factor);
+
+    // fails when the key is not greater than the previous one
+    [[nodiscard]] bool add(const page_data_t& record);
+    // writes the nodes left, root() is the root of the tree then
+    [[nodiscard]] bool finish();
+    // frees the pages taken, after add() or finish() has failed
+    [[nodiscard]] bool abort();
+
+    [[nodiscard]] uint64_t num_records() const;
+    // NULL_PAGE_NUM when there was no record
+    [[nodiscard]] pagenum_t root() const;
+
+ private:
+    struct Node final
+    {
+        std::unique_ptr<page_t> page;
+        pagenum_t pagenum{ NULL_PAGE_NUM };
+        int64_t first_key{ 0 };
+    };
+
+    // the node being filled, and the last one closed, which is given a
+    // parent once the next one is closed. a new parent is opened only for
+    // a child which is not the last, so that it gets two children at least.
+    struct Level final
+    {
+        Node open;
+        Node pending;
+        uint64_t num_nodes{ 0 };
+    };
+
+    struct PageRun final
+    {
+        pagenum_t next{ NULL_PAGE_NUM };
+        uint64_t left{ 0 };
+    };
+
+    [[nodiscard]] bool open_node(Node& node, bool is_leaf);
+    [[nodiscard]] bool close_node(std::size_t level, Node& node);
+    // puts the node into a parent on the level above, and writes it
+    [[nodiscard]] bool place(std::size_t level, Node& node, bool last);
+
+    [[nodiscard]] bool write(Node& node);
+    [[nodiscard]] bool flush();
+
+ private:
+    Table& table_;
+    int leaf_fill_;
+    int internal_fill_;
+
+    // levels_[0] is the leaves. a level added above keeps the references
+    // to the others valid.
+    std::deque<Level> levels_;
+    uint64_t num_records_{ 0 };
+    int64_t last_key_{ 0 };
+    pagenum_t root_{ NULL_PAGE_NUM };
+
+    PageRun leaf_pages_;
+    PageRun internal_pages_;
+    // runs of pages taken, as first page and count
+    std::vector<std::pair<pagenum_t, uint64_t>> runs_;
+
+    std::vector<std::unique_ptr<page_t>> pending_writes_;
+    std::vector<PageWrite> writes_;
+};
+
+#endif  // BULK_LOAD_H_
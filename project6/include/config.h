@@ -0,0 +1,103 @@
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+enum class ReplacementPolicy
+{
+    LRU,
+    CLOCK,
+    TWO_Q
+};
+
+enum class IOBackendType
+{
+    PREAD,
+    IO_URING,
+    THREAD_POOL
+};
+
+enum class NumaPolicy
+{
+    NONE,
+    INTERLEAVE,
+    BIND
+};
+
+// how the b+ tree of a table splits and merges its nodes
+struct TreePolicy final
+{
+    // a node is merged with a neighbour, or takes an entry from it, once a
+    // delete leaves it with at most this share of its capacity. 0 waits
+    // until it is empty. below 0.5.
+    double merge_threshold{ 0 };
+    // share of the capacity a merged node must leave free, otherwise an
+    // entry is moved from the neighbour instead, so that a merged node is
+    // not split again by the next few inserts.
+    double redistribution_bias{ 0 };
+    // share of the entries kept by the left node of a split. 0.9 suits
+    // increasing keys, as nothing is inserted into the left node again.
+    double split_fill{ 0.5 };
+};
+
+struct DBConfig final
+{
+    // number of independently latched buffer pool partitions.
+    // 0 means choosing it from the number of frames.
+    int buffer_partitions{ 0 };
+
+    ReplacementPolicy replacement_policy{ ReplacementPolicy::LRU };
+
+    // background page cleaner, disabled when the interval is 0.
+    // every round it writes back the dirty frames close to eviction, and
+    // keeps going while more than cleaner_dirty_ratio of a partition is
+    // dirty, at most cleaner_batch_pages pages per partition.
+    int cleaner_interval_ms{ 50 };
+    double cleaner_dirty_ratio{ 0.1 };
+    int cleaner_batch_pages{ 32 };
+
+    // find and update descend the tree without latching the inner pages,
+    // validating page versions instead. disabled, they hold the tree latch.
+    bool optimistic_reads{ true };
+
+    // the keys of a node are searched with the vector instructions the cpu
+    // supports, see key_search. disabled, by a binary search only.
+    bool simd_search{ true };
+
+    // the policy of every table opened, see db_set_tree_policy()
+    TreePolicy tree_policy;
+
+    // the page split off a b+ tree node is placed close after the node in
+    // the file when a page is free there, so that the leaves are read along
+    // the file in key order. disabled, it is taken like any new page.
+    bool split_placement{ true };
+
+    // pages read ahead once a table is read along the file or along the
+    // leaf sibling chain. 0 disables the read-ahead, explicit prefetches
+    // still work.
+    int read_ahead_pages{ 32 };
+
+    // how the table files are read and written. IO_URING falls back to
+    // THREAD_POOL when the kernel does not allow io_uring.
+    IOBackendType io_backend{ IOBackendType::PREAD };
+    // requests in flight at once for IO_URING, threads for THREAD_POOL
+    int io_queue_depth{ 64 };
+
+    // the table files are opened O_DIRECT, so that pages are cached by the
+    // buffer pool only and not again by the kernel. falls back to buffered
+    // i/o on a file system without O_DIRECT.
+    bool direct_io{ false };
+
+    // pages a table file grows by when no page is free. 0 grows it by an
+    // eighth of its size, within File::MIN_EXTENT_PAGES and MAX_EXTENT_PAGES.
+    int file_extent_pages{ 0 };
+
+    // the frames are mapped with 2MB huge pages when enough are reserved,
+    // and with transparent huge pages advised otherwise.
+    bool huge_pages{ true };
+
+    // placement of the frames across NUMA nodes. INTERLEAVE spreads them
+    // over every online node, BIND places them on numa_node only.
+    NumaPolicy numa_policy{ NumaPolicy::NONE };
+    int numa_node{ 0 };
+};
+
+#endif  // CONFIG_H_
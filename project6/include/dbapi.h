@@ -1,19 +1,65 @@
 #ifndef DBAPI_H_
 #define DBAPI_H_
 
+#include "config.h"
+
 #include <cstdint>
 
-int init_db(int num_buf, int flag, int log_num, char* log_path, char* logmsg_path);
+int init_db(int num_buf, int flag, int log_num, char* log_path,
+            char* logmsg_path, const DBConfig& config = DBConfig());
 int shutdown_db();
 
 int open_table(char* pathname);
+// the table is only read, from the mapped file. fails while the file is
+// open for writing.
+int open_table_read_only(char* pathname);
 int close_table(int table_id);
+// replaces the split and merge policy of the table until it is closed
+int db_set_tree_policy(int table_id, const TreePolicy& policy);
 
 int db_insert(int table_id, int64_t key, char* value);
 int db_find(int table_id, int64_t key, char* ret_val, int trx_id);
+// looks the keys up in one descent, see BPTree::find_many(). found[i] is
+// set to whether keys[i] is found, and its value copied to ret_vals[i].
+int db_find_many(int table_id, const int64_t* keys, int num_keys,
+                 char** ret_vals, int* found, int trx_id);
 int db_delete(int table_id, int64_t key);
 int db_update(int table_id, int64_t key, char* value, int trx_id);
 
+// inserts the records grouped by leaf, see BPTree::insert_many(). inserted[i]
+// is set to whether keys[i] is inserted, and may be null.
+int db_insert_batch(int table_id, const int64_t* keys, char** values,
+                    int num_records, int* inserted);
+// updates the records grouped by leaf, see BPTree::update_many(). updated[i]
+// is set to whether keys[i] is found, and may be null.
+int db_update_batch(int table_id, const int64_t* keys, char** values,
+                    int num_records, int* updated, int trx_id);
+
+// opens a scan of the records with keys in [lo, hi], in key order, see
+// BPTree::scan(). the records are locked shared by the transaction as they
+// are read. returns the scan id, or 0 when it fails.
+int db_scan_open(int table_id, int64_t lo, int64_t hi, int trx_id);
+// the next record of the scan. fails after the last one, and when the
+// transaction has been aborted on a deadlock.
+int db_scan_next(int scan_id, int64_t* key, char* ret_val);
+int db_scan_close(int scan_id);
+
+// runs a batch of the online compaction of the table, see BPTree::compact().
+// done is set to 1 once the table is compacted, and reclaimed_bytes to the
+// bytes the batch has cut off the file. both may be null.
+int db_compact(int table_id, int max_pages, int* done,
+               int64_t* reclaimed_bytes);
+
+// sets the next record of a bulk load, returns 0 after the last one
+using BulkLoadSource = int (*)(void* context, int64_t* key, char* value);
+
+// builds the tree of an empty table from the records of next in increasing
+// key order, the nodes filled to fill_factor in (0, 1], see BulkLoader.
+// num_records is set to the records loaded and may be null. the table is
+// left empty when it fails.
+int db_bulk_load(int table_id, BulkLoadSource next, void* context,
+                 double fill_factor, int64_t* num_records);
+
 int trx_begin();
 int trx_commit(int trx_id);
 int trx_abort(int trx_id);
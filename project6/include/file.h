@@ -1,13 +1,19 @@
 #ifndef FILE_H_
 #define FILE_H_
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "config.h"
+#include "free_space.h"
+#include "io.h"
 #include "types.h"
 
 // SIZE CONSTANTS
@@ -30,11 +36,26 @@ constexpr size_t PAGE_DATA_IN_PAGE =
 constexpr size_t PAGE_BRANCHES_IN_PAGE =
     (PAGE_SIZE - PAGE_HEADER_SIZE) / PAGE_BRANCH_SIZE;
 
-constexpr size_t HEADER_PAGE_USED = 24;
-constexpr size_t HEADER_PAGE_RESERVED = PAGE_SIZE - HEADER_PAGE_USED;
+constexpr size_t HEADER_PAGE_USED = 32;
+// the rest of the header page is the free space bitmap of the first pages
+constexpr size_t HEADER_PAGE_FREE_WORDS =
+    (PAGE_SIZE - HEADER_PAGE_USED) / sizeof(uint64_t);
+constexpr size_t BITMAP_PAGE_FREE_WORDS = PAGE_SIZE / sizeof(uint64_t);
 
 constexpr pagenum_t NULL_PAGE_NUM = 0;
 
+// how the free pages of a table file are kept track of
+enum class FreeSpaceFormat : uint64_t
+{
+    // a list linked through the free pages, from free_page_number
+    FREE_LIST = 0,
+    // the bits in the header page and in the bitmap pages
+    BITMAP = 1,
+    // a free list file being converted, whose pages where the bitmap pages
+    // go are copied past its first free_bits[0] pages
+    CONVERTING = 2
+};
+
 struct page_data_t final
 {
     int64_t key;
@@ -72,16 +93,27 @@ struct free_page_header_t final
 
 struct header_page_t final
 {
+    // head of the free list of a file in FREE_LIST format
     uint64_t free_page_number;
     uint64_t root_page_number;
     uint64_t num_pages;
+    uint64_t free_space_format;
+
+    // a set bit is a free page, see FreeSpaceMap
+    uint64_t free_bits[HEADER_PAGE_FREE_WORDS];
+};
 
-    char reserved[HEADER_PAGE_RESERVED];
+// free space bitmap of the pages past the header page's
+struct bitmap_page_t final
+{
+    uint64_t free_bits[BITMAP_PAGE_FREE_WORDS];
 };
 
-union page_t
+// aligned for O_DIRECT, which needs aligned buffers as well as offsets
+union alignas(PAGE_SIZE) page_t
 {
     header_page_t file;
+    bitmap_page_t bitmap;
 
     struct
     {
@@ -102,10 +134,29 @@ union page_t
 class Table;
 class Page;
 
+struct PageWrite final
+{
+    pagenum_t pagenum;
+    const page_t* page;
+};
+
 class File final
 {
  public:
-    static constexpr uint64_t NEW_PAGES_WHEN_NO_FREE_PAGES = 1;
+    // the file grows by an eighth of its size, within these bounds
+    static constexpr uint64_t MIN_EXTENT_PAGES = 64;
+    static constexpr uint64_t MAX_EXTENT_PAGES = 4096;
+
+    // pages whose free bits are in the header page. the bits of the pages
+    // after them are in bitmap pages, each one placed at the first page of
+    // the range it stands for.
+    static constexpr uint64_t HEADER_FREE_BITS = HEADER_PAGE_FREE_WORDS * 64;
+    static constexpr uint64_t BITMAP_FREE_BITS = BITMAP_PAGE_FREE_WORDS * 64;
+
+ public:
+    // the bitmap page holding the free bit of the page, or NULL_PAGE_NUM
+    // for the header page
+    [[nodiscard]] static pagenum_t bitmap_page_of(pagenum_t pagenum);
 
  public:
     ~File();
@@ -120,25 +171,103 @@ class File final
     [[nodiscard]] const std::string& filename() const;
 
     [[nodiscard]] bool is_open() const;
-
-    [[nodiscard]] bool file_alloc_page(Page& header, pagenum_t& pagenum);
+    // whether the file bypasses the kernel page cache
+    [[nodiscard]] bool is_direct() const;
+
+    // grows the file by an extent of free pages, when none is left.
+    // the free bits of the new pages are stored by the caller.
+    [[nodiscard]] bool file_alloc_extent(Page& header);
+    // cuts the file down to its first num_pages pages, which must hold the
+    // pages in use. the frames of the pages kept are written back, and the
+    // ones of the pages cut off dropped, by the caller before.
+    [[nodiscard]] bool file_truncate(Page& header, uint64_t num_pages);
+
+    // free pages of the file, the header page latch guards it
+    [[nodiscard]] FreeSpaceMap& free_space();
+    // the last page in use that is not a bitmap page, guarded as the free
+    // space
+    [[nodiscard]] pagenum_t last_node_page() const;
 
     [[nodiscard]] bool file_read_page(pagenum_t pagenum, page_t* dest);
     [[nodiscard]] bool file_write_page(pagenum_t pagenum, const page_t* src);
+    // writes the pages sorted by page number, every run of consecutive
+    // pages with one vectored write, then makes them durable at once
+    [[nodiscard]] bool file_write_pages(std::vector<PageWrite>& pages);
+
+    // number of pages in use or free. the pages of an extent are past it
+    // until its bitmap pages are written, so they are not read before.
+    [[nodiscard]] uint64_t num_pages() const;
 
  private:
-    [[nodiscard]] bool open(const std::string& filename);
+    [[nodiscard]] bool open(const std::string& filename, bool direct_io);
     void close();
 
-    [[nodiscard]] bool extend(Page& header, uint64_t new_pages);
-    [[nodiscard]] size_t capacity() const;
+    [[nodiscard]] bool load_free_space(page_t& header);
+    // turns the free list of an older file into the free bits
+    [[nodiscard]] bool convert_free_list(page_t& header);
+    [[nodiscard]] bool load_free_list(page_t& header);
+    // where a page of a file of old_pages pages is after the pages in the
+    // way of the bitmap pages are moved past its end
+    [[nodiscard]] static pagenum_t moved_page(pagenum_t pagenum,
+                                              uint64_t old_pages);
+    // copies the pages in the way, then points the tree at the copies
+    [[nodiscard]] bool move_bitmap_pages(page_t& header);
+    // the free pages are the ones the tree does not reach
+    [[nodiscard]] bool load_tree_pages(page_t& header, uint64_t old_pages);
+    [[nodiscard]] bool write_bitmap_page(pagenum_t bitmap_page);
+
+    [[nodiscard]] uint64_t extent_pages(uint64_t num_pages) const;
+    [[nodiscard]] bool extend(uint64_t first, uint64_t new_pages);
 
     [[nodiscard]] bool read(size_t size, size_t offset, void* value);
     [[nodiscard]] bool write(size_t size, size_t offset, const void* value);
+    [[nodiscard]] bool writev(size_t offset, iovec* iov, int count);
+    [[nodiscard]] bool sync();
 
  private:
     std::string filename_;
     int file_handle_{ -1 };
+    bool direct_{ false };
+    uint64_t extent_pages_{ 0 };
+    std::atomic<uint64_t> num_pages_{ 0 };
+    FreeSpaceMap free_space_;
+
+    friend class FileManager;
+};
+
+// a table file mapped read only, whose pages are read in place.
+// it holds a shared lock on the file, and File an exclusive one, so the
+// file is not mapped while a writer has it open, in this process or not.
+class MappedFile final
+{
+ public:
+    ~MappedFile();
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+
+    [[nodiscard]] const std::string& filename() const;
+
+    [[nodiscard]] bool is_open() const;
+
+    // nullptr when the page is past the end of the file
+    [[nodiscard]] const page_t* page(pagenum_t pagenum) const;
+    [[nodiscard]] size_t num_pages() const;
+
+ private:
+    [[nodiscard]] bool open(const std::string& filename);
+    void close();
+
+ private:
+    std::string filename_;
+    int file_handle_{ -1 };
+
+    const page_t* pages_{ nullptr };
+    size_t num_pages_{ 0 };
 
     friend class FileManager;
 };
@@ -146,7 +275,7 @@ class File final
 class FileManager final
 {
  public:
-    [[nodiscard]] static bool initialize();
+    [[nodiscard]] static bool initialize(const DBConfig& config);
     [[nodiscard]] static bool shutdown();
 
     [[nodiscard]] static FileManager& get_instnace();
@@ -154,8 +283,15 @@ class FileManager final
     [[nodiscard]] bool open_table(Table& table);
     [[nodiscard]] bool close_table(Table& table);
 
+    [[nodiscard]] IOBackend& io();
+
  private:
     std::unordered_map<std::string, File> files_;
+    std::unordered_map<std::string, MappedFile> mapped_files_;
+
+    std::unique_ptr<IOBackend> io_;
+    bool direct_io_{ false };
+    int extent_pages_{ 0 };
 
     inline static FileManager* instance_{ nullptr };
 };
@@ -0,0 +1,47 @@
+#ifndef FRAME_ARENA_H_
+#define FRAME_ARENA_H_
+
+#include "config.h"
+#include "file.h"
+
+#include <cstddef>
+
+// the memory holding the frames of the buffer pool.
+// it is mapped with 2MB huge pages when the system has them reserved, and
+// with transparent huge pages advised otherwise, so that a large pool does
+// not spend its time on TLB misses. the mapping can be interleaved across
+// the NUMA nodes or bound to one of them before it is first touched.
+class FrameArena final
+{
+ public:
+    static constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+ public:
+    FrameArena() = default;
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    [[nodiscard]] bool allocate(std::size_t num_frames,
+                                const DBConfig& config);
+    void release();
+
+    [[nodiscard]] page_t* frames() const;
+    [[nodiscard]] std::size_t size() const;
+
+    // whether the frames are backed by reserved huge pages
+    [[nodiscard]] bool huge_pages() const;
+
+ private:
+    [[nodiscard]] bool map_huge_pages(std::size_t size);
+    [[nodiscard]] bool map_pages(std::size_t size, bool advise_huge_pages);
+    [[nodiscard]] bool set_numa_policy(const DBConfig& config);
+
+ private:
+    void* addr_{ nullptr };
+    std::size_t size_{ 0 };
+    bool huge_pages_{ false };
+};
+
+#endif  // FRAME_ARENA_H_
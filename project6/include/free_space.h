@@ -0,0 +1,68 @@
+#ifndef FREE_SPACE_H_
+#define FREE_SPACE_H_
+
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// which pages of a table file are free, one bit per page.
+// it is kept in memory while the table is open, so that an allocation
+// searches words instead of reading pages. File stores the words in the
+// header page and in bitmap pages.
+class FreeSpaceMap final
+{
+ public:
+    [[nodiscard]] uint64_t size() const;
+    [[nodiscard]] uint64_t num_free() const;
+
+    // the pages past the previous size are in use
+    void resize(uint64_t num_pages);
+    // replaces the words from the given one, the bits past the size are
+    // ignored
+    void load(std::size_t first_word, const uint64_t* words,
+              std::size_t count);
+
+    [[nodiscard]] bool is_free(pagenum_t pagenum) const;
+    void set_free(pagenum_t pagenum, bool free);
+    void set_free(pagenum_t first, uint64_t count, bool free);
+
+    // the word holding the bit of the page, as it is stored
+    [[nodiscard]] uint64_t word(pagenum_t pagenum) const;
+
+    // takes the first free page at or after the hint, wrapping around.
+    // without a hint, it continues after the last page taken, so that
+    // pages taken one after another are consecutive.
+    [[nodiscard]] std::optional<pagenum_t> allocate(pagenum_t hint = 0);
+    // takes the first free page after the given one within distance, or
+    // else the closest one before it. the order of allocate() is kept.
+    [[nodiscard]] std::optional<pagenum_t> allocate_near(pagenum_t pagenum,
+                                                         uint64_t distance);
+    // takes count consecutive free pages, the first one is returned
+    [[nodiscard]] std::optional<pagenum_t> allocate_run(uint64_t count,
+                                                        pagenum_t hint = 0);
+    // takes the first free page in [from, to), the order of allocate() is
+    // kept
+    [[nodiscard]] std::optional<pagenum_t> allocate_in(pagenum_t from,
+                                                       pagenum_t to);
+
+    // the last page in use before the given one, or 0
+    [[nodiscard]] pagenum_t last_used(pagenum_t before) const;
+
+ private:
+    // the first free page in [from, to), or to
+    [[nodiscard]] pagenum_t find_free(pagenum_t from, pagenum_t to) const;
+    // the first page in use in [from, to), or to
+    [[nodiscard]] pagenum_t find_used(pagenum_t from, pagenum_t to) const;
+
+ private:
+    std::vector<uint64_t> words_;
+    uint64_t size_{ 0 };
+    uint64_t num_free_{ 0 };
+
+    pagenum_t cursor_{ 0 };
+};
+
+#endif  // FREE_SPACE_H_
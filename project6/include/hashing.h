@@ -1,27 +1,56 @@
 #ifndef HASHING_H_
 #define HASHING_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace hashing
+{
+// splitmix64 finalizer, every input bit affects every output bit.
+// the low bits matter, the buffer pool takes the hash modulo the number of
+// partitions.
+constexpr std::size_t mix(std::uint64_t x) noexcept
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+
+    return static_cast<std::size_t>(x);
+}
+
+constexpr std::size_t combine(std::size_t seed, std::uint64_t value) noexcept
+{
+    return mix(seed ^ (value + 0x9e3779b97f4a7c15ULL));
+}
+}  // namespace hashing
+
 namespace std
 {
 template <>
 struct hash<table_page_t> final
 {
-    std::size_t operator()(const table_page_t& tpid) const
+    std::size_t operator()(const table_page_t& tpid) const noexcept
     {
         auto [tid, pid] = tpid;
 
-        return hash<string>()(to_string(tid) + '|' + to_string(pid));
+        return hashing::combine(hashing::mix(pid),
+                                static_cast<std::uint32_t>(tid));
     }
 };
 
 template <>
 struct hash<HierarchyID> final
 {
-    std::size_t operator()(const HierarchyID& hid) const
+    std::size_t operator()(const HierarchyID& hid) const noexcept
     {
-        return hash<string>()(to_string(hid.table_id) + '|' +
-                              to_string(hid.pagenum) + '|' +
-                              to_string(hid.offset));
+        const std::size_t seed =
+            hashing::combine(hashing::mix(hid.pagenum),
+                             static_cast<std::uint32_t>(hid.table_id));
+
+        return hashing::combine(seed, static_cast<std::uint32_t>(hid.offset));
     }
 };
 }  // namespace std
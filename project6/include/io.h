@@ -0,0 +1,163 @@
+#ifndef IO_H_
+#define IO_H_
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+enum class IOOp
+{
+    READ,
+    WRITE,
+    // fdatasync
+    SYNC
+};
+
+// an i/o of the table files. it is owned by the caller until wait()
+// returned for it.
+struct IORequest final
+{
+    IOOp op{ IOOp::READ };
+    int fd{ -1 };
+    iovec* iov{ nullptr };
+    int iov_count{ 0 };
+    off_t offset{ 0 };
+
+    // transferred bytes, or -errno. set when done.
+    ssize_t result{ 0 };
+    bool done{ false };
+};
+
+// how File reads and writes pages. a backend lets many requests be in
+// flight at once, from one thread submitting a batch or from many threads
+// each waiting for its own.
+class IOBackend
+{
+ public:
+    // IO_URING falls back to THREAD_POOL when io_uring is not available
+    [[nodiscard]] static std::unique_ptr<IOBackend> create(
+        IOBackendType type, int queue_depth);
+
+ public:
+    virtual ~IOBackend() = default;
+
+    [[nodiscard]] virtual IOBackendType type() const = 0;
+
+    // starts the requests, they may complete in any order
+    virtual void submit(IORequest* requests, std::size_t count) = 0;
+    // returns when every request is done
+    virtual void wait(IORequest* requests, std::size_t count) = 0;
+};
+
+// blocking preadv / pwritev in the calling thread
+class PreadBackend final : public IOBackend
+{
+ public:
+    [[nodiscard]] IOBackendType type() const override;
+
+    void submit(IORequest* requests, std::size_t count) override;
+    void wait(IORequest* requests, std::size_t count) override;
+};
+
+// the blocking calls are made by a pool of i/o threads
+class ThreadPoolBackend final : public IOBackend
+{
+ public:
+    explicit ThreadPoolBackend(int num_threads);
+    ~ThreadPoolBackend() override;
+
+    [[nodiscard]] IOBackendType type() const override;
+
+    void submit(IORequest* requests, std::size_t count) override;
+    void wait(IORequest* requests, std::size_t count) override;
+
+ private:
+    void worker_main();
+
+ private:
+    std::mutex mutex_;
+    std::condition_variable queue_cond_;
+    std::condition_variable done_cond_;
+    std::deque<IORequest*> queue_;
+    bool stop_{ false };
+
+    std::vector<std::thread> workers_;
+};
+
+// requests go through an io_uring submission queue, and a reaper thread
+// hands the completions to the waiting threads
+class IOUringBackend final : public IOBackend
+{
+ public:
+    IOUringBackend() = default;
+    ~IOUringBackend() override;
+
+    IOUringBackend(const IOUringBackend&) = delete;
+    IOUringBackend& operator=(const IOUringBackend&) = delete;
+
+    [[nodiscard]] bool init(unsigned entries);
+
+    [[nodiscard]] IOBackendType type() const override;
+
+    void submit(IORequest* requests, std::size_t count) override;
+    void wait(IORequest* requests, std::size_t count) override;
+
+ private:
+    // queues one entry, the caller holds mutex_
+    void push(IORequest* request);
+    // passes the queued entries to the kernel, the ones it refuses are done
+    // with the error
+    void flush();
+    void fail_pending(int error);
+    [[nodiscard]] int enter(unsigned to_submit, unsigned min_complete,
+                            unsigned flags);
+
+    void reaper_main();
+
+ private:
+    int ring_fd_{ -1 };
+
+    void* sq_ring_{ nullptr };
+    std::size_t sq_ring_size_{ 0 };
+    void* cq_ring_{ nullptr };
+    std::size_t cq_ring_size_{ 0 };
+    io_uring_sqe* sqes_{ nullptr };
+    std::size_t sqes_size_{ 0 };
+
+    unsigned* sq_tail_{ nullptr };
+    unsigned* sq_array_{ nullptr };
+    unsigned sq_mask_{ 0 };
+    unsigned sq_entries_{ 0 };
+
+    unsigned* cq_head_{ nullptr };
+    unsigned* cq_tail_{ nullptr };
+    io_uring_cqe* cqes_{ nullptr };
+    unsigned cq_mask_{ 0 };
+    unsigned cq_entries_{ 0 };
+
+    std::mutex mutex_;
+    // entries queued and not passed to the kernel yet
+    unsigned pending_{ 0 };
+    // requests submitted and not completed, at most cq_entries_
+    unsigned inflight_{ 0 };
+    std::condition_variable space_cond_;
+    std::condition_variable done_cond_;
+
+    bool stop_{ false };
+    std::condition_variable reaper_cond_;
+    std::thread reaper_;
+};
+
+#endif  // IO_H_
@@ -0,0 +1,41 @@
+#ifndef KEY_SEARCH_H_
+#define KEY_SEARCH_H_
+
+#include "file.h"
+
+#include <cstdint>
+
+// how the keys of a node are compared, the vector ones are taken only when
+// the cpu supports them
+enum class SearchKernel
+{
+    SCALAR,
+    SSE42,
+    AVX2
+};
+
+// searches in the keys of a node. the keys are narrowed down by a binary
+// search to a few ones, which are then counted at once by the vector
+// kernels. the keys of the leaves are a record apart and gathered, those of
+// the inner nodes a branch apart and loaded in pairs.
+namespace key_search
+{
+// the best kernel the cpu supports
+[[nodiscard]] SearchKernel detect();
+[[nodiscard]] SearchKernel kernel();
+// fails when the cpu does not support it
+[[nodiscard]] bool set_kernel(SearchKernel kernel);
+
+// the first entry whose key is not less than key, size when none
+[[nodiscard]] int lower_bound(const page_data_t* data, int size, int64_t key);
+[[nodiscard]] int lower_bound(const page_branch_t* branches, int size,
+                              int64_t key);
+// the first branch whose key is greater than key, size when none
+[[nodiscard]] int upper_bound(const page_branch_t* branches, int size,
+                              int64_t key);
+// the branch pointing to the child, size when none
+[[nodiscard]] int find_child(const page_branch_t* branches, int size,
+                             pagenum_t child);
+}  // namespace key_search
+
+#endif  // KEY_SEARCH_H_
@@ -0,0 +1,70 @@
+#ifndef LATCH_H_
+#define LATCH_H_
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+
+using version_t = std::uint64_t;
+
+// sequence counter for optimistic readers.
+// a writer that already holds the exclusive latch keeps the version odd
+// while it modifies the protected data. readers take no latch, they read
+// the version before and after looking at the data and restart when it
+// has changed.
+class SeqVersion final
+{
+ public:
+    // std::nullopt while a writer is active
+    [[nodiscard]] std::optional<version_t> begin_read() const
+    {
+        const version_t version = version_.load(std::memory_order_acquire);
+        if (version & 1)
+            return std::nullopt;
+
+        return version;
+    }
+
+    [[nodiscard]] bool validate(version_t version) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version_.load(std::memory_order_relaxed) == version;
+    }
+
+    void begin_write()
+    {
+        version_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void end_write()
+    {
+        version_.fetch_add(1, std::memory_order_release);
+    }
+
+ private:
+    std::atomic<version_t> version_{ 0 };
+};
+
+// latch of the tree structure of a table.
+// operations that stay within one leaf take it shared and latch only the
+// pages they touch, splits and merges take it exclusive. readers do not take
+// it at all, they validate its version instead.
+class TreeLatch final
+{
+ public:
+    void lock();
+    void unlock();
+    void lock_shared();
+    void unlock_shared();
+
+    [[nodiscard]] std::optional<version_t> begin_read() const;
+    [[nodiscard]] bool validate(version_t version) const;
+
+ private:
+    std::shared_mutex mutex_;
+    SeqVersion version_;
+};
+
+#endif  // LATCH_H_
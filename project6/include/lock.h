@@ -8,6 +8,7 @@
 #include <mutex>
 #include <unordered_map>
 #include <tuple>
+#include <vector>
 
 enum class LockType
 {
@@ -81,9 +82,19 @@ class LockManager final
     [[nodiscard]] static LockManager& get_instance();
 
     [[nodiscard]] std::tuple<Lock*, LockAcquireResult> acquire(HierarchyID hid, Xact* xact, LockType type);
+    // acquires the locks in order under one latch of the manager, up to the
+    // first one not acquired, whose result is returned. locks is filled
+    // with the locks acquired, and the one to wait for, if any.
+    [[nodiscard]] LockAcquireResult acquire_many(
+        const std::vector<HierarchyID>& hids, Xact* xact, LockType type,
+        std::vector<Lock*>& locks);
     [[nodiscard]] bool release(Lock* lock_obj);
 
  private:
+    // the caller holds the latch of the manager
+    [[nodiscard]] std::tuple<Lock*, LockAcquireResult> acquire_locked(
+        HierarchyID hid, Xact* xact, LockType type);
+
     void clear_all_entries();
 
     [[nodiscard]] WaitForGraph build_wait_for_graph() const;
@@ -94,6 +94,14 @@ class Log
 };
 #pragma pack(pop)
 
+// a record updated in place, see LogManager::log_updates()
+struct RecordUpdate final
+{
+    HierarchyID hid;
+    const char* old_value;
+    const char* new_value;
+};
+
 struct log_file_header final
 {
     lsn_t base_lsn;
@@ -112,6 +120,10 @@ class LogManager final
     lsn_t log_commit(xact_id xid, lsn_t last_lsn);
     lsn_t log_update(xact_id xid, lsn_t last_lsn, const HierarchyID& hid,
                      int length, page_data_t old_data, page_data_t new_data);
+    // appends the update records of the values at once, each one chained to
+    // the one before it. returns the lsn of the last one.
+    lsn_t log_updates(xact_id xid, lsn_t last_lsn,
+                      const std::vector<RecordUpdate>& updates);
     lsn_t log_rollback(xact_id xid, lsn_t last_lsn);
     lsn_t log_compensate(xact_id xid, lsn_t last_lsn, const HierarchyID& hid,
                          int length, const void* old_data, const void* new_data,
@@ -126,6 +138,8 @@ class LogManager final
 
     [[nodiscard]] lsn_t base_lsn() const;
     [[nodiscard]] lsn_t next_lsn() const;
+    // every log record whose lsn is less than this is on the disk
+    [[nodiscard]] lsn_t flushed_lsn() const;
 
     void truncate_log();
     [[nodiscard]] Log read_log(lsn_t lsn) const;
@@ -146,7 +160,8 @@ class LogManager final
     std::vector<std::unique_ptr<Log>> log_;
     std::unordered_map<xact_id, std::list<std::unique_ptr<Log>>> log_per_xact_;
 
-    log_file_header header_;
+    log_file_header header_{};
+    std::atomic<lsn_t> flushed_lsn_{ NULL_LSN };
 
     int f_log_{ -1 };
 
@@ -2,13 +2,26 @@
 #define PAGE_H_
 
 #include "file.h"
+#include "latch.h"
 
 class BufferBlock;
 
+// how a page is latched while it is pinned through buffer().
+// NONE only pins the frame. it is used by the optimistic readers that
+// validate the page version and by the readers of pages the tree latch
+// keeps from changing. a transaction is aborted without any page latch
+// held, so that its undo latches the records it writes back.
+enum class PageLatch
+{
+    NONE,
+    SHARED,
+    EXCLUSIVE
+};
+
 class Page final
 {
  public:
-    Page(BufferBlock& block);
+    Page(BufferBlock& block, PageLatch latch);
     ~Page() noexcept;
 
     void clear();
@@ -17,12 +30,19 @@ class Page final
     [[nodiscard]] pagenum_t pagenum() const;
     [[nodiscard]] table_id_t table_id() const;
 
+    // optimistic read of a page pinned without a latch, see SeqVersion.
+    // the version changes whenever the page is latched exclusively.
+    [[nodiscard]] std::optional<version_t> begin_read() const;
+    [[nodiscard]] bool validate(version_t version) const;
+
     [[nodiscard]] header_page_t& header_page();
     [[nodiscard]] const header_page_t& header_page() const;
     [[nodiscard]] page_header_t& header();
     [[nodiscard]] const page_header_t& header() const;
     [[nodiscard]] free_page_header_t& free_header();
     [[nodiscard]] const free_page_header_t& free_header() const;
+    [[nodiscard]] bitmap_page_t& bitmap_page();
+    [[nodiscard]] const bitmap_page_t& bitmap_page() const;
 
     [[nodiscard]] page_branch_t* branches();
     [[nodiscard]] const page_branch_t* branches() const;
@@ -31,6 +51,7 @@ class Page final
 
  private:
     BufferBlock& block_;
+    PageLatch latch_;
 };
 
 #endif  // PAGE_H_
@@ -0,0 +1,50 @@
+#ifndef PAGE_TABLE_H_
+#define PAGE_TABLE_H_
+
+#include "types.h"
+
+#include <cstddef>
+#include <vector>
+
+class BufferBlock;
+
+// maps a page to the frame holding it.
+// a partition never maps more pages than it has frames, so the table is an
+// open addressing table with linear probing, allocated once for that many
+// entries at most. a lookup scans consecutive slots holding the keys inline,
+// and erase shifts the following entries back instead of leaving tombstones.
+class PageTable final
+{
+ public:
+    PageTable() = default;
+    explicit PageTable(std::size_t max_entries);
+
+    [[nodiscard]] BufferBlock* find(const table_page_t& tpid) const;
+
+    // the page must not be in the table yet
+    void insert(const table_page_t& tpid, BufferBlock* block);
+    void erase(const table_page_t& tpid);
+
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] std::size_t capacity() const;
+
+ private:
+    struct Slot final
+    {
+        table_id_t table_id{ -1 };
+        pagenum_t pagenum{ 0 };
+        BufferBlock* block{ nullptr };
+    };
+
+    [[nodiscard]] std::size_t home(table_id_t table_id,
+                                   pagenum_t pagenum) const;
+    [[nodiscard]] std::size_t next(std::size_t index) const;
+
+ private:
+    std::vector<Slot> slots_;
+    std::size_t mask_{ 0 };
+    int shift_{ 0 };
+    std::size_t size_{ 0 };
+};
+
+#endif  // PAGE_TABLE_H_
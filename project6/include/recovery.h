@@ -18,6 +18,10 @@ enum class RecoveryMode
 
 class Recovery final
 {
+ public:
+    // records whose pages are read ahead of the one being redone
+    static constexpr int REDO_PREFETCH_DISTANCE = 64;
+
  public:
     Recovery(const std::string& logmsg_path,
              RecoveryMode mode, int log_num);
@@ -28,6 +32,9 @@ class Recovery final
  private:
     void analyse();
     [[nodiscard]] bool redo();
+    // prefetches the pages of the records from lsn on, returns the lsn
+    // after the last one
+    lsn_t prefetch_redo(lsn_t lsn, lsn_t next_lsn, int num_records);
     [[nodiscard]] bool undo();
 
  private:
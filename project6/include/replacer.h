@@ -0,0 +1,136 @@
+#ifndef REPLACER_H_
+#define REPLACER_H_
+
+#include "config.h"
+#include "types.h"
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class BufferBlock;
+
+// intrusive circular list over BufferBlock::prev_ / next_.
+// a block can be linked in at most one list at a time.
+class BlockList final
+{
+ public:
+    [[nodiscard]] BufferBlock* head() const;
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] bool empty() const;
+
+    void push_back(BufferBlock* block);
+    void insert_before(BufferBlock* pos, BufferBlock* block);
+    void remove(BufferBlock* block);
+    void move_to_back(BufferBlock* block);
+
+    // appends at most limit blocks, starting from the given one
+    void collect(BufferBlock* from, std::vector<BufferBlock*>& blocks,
+                 std::size_t limit) const;
+
+ private:
+    BufferBlock* head_{ nullptr };
+    std::size_t size_{ 0 };
+};
+
+// decides which frame of a partition is evicted next.
+// every method is called with the partition latch held.
+class Replacer
+{
+ public:
+    [[nodiscard]] static std::unique_ptr<Replacer> create(
+        ReplacementPolicy policy, int num_frames);
+
+ public:
+    virtual ~Replacer() = default;
+
+    // the block starts holding a page
+    virtual void insert(BufferBlock* block) = 0;
+    // the page held by the block is accessed again
+    virtual void touch(BufferBlock* block) = 0;
+    // the block drops its page
+    virtual void erase(BufferBlock* block) = 0;
+
+    // returns an unpinned block, or nullptr when every block is pinned
+    [[nodiscard]] virtual BufferBlock* victim() = 0;
+
+    // appends at most limit blocks in the order they would be evicted,
+    // without changing any replacement state
+    virtual void cold_blocks(std::vector<BufferBlock*>& blocks,
+                             std::size_t limit) const = 0;
+};
+
+// the original policy: every hit relinks the block to the tail of the list
+class LRUReplacer final : public Replacer
+{
+ public:
+    void insert(BufferBlock* block) override;
+    void touch(BufferBlock* block) override;
+    void erase(BufferBlock* block) override;
+
+    [[nodiscard]] BufferBlock* victim() override;
+
+    void cold_blocks(std::vector<BufferBlock*>& blocks,
+                     std::size_t limit) const override;
+
+ private:
+    BlockList list_;
+};
+
+// a hit only sets the reference bit, the hand clears it while sweeping
+class ClockReplacer final : public Replacer
+{
+ public:
+    void insert(BufferBlock* block) override;
+    void touch(BufferBlock* block) override;
+    void erase(BufferBlock* block) override;
+
+    [[nodiscard]] BufferBlock* victim() override;
+
+    void cold_blocks(std::vector<BufferBlock*>& blocks,
+                     std::size_t limit) const override;
+
+ private:
+    BlockList ring_;
+    BufferBlock* hand_{ nullptr };
+};
+
+// 2Q (Johnson & Shasha) with a CLOCK managed main queue.
+// pages referenced once stay in the FIFO A1in queue, so a sequential scan
+// can not flush the frequently used pages living in Am.
+class TwoQReplacer final : public Replacer
+{
+ public:
+    explicit TwoQReplacer(int num_frames);
+
+    void insert(BufferBlock* block) override;
+    void touch(BufferBlock* block) override;
+    void erase(BufferBlock* block) override;
+
+    [[nodiscard]] BufferBlock* victim() override;
+
+    void cold_blocks(std::vector<BufferBlock*>& blocks,
+                     std::size_t limit) const override;
+
+ private:
+    [[nodiscard]] BufferBlock* victim_from_a1in();
+    [[nodiscard]] BufferBlock* victim_from_am();
+
+    void remember(const table_page_t& tpid);
+
+ private:
+    const std::size_t kin_;
+    const std::size_t kout_;
+
+    BlockList a1in_;
+    BlockList am_;
+    BufferBlock* hand_{ nullptr };
+
+    std::list<table_page_t> a1out_;
+    std::unordered_map<table_page_t, std::list<table_page_t>::iterator>
+        a1out_tbl_;
+};
+
+#endif  // REPLACER_H_
@@ -1,36 +1,117 @@
 #ifndef TABLE_H_
 #define TABLE_H_
 
+#include "config.h"
 #include "file.h"
+#include "latch.h"
 #include "xact.h"
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+struct LeafLayout;
+struct CompactionStats;
+
+// where the compaction of a table goes on between its batches, see
+// BPTree::compact(). guarded by the tree latch.
+struct CompactionCursor final
+{
+    enum class Phase
+    {
+        // merging the leaves and moving them into key order
+        LEAVES,
+        // moving the nodes at the end of the file to free pages before it
+        NODES
+    };
+
+    Phase phase{ Phase::LEAVES };
+    // a key of the next leaf to visit, none for the leftmost one
+    std::optional<int64_t> next_key;
+    // the page of the last leaf visited
+    pagenum_t last_leaf{ NULL_PAGE_NUM };
+};
+
+// a range scan of a table between its batches, see BPTree::scan()
+struct ScanCursor final
+{
+    table_id_t table_id{ -1 };
+    // the transaction locking the records read
+    int trx_id{ 0 };
+    // the keys are scanned from next_key up to hi
+    int64_t next_key{ 0 };
+    int64_t hi{ 0 };
+    bool done{ false };
+
+    // the leaf holding next_key, followed without a traversal while the
+    // tree version is unchanged
+    pagenum_t next_leaf{ NULL_PAGE_NUM };
+    version_t tree_version{ 0 };
+
+    // the records of the last batch, handed out from position on
+    std::vector<page_data_t> records;
+    std::size_t position{ 0 };
+};
+
 class Table final
 {
  public:
     table_id_t id() const;
     const std::string& filename() const;
+    // whether the table is served from its mapped file, see MappedFile
+    bool read_only() const;
 
     [[nodiscard]] bool insert(const page_data_t& record);
     [[nodiscard]] bool remove(int64_t key);
     [[nodiscard]] std::optional<page_data_t> find(int64_t key, Xact* xact);
+    [[nodiscard]] bool find_many(
+        const std::vector<int64_t>& keys,
+        std::vector<std::optional<page_data_t>>& records, Xact* xact);
     [[nodiscard]] bool update(int64_t key, const char* value, Xact* xact);
+    [[nodiscard]] bool insert_many(const std::vector<page_data_t>& records,
+                                   std::vector<bool>& inserted);
+    [[nodiscard]] bool update_many(const std::vector<page_data_t>& records,
+                                   std::vector<bool>& updated, Xact* xact);
+
+    // guarded by the tree latch
+    const TreePolicy& policy() const;
+    void set_policy(const TreePolicy& policy);
+
+    [[nodiscard]] std::optional<LeafLayout> leaf_layout();
+    [[nodiscard]] std::optional<CompactionStats> compact(int max_pages);
+    [[nodiscard]] bool scan(ScanCursor& cursor, Xact* xact);
+    [[nodiscard]] std::optional<uint64_t> bulk_load(
+        const std::function<bool(page_data_t&)>& next, double fill_factor);
+    CompactionCursor& compaction_cursor();
 
     void set_file(File* file);
     File* file();
 
+    void set_mapped_file(MappedFile* mapped_file);
+    MappedFile* mapped_file();
+
+    TreeLatch& tree_latch();
+
  private:
-    Table(table_id_t id, std::string filename);
+    Table(table_id_t id, std::string filename, bool read_only);
 
  private:
     table_id_t id_{ -1 };
     std::string filename_;
+    bool read_only_{ false };
 
     File* file_{ nullptr };
+    MappedFile* mapped_file_{ nullptr };
+
+    // kept on the heap, so that Table stays movable
+    std::unique_ptr<TreeLatch> tree_latch_;
+
+    TreePolicy policy_;
+    CompactionCursor compaction_cursor_;
 
     friend class TableManager;
 };
@@ -41,25 +122,38 @@ class TableManager final
     constexpr static int MAX_TABLE_COUNT = 10;
 
  public:
-    [[nodiscard]] static bool initialize(int num_buf);
+    [[nodiscard]] static bool initialize(int num_buf,
+                                         const DBConfig& config);
     [[nodiscard]] static bool shutdown();
 
     [[nodiscard]] static bool is_initialized();
 
     [[nodiscard]] static TableManager& get_instance();
 
+    // a read only table is rejected while the file is open for writing,
+    // and the other way around
     [[nodiscard]] std::optional<table_id_t> open_table(
-        const std::string& filename);
+        const std::string& filename, bool read_only = false);
     [[nodiscard]] bool close_table(table_id_t tid);
     [[nodiscard]] bool close_all_tables();
 
     [[nodiscard]] bool is_open(table_id_t tid) const;
     [[nodiscard]] std::optional<Table*> get_table(table_id_t tid);
 
+    // the scans opened by db_scan_open(), by id. a cursor is used by one
+    // thread at a time.
+    [[nodiscard]] int open_scan(ScanCursor cursor);
+    [[nodiscard]] std::optional<ScanCursor*> get_scan(int scan_id);
+    [[nodiscard]] bool close_scan(int scan_id);
+
  private:
     std::unordered_map<std::string, table_id_t> table_ids_;
     std::unordered_map<table_id_t, Table> tables_;
 
+    std::mutex scan_mutex_;
+    std::unordered_map<int, ScanCursor> scans_;
+    int next_scan_id_{ 1 };
+
     inline static TableManager* instance_{ nullptr };
 };
 
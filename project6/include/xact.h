@@ -8,6 +8,7 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 class Xact final
 {
@@ -21,6 +22,12 @@ class Xact final
 
     [[nodiscard]] LockAcquireResult add_lock(HierarchyID hid, LockType type,
                                              Lock** lock_obj = nullptr);
+    // adds the locks in one round trip to the lock manager, up to the first
+    // one not acquired, whose index is set to num_acquired and whose result
+    // is returned, see LockManager::acquire_many()
+    [[nodiscard]] LockAcquireResult add_locks(
+        const std::vector<HierarchyID>& hids, LockType type,
+        std::size_t& num_acquired, Lock** lock_obj = nullptr);
     [[nodiscard]] bool release_all_locks();
 
     [[nodiscard]] bool undo();
@@ -33,6 +40,10 @@ class Xact final
     void last_lsn(lsn_t lsn);
     lsn_t last_lsn() const;
 
+ private:
+    // a lock held on the record at least as strong as type
+    [[nodiscard]] Lock* find_lock(const HierarchyID& hid, LockType type) const;
+
  private:
     std::mutex mutex_;
     xact_id id_;
@@ -54,6 +65,8 @@ class XactManager final
     [[nodiscard]] bool abort(Xact* xact);
 
     [[nodiscard]] Xact* get(xact_id id) const;
+    // transactions begun and not committed or aborted yet
+    [[nodiscard]] std::size_t num_active() const;
 
     void acquire_xact_lock(Xact* xact);
 
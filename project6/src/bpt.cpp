@@ -1,24 +1,33 @@
 #include "bpt.h"
 
 #include "buffer.h"
+#include "bulk_load.h"
 #include "common.h"
 #include "file.h"
+#include "key_search.h"
 #include "lock.h"
 #include "log.h"
 
 #include <cassert>
+#include <cmath>
 
 #include <algorithm>
 #include <array>
 #include <cstring>
+#include <mutex>
 #include <queue>
+#include <shared_mutex>
 #include <sstream>
+#include <thread>
 
 namespace
 {
-constexpr int cut(int length)
+bool is_valid(const TreePolicy& policy)
 {
-    return (length % 2) ? (length / 2 + 1) : (length / 2);
+    return policy.merge_threshold >= 0 && policy.merge_threshold < 0.5 &&
+           policy.redistribution_bias >= 0 &&
+           policy.redistribution_bias < 1 && policy.split_fill > 0 &&
+           policy.split_fill < 1;
 }
 
 int get_left_index(const Page& parent, pagenum_t left_num)
@@ -26,53 +35,117 @@ int get_left_index(const Page& parent, pagenum_t left_num)
     if (parent.header().page_a_number == left_num)
         return 0;
 
-    const int num_keys = parent.header().num_keys;
-    auto branches = parent.branches();
-
-    int left_index = 0;
-    while (left_index < num_keys &&
-           branches[left_index].child_page_number != left_num)
-        ++left_index;
-
-    return left_index + 1;
+    return key_search::find_child(parent.branches(), parent.header().num_keys,
+                                  left_num) +
+           1;
 }
 
 int get_neighbor_index(const Page& parent, pagenum_t node)
 {
-    const pagenum_t pagenum = node;
-    const int num_keys = parent.header().num_keys;
-    const auto branches = parent.branches();
-    for (int i = -1; i < num_keys; ++i)
-    {
-        const pagenum_t j = (i == -1) ? parent.header().page_a_number
-                                      : branches[i].child_page_number;
+    if (parent.header().page_a_number == node)
+        return -1;
 
-        if (j == pagenum)
-            return i;
-    }
+    return key_search::find_child(parent.branches(), parent.header().num_keys,
+                                  node);
+}
 
-    return num_keys;
+template <typename T>
+int lower_bound_key(T* data, int size, int64_t key)
+{
+    return key_search::lower_bound(data, size, key);
 }
 
 template <typename T>
 int binary_search_key(T* data, int size, int64_t key)
 {
-    const auto end = data + size;
+    const int i = lower_bound_key(data, size, key);
+    if (i == size || data[i].key != key)
+        return size;
 
-    auto it = std::lower_bound(data, end, key, [](const auto& lhs, auto rhs) {
-        return lhs.key < rhs;
-    });
+    return i;
+}
 
-    if (it == end || (*it).key != key)
-        return size;
+// the key after the record copied last, or the end of the scan
+void advance_scan(ScanCursor& cursor, int64_t key)
+{
+    if (key >= cursor.hi)
+        cursor.done = true;
+    else
+        cursor.next_key = key + 1;
+}
 
-    return std::distance(data, it);
+// reads a page without latching it. returns false when the page was
+// modified meanwhile, what func has read must not be used then.
+template <typename Function>
+bool read_optimistic(Table& table, pagenum_t pagenum, Function&& func)
+{
+    bool valid = false;
+    const bool success = buffer(
+        [&](Page& page) {
+            const auto version = page.begin_read();
+            if (!version.has_value())
+                return;
+
+            func(page);
+            valid = page.validate(version.value());
+        },
+        table, pagenum, PageLatch::NONE);
+
+    return success && valid;
+}
+
+// the node of a mapped file, nullptr when the page is past the end of the
+// file or holds more keys than a node of its kind, as a broken page may
+const page_t* mapped_node(const MappedFile& file, pagenum_t pagenum)
+{
+    const page_t* page = file.page(pagenum);
+    if (page == nullptr)
+        return nullptr;
+
+    const page_header_t& header = page->node.header;
+    const int max_keys = header.is_leaf ? BPTree::LEAF_ORDER - 1
+                                        : BPTree::INTERNAL_ORDER - 1;
+
+    return (header.num_keys >= 0 && header.num_keys <= max_keys) ? page
+                                                                 : nullptr;
 }
 }  // namespace
 
-bool BPTree::initialize(int num_buf)
+double LeafLayout::fragmentation() const
+{
+    if (num_leaves < 2)
+        return 0;
+
+    return 1.0 - static_cast<double>(sequential) / (num_leaves - 1);
+}
+
+uint64_t CompactionStats::reclaimed_bytes() const
+{
+    return truncated_pages * PAGE_SIZE;
+}
+
+CompactionStats& CompactionStats::operator+=(const CompactionStats& other)
 {
-    return BufferManager::initialize(num_buf);
+    merged_leaves += other.merged_leaves;
+    moved_pages += other.moved_pages;
+    truncated_pages += other.truncated_pages;
+    done = other.done;
+
+    return *this;
+}
+
+bool BPTree::initialize(int num_buf, const DBConfig& config)
+{
+    CHECK_FAILURE(is_valid(config.tree_policy));
+
+    tree_policy_ = config.tree_policy;
+    optimistic_reads_ = config.optimistic_reads;
+    split_placement_ = config.split_placement;
+
+    CHECK_FAILURE(key_search::set_kernel(
+        config.simd_search ? key_search::detect() : SearchKernel::SCALAR));
+
+    return BufferManager::initialize(num_buf, config);
 }
 
 bool BPTree::shutdown()
@@ -82,19 +155,37 @@ bool BPTree::shutdown()
 
 bool BPTree::open_table(Table& table)
 {
+    table.set_policy(tree_policy_);
+
+    // a read only table never has its pages in the buffer
+    if (table.read_only())
+        return FileMgr().open_table(table);
+
     return BufMgr().open_table(table);
 }
 
 bool BPTree::close_table(Table& table)
 {
+    if (table.read_only())
+        return FileMgr().close_table(table);
+
     return BufMgr().close_table(table);
 }
 
 bool BPTree::insert(Table& table, const page_data_t& record)
 {
-    // case 1 : duplicated key
-    if (find(table, record.key))
-        return false;
+    CHECK_FAILURE(!table.read_only());
+
+    {
+        std::shared_lock tree_lock(table.tree_latch());
+
+        if (auto result = try_insert_into_leaf(table, record);
+            result.has_value())
+            return result.value();
+    }
+
+    // the leaf has to be split, so no one else may traverse the tree
+    std::unique_lock tree_lock(table.tree_latch());
 
     pagenum_t root_page_number;
     CHECK_FAILURE(buffer(
@@ -103,7 +194,7 @@ bool BPTree::insert(Table& table, const page_data_t& record)
         },
         table));
 
-    // case 2 : tree does not exist
+    // case 1 : tree does not exist
     if (root_page_number == NULL_PAGE_NUM)
     {
         const auto new_node = make_node(table, true);
@@ -130,11 +221,21 @@ bool BPTree::insert(Table& table, const page_data_t& record)
     }
 
     const pagenum_t leaf = find_leaf(table, record.key);
+    CHECK_FAILURE(leaf != NULL_PAGE_NUM);
 
     int leaf_num_keys = 0;
-    CHECK_FAILURE(
-        buffer([&](Page& leaf) { leaf_num_keys = leaf.header().num_keys; },
-               table, leaf));
+    bool duplicated = false;
+    CHECK_FAILURE(buffer(
+        [&](Page& leaf) {
+            leaf_num_keys = leaf.header().num_keys;
+            duplicated = binary_search_key(leaf.data(), leaf_num_keys,
+                                           record.key) != leaf_num_keys;
+        },
+        table, leaf, PageLatch::SHARED));
+
+    // case 2 : duplicated key
+    if (duplicated)
+        return false;
 
     // case 3-1 : leaf has room for key
     if (leaf_num_keys < LEAF_ORDER - 1)
@@ -147,95 +248,600 @@ bool BPTree::insert(Table& table, const page_data_t& record)
 
 bool BPTree::remove(Table& table, int64_t key)
 {
-    auto record = find(table, key);
-    CHECK_FAILURE(record.has_value());
+    CHECK_FAILURE(!table.read_only());
+
+    {
+        std::shared_lock tree_lock(table.tree_latch());
+
+        if (auto result = try_remove_from_leaf(table, key); result.has_value())
+            return result.value();
+    }
+
+    // the leaf may be merged, so no one else may traverse the tree
+    std::unique_lock tree_lock(table.tree_latch());
 
     pagenum_t leaf = find_leaf(table, key);
     CHECK_FAILURE(leaf != NULL_PAGE_NUM);
 
+    bool found = false;
+    CHECK_FAILURE(buffer(
+        [&](Page& leaf) {
+            const int num_keys = leaf.header().num_keys;
+            found = binary_search_key(leaf.data(), num_keys, key) != num_keys;
+        },
+        table, leaf, PageLatch::SHARED));
+    CHECK_FAILURE(found);
+
     return delete_entry(table, leaf, key);
 }
 
 std::optional<page_data_t> BPTree::find(Table& table, int64_t key, Xact* xact)
 {
-    pagenum_t pid = find_leaf(table, key);
-    CHECK_FAILURE2(pid != NULL_PAGE_NUM, std::nullopt);
+    // no one writes a read only table, so no record lock is taken either
+    if (table.read_only())
+        return find_mapped(*table.mapped_file(), key);
 
     std::optional<page_data_t> result{ std::nullopt };
 
     Lock* lock_obj;
     bool need_wait = false;
+    bool deadlock = false;
     HierarchyID hid;
     CHECK_FAILURE2(
-        buffer(
+        with_leaf(table, key, PageLatch::SHARED,
+                  [&](Page& page) {
+                      const int num_keys = page.header().num_keys;
+                      int i = binary_search_key(page.data(), num_keys, key);
+
+                      CHECK_FAILURE(i != num_keys);
+
+                      hid = HierarchyID(table.id(), page.pagenum(), i);
+
+                      if (xact != nullptr)
+                      {
+                          switch (
+                              xact->add_lock(hid, LockType::SHARED, &lock_obj))
+                          {
+                              case LockAcquireResult::DEADLOCK:
+                              case LockAcquireResult::FAIL:
+                                  deadlock = true;
+                                  return true;
+
+                              case LockAcquireResult::NEED_TO_WAIT:
+                                  need_wait = true;
+                                  return true;
+
+                              default:
+                                  break;
+                          }
+                      }
+
+                      // not need to wait
+                      result = page.data()[i];
+
+                      return true;
+                  }),
+        std::nullopt);
+
+    // the transaction is aborted, and waits for a lock, without latches
+    if (deadlock)
+    {
+        CHECK_FAILURE2(XactMgr().abort(xact), std::nullopt);
+        return std::nullopt;
+    }
+
+    if (need_wait)
+    {
+        lock_obj->wait();
+
+        CHECK_FAILURE2(
+            buffer([&](Page& page) { result = page.data()[hid.offset]; }, table,
+                   hid.pagenum, PageLatch::SHARED),
+            std::nullopt);
+    }
+
+    return result;
+}
+
+struct BPTree::KeyBatch
+{
+    // indexes of the keys, sorted by key
+    std::vector<std::size_t> order;
+    // the keys of the order before it are resolved
+    std::size_t resolved{ 0 };
+
+    // the depth of the leaves in the current descent, once one is reached.
+    // the inner nodes above them are read without latches under the tree
+    // latch, as in find_leaf()
+    int leaf_depth{ -1 };
+
+    // the descent stops at the key of resolved, which the caller deals with
+    // once the latches are released, waiting for its lock if any
+    bool stopped{ false };
+    bool deadlock{ false };
+    Lock* lock_obj{ nullptr };
+    HierarchyID hid;
+
+    template <typename Key>
+    void sort(std::size_t size, Key&& key)
+    {
+        order.resize(size);
+        for (std::size_t i = 0; i < size; ++i)
+            order[i] = i;
+
+        // the same keys are kept in the order given
+        std::stable_sort(begin(order), end(order),
+                         [&](std::size_t lhs, std::size_t rhs) {
+                             return key(lhs) < key(rhs);
+                         });
+    }
+};
+
+struct BPTree::FindMany final : KeyBatch
+{
+    const std::vector<int64_t>& keys;
+    std::vector<std::optional<page_data_t>>& records;
+    Xact* xact;
+
+    FindMany(const std::vector<int64_t>& keys,
+             std::vector<std::optional<page_data_t>>& records, Xact* xact)
+        : keys(keys), records(records), xact(xact)
+    {
+        sort(keys.size(), [&](std::size_t i) { return keys[i]; });
+    }
+
+    [[nodiscard]] int64_t key_of(std::size_t i) const
+    {
+        return keys[i];
+    }
+
+    [[nodiscard]] int64_t key(std::size_t position) const
+    {
+        return key_of(order[position]);
+    }
+};
+
+struct BPTree::WriteMany final : KeyBatch
+{
+    const std::vector<page_data_t>& records;
+    std::vector<bool>& written;
+    Xact* xact;
+
+    WriteMany(const std::vector<page_data_t>& records,
+              std::vector<bool>& written, Xact* xact)
+        : records(records), written(written), xact(xact)
+    {
+        sort(records.size(), [&](std::size_t i) { return records[i].key; });
+    }
+
+    [[nodiscard]] const page_data_t& record(std::size_t position) const
+    {
+        return records[order[position]];
+    }
+
+    [[nodiscard]] int64_t key_of(std::size_t i) const
+    {
+        return records[i].key;
+    }
+
+    [[nodiscard]] int64_t key(std::size_t position) const
+    {
+        return key_of(order[position]);
+    }
+};
+
+bool BPTree::find_many(Table& table, const std::vector<int64_t>& keys,
+                       std::vector<std::optional<page_data_t>>& records,
+                       Xact* xact)
+{
+    records.assign(keys.size(), std::nullopt);
+
+    if (table.read_only())
+    {
+        for (std::size_t i = 0; i < keys.size(); ++i)
+            records[i] = find_mapped(*table.mapped_file(), keys[i]);
+
+        return true;
+    }
+
+    FindMany batch(keys, records, xact);
+
+    while (batch.resolved < keys.size())
+    {
+        {
+            // no node is split or merged while its pin is shared
+            std::shared_lock tree_lock(table.tree_latch());
+
+            CHECK_FAILURE(for_each_leaf(
+                table, batch, PageLatch::SHARED,
+                [&](Page& leaf, std::size_t first, std::size_t last) {
+                    find_in_leaf(table, leaf, batch, first, last);
+                    return true;
+                }));
+        }
+
+        // the transaction is aborted, and waits for a lock, without latches
+        if (batch.deadlock)
+        {
+            CHECK_FAILURE(XactMgr().abort(xact));
+            return false;
+        }
+
+        if (!batch.stopped)
+            break;
+
+        batch.lock_obj->wait();
+
+        CHECK_FAILURE(buffer(
             [&](Page& page) {
-                const int num_keys = page.header().num_keys;
-                int i = binary_search_key(page.data(), num_keys, key);
+                records[batch.order[batch.resolved]] =
+                    page.data()[batch.hid.offset];
+            },
+            table, batch.hid.pagenum, PageLatch::SHARED));
 
-                CHECK_FAILURE(i != num_keys);
+        // the rest is looked up again from the root
+        ++batch.resolved;
+        batch.stopped = false;
+    }
 
-                hid = HierarchyID(table.id(), pid, i);
+    return true;
+}
 
-                if (xact != nullptr)
-                {
-                    switch (xact->add_lock(hid, LockType::SHARED, &lock_obj))
+void BPTree::find_in_leaf(Table& table, Page& leaf, FindMany& batch,
+                          std::size_t first, std::size_t last)
+{
+    const int num_keys = leaf.header().num_keys;
+
+    for (std::size_t pos = first; pos < last; ++pos)
+    {
+        const int i = binary_search_key(leaf.data(), num_keys, batch.key(pos));
+        if (i != num_keys && batch.xact != nullptr)
+        {
+            batch.hid = HierarchyID(table.id(), leaf.pagenum(), i);
+            switch (batch.xact->add_lock(batch.hid, LockType::SHARED,
+                                         &batch.lock_obj))
+            {
+                case LockAcquireResult::DEADLOCK:
+                case LockAcquireResult::FAIL:
+                    batch.stopped = batch.deadlock = true;
+                    return;
+
+                case LockAcquireResult::NEED_TO_WAIT:
+                    batch.stopped = true;
+                    return;
+
+                default:
+                    break;
+            }
+        }
+
+        if (i != num_keys)
+            batch.records[batch.order[pos]] = leaf.data()[i];
+
+        batch.resolved = pos + 1;
+    }
+}
+
+bool BPTree::insert_many(Table& table, const std::vector<page_data_t>& records,
+                         std::vector<bool>& inserted)
+{
+    CHECK_FAILURE(!table.read_only());
+
+    inserted.assign(records.size(), false);
+    WriteMany batch(records, inserted, nullptr);
+
+    while (batch.resolved < records.size())
+    {
+        {
+            std::shared_lock tree_lock(table.tree_latch());
+
+            CHECK_FAILURE(for_each_leaf(
+                table, batch, PageLatch::EXCLUSIVE,
+                [&](Page& leaf, std::size_t first, std::size_t last) {
+                    for (std::size_t pos = first; pos < last; ++pos)
                     {
-                        case LockAcquireResult::DEADLOCK:
-                        case LockAcquireResult::FAIL:
-                            CHECK_FAILURE(XactMgr().abort(xact) && false);
+                        const int num_keys = leaf.header().num_keys;
+                        if (binary_search_key(leaf.data(), num_keys,
+                                              batch.key(pos)) == num_keys)
+                        {
+                            // the leaf has to be split
+                            if (num_keys == LEAF_ORDER - 1)
+                            {
+                                batch.stopped = true;
+                                return true;
+                            }
 
-                        case LockAcquireResult::NEED_TO_WAIT:
-                            need_wait = true;
-                            return true;
+                            inserted[batch.order[pos]] =
+                                insert_into_leaf(leaf, batch.record(pos));
+                        }
 
-                        default:
-                            break;
+                        batch.resolved = pos + 1;
                     }
-                }
 
-                // not need to wait
-                result = page.data()[i];
+                    return true;
+                }));
+        }
+
+        // the record splitting its leaf, or the first one of an empty tree,
+        // is inserted alone
+        if (batch.resolved < records.size())
+        {
+            inserted[batch.order[batch.resolved]] =
+                insert(table, batch.record(batch.resolved));
+            ++batch.resolved;
+        }
+
+        batch.stopped = false;
+    }
 
-                return true;
+    return true;
+}
+
+bool BPTree::update_many(Table& table, const std::vector<page_data_t>& records,
+                         std::vector<bool>& updated, Xact* xact)
+{
+    CHECK_FAILURE(!table.read_only());
+    CHECK_FAILURE(xact != nullptr);
+
+    updated.assign(records.size(), false);
+    WriteMany batch(records, updated, xact);
+
+    while (batch.resolved < records.size())
+    {
+        {
+            std::shared_lock tree_lock(table.tree_latch());
+
+            CHECK_FAILURE(for_each_leaf(
+                table, batch, PageLatch::EXCLUSIVE,
+                [&](Page& leaf, std::size_t first, std::size_t last) {
+                    update_in_leaf(table, leaf, batch, first, last);
+                    return true;
+                }));
+        }
+
+        // the transaction is aborted, and waits for a lock, without latches
+        if (batch.deadlock)
+        {
+            CHECK_FAILURE(XactMgr().abort(xact));
+            return false;
+        }
+
+        if (!batch.stopped)
+            break;
+
+        batch.lock_obj->wait();
+
+        const page_data_t& record = batch.record(batch.resolved);
+        CHECK_FAILURE(buffer(
+            [&](Page& page) {
+                page_data_t old_data = page.data()[batch.hid.offset];
+                memcpy(page.data()[batch.hid.offset].value, record.value,
+                       PAGE_DATA_VALUE_SIZE);
+                page.mark_dirty();
+
+                const lsn_t lsn = LogMgr().log_update(
+                    xact->id(), xact->last_lsn(), batch.hid,
+                    PAGE_DATA_VALUE_SIZE, old_data, record);
+                page.header().page_lsn = lsn;
+                xact->last_lsn(lsn);
             },
-            table, pid),
-        std::nullopt);
+            table, batch.hid.pagenum));
+
+        // the rest is updated again from the root
+        updated[batch.order[batch.resolved]] = true;
+        ++batch.resolved;
+        batch.stopped = false;
+    }
+
+    return true;
+}
+
+void BPTree::update_in_leaf(Table& table, Page& leaf, WriteMany& batch,
+                            std::size_t first, std::size_t last)
+{
+    const int num_keys = leaf.header().num_keys;
+
+    // the records of the keys found, locked at once
+    std::vector<std::size_t> positions;
+    std::vector<HierarchyID> hids;
+    for (std::size_t pos = first; pos < last; ++pos)
+    {
+        const int i = binary_search_key(leaf.data(), num_keys, batch.key(pos));
+        if (i != num_keys)
+        {
+            positions.push_back(pos);
+            hids.emplace_back(table.id(), leaf.pagenum(), i);
+        }
+    }
+
+    std::size_t num_acquired = 0;
+    const LockAcquireResult result =
+        hids.empty() ? LockAcquireResult::ACQUIRED
+                     : batch.xact->add_locks(hids, LockType::EXCLUSIVE,
+                                             num_acquired, &batch.lock_obj);
+
+    if (result == LockAcquireResult::DEADLOCK ||
+        result == LockAcquireResult::FAIL)
+    {
+        batch.stopped = batch.deadlock = true;
+        return;
+    }
+
+    // the records whose locks are acquired are logged together, the old
+    // values are taken one by one as a key may be given more than once
+    std::vector<page_data_t> old_data(num_acquired);
+    std::vector<RecordUpdate> updates;
+    updates.reserve(num_acquired);
+    for (std::size_t j = 0; j < num_acquired; ++j)
+    {
+        page_data_t& data = leaf.data()[hids[j].offset];
+        const page_data_t& record = batch.record(positions[j]);
+
+        old_data[j] = data;
+        memcpy(data.value, record.value, PAGE_DATA_VALUE_SIZE);
+
+        updates.push_back({ hids[j], old_data[j].value, record.value });
+        batch.written[batch.order[positions[j]]] = true;
+    }
+
+    if (!updates.empty())
+    {
+        leaf.mark_dirty();
+
+        const lsn_t lsn = LogMgr().log_updates(
+            batch.xact->id(), batch.xact->last_lsn(), updates);
+        leaf.header().page_lsn = lsn;
+        batch.xact->last_lsn(lsn);
+    }
+
+    if (result == LockAcquireResult::NEED_TO_WAIT)
+    {
+        batch.stopped = true;
+        batch.hid = hids[num_acquired];
+        batch.resolved = positions[num_acquired];
+        return;
+    }
+
+    batch.resolved = last;
+}
+
+bool BPTree::scan(Table& table, ScanCursor& cursor, Xact* xact)
+{
+    cursor.records.clear();
+    cursor.position = 0;
+
+    if (cursor.done)
+        return true;
+
+    if (table.read_only())
+        return scan_mapped(*table.mapped_file(), cursor);
+
+    TreeLatch& tree = table.tree_latch();
+
+    Lock* lock_obj = nullptr;
+    bool need_wait = false;
+    bool deadlock = false;
+    HierarchyID hid;
+    {
+        // no leaf is split, merged or moved while its records are copied
+        std::shared_lock tree_lock(tree);
+
+        pagenum_t leaf = cursor.next_leaf;
+        if (leaf == NULL_PAGE_NUM || !tree.validate(cursor.tree_version))
+            leaf = find_leaf(table, cursor.next_key);
+
+        // no writer is active under the shared latch
+        cursor.tree_version = tree.begin_read().value();
+
+        while (cursor.records.empty() && !cursor.done && !need_wait &&
+               !deadlock)
+        {
+            if (leaf == NULL_PAGE_NUM)
+            {
+                cursor.done = true;
+                break;
+            }
+
+            CHECK_FAILURE(buffer(
+                [&](Page& page) {
+                    const int num_keys = page.header().num_keys;
+                    for (int i = lower_bound_key(page.data(), num_keys,
+                                                 cursor.next_key);
+                         i < num_keys; ++i)
+                    {
+                        const page_data_t& record = page.data()[i];
+                        if (record.key > cursor.hi)
+                        {
+                            cursor.done = true;
+                            return;
+                        }
+
+                        if (xact != nullptr)
+                        {
+                            hid = HierarchyID(table.id(), page.pagenum(), i);
+                            switch (xact->add_lock(hid, LockType::SHARED,
+                                                   &lock_obj))
+                            {
+                                case LockAcquireResult::DEADLOCK:
+                                case LockAcquireResult::FAIL:
+                                    deadlock = true;
+                                    return;
+
+                                case LockAcquireResult::NEED_TO_WAIT:
+                                    need_wait = true;
+                                    return;
+
+                                default:
+                                    break;
+                            }
+                        }
+
+                        cursor.records.push_back(record);
+                    }
+
+                    leaf = page.header().page_a_number;
+                },
+                table, leaf, PageLatch::SHARED));
+
+            if (!cursor.records.empty())
+                advance_scan(cursor, cursor.records.back().key);
+
+            // the last leaf is done
+            if (leaf == NULL_PAGE_NUM)
+                cursor.done = true;
+
+            cursor.next_leaf = leaf;
+        }
+    }
+
+    // the transaction is aborted, and waits for a lock, without latches
+    if (deadlock)
+    {
+        CHECK_FAILURE(XactMgr().abort(xact));
+        return false;
+    }
 
     if (need_wait)
     {
         lock_obj->wait();
 
-        CHECK_FAILURE2(
-            buffer([&](Page& page) { result = page.data()[hid.offset]; }, table,
-                   pid),
-            std::nullopt);
+        page_data_t record;
+        CHECK_FAILURE(
+            buffer([&](Page& page) { record = page.data()[hid.offset]; },
+                   table, hid.pagenum, PageLatch::SHARED));
+
+        cursor.records.push_back(record);
+        advance_scan(cursor, record.key);
+
+        // the tree may have changed meanwhile
+        cursor.next_leaf = NULL_PAGE_NUM;
     }
 
-    return result;
+    return true;
 }
 
 bool BPTree::update(Table& table, int64_t key, const char* value, Xact* xact)
 {
-    pagenum_t leaf = find_leaf(table, key);
-    CHECK_FAILURE(leaf != NULL_PAGE_NUM);
+    CHECK_FAILURE(!table.read_only());
 
     Lock* lock_obj;
     bool need_wait = false;
+    bool deadlock = false;
     HierarchyID hid;
 
     page_data_t old_data, new_data;
     new_data.key = key;
     strncpy(new_data.value, value, PAGE_DATA_VALUE_SIZE);
 
-    CHECK_FAILURE(buffer(
-        [&](Page& page) {
+    CHECK_FAILURE(with_leaf(
+        table, key, PageLatch::EXCLUSIVE, [&](Page& page) {
             const int num_keys = page.header().num_keys;
             auto data = page.data();
 
             int i = binary_search_key(data, num_keys, key);
             CHECK_FAILURE(i != num_keys);
 
-            hid = HierarchyID(table.id(), leaf, i);
+            hid = HierarchyID(table.id(), page.pagenum(), i);
             old_data = data[i];
 
             if (xact != nullptr)
@@ -244,111 +850,567 @@ bool BPTree::update(Table& table, int64_t key, const char* value, Xact* xact)
                 {
                     case LockAcquireResult::DEADLOCK:
                     case LockAcquireResult::FAIL:
-                        CHECK_FAILURE(XactMgr().abort(xact) && false);
+                        deadlock = true;
+                        return true;
 
                     case LockAcquireResult::NEED_TO_WAIT:
                         need_wait = true;
                         return true;
 
-                    default:
-                        break;
-                }
-            }
+                    default:
+                        break;
+                }
+            }
+
+            // not need to wait
+            memcpy(page.data()[i].value, value, PAGE_DATA_VALUE_SIZE);
+            page.mark_dirty();
+
+            const lsn_t lsn =
+                LogMgr().log_update(xact->id(), xact->last_lsn(), hid,
+                                    PAGE_DATA_VALUE_SIZE, old_data, new_data); 
+            page.header().page_lsn = lsn;
+            xact->last_lsn(lsn);
+
+            return true;
+        }));
+
+    // the transaction is aborted, and waits for a lock, without latches
+    if (deadlock)
+    {
+        CHECK_FAILURE(XactMgr().abort(xact));
+        return false;
+    }
+
+    if (need_wait)
+    {
+        lock_obj->wait();
+
+        CHECK_FAILURE(buffer(
+            [&](Page& page) {
+                memcpy(page.data()[hid.offset].value, value,
+                       PAGE_DATA_VALUE_SIZE);
+                page.mark_dirty();
+
+                const lsn_t lsn = LogMgr().log_update(
+                    xact->id(), xact->last_lsn(), hid, PAGE_DATA_VALUE_SIZE,
+                    old_data, new_data);
+                page.header().page_lsn = lsn;
+                xact->last_lsn(lsn);
+            },
+            table, hid.pagenum));
+    }
+
+    return true;
+}
+
+bool BPTree::set_policy(Table& table, const TreePolicy& policy)
+{
+    CHECK_FAILURE(is_valid(policy));
+
+    std::unique_lock tree_lock(table.tree_latch());
+    table.set_policy(policy);
+
+    return true;
+}
+
+std::optional<LeafLayout> BPTree::leaf_layout(Table& table)
+{
+    CHECK_FAILURE2(!table.read_only(), std::nullopt);
+
+    // the sibling chain is not changed by splits and merges meanwhile
+    std::shared_lock tree_lock(table.tree_latch());
+
+    LeafLayout layout;
+
+    pagenum_t current = find_leftmost_leaf(table);
+    while (current != NULL_PAGE_NUM)
+    {
+        pagenum_t next;
+        CHECK_FAILURE2(
+            buffer([&](Page& leaf) { next = leaf.header().page_a_number; },
+                   table, current, PageLatch::SHARED),
+            std::nullopt);
+
+        ++layout.num_leaves;
+
+        if (next != NULL_PAGE_NUM)
+        {
+            if (next == current + 1)
+                ++layout.sequential;
+            else if (next < current)
+                ++layout.backward;
+
+            layout.total_distance +=
+                (next > current) ? next - current : current - next;
+        }
+
+        current = next;
+    }
+
+    return layout;
+}
+
+std::optional<CompactionStats> BPTree::compact(Table& table, int max_pages)
+{
+    CHECK_FAILURE2(!table.read_only() && max_pages > 0, std::nullopt);
+
+    // no one else traverses the tree during the batch
+    std::unique_lock tree_lock(table.tree_latch());
+
+    CompactionStats stats;
+    if (XactMgr().num_active() > 0)
+        return stats;
+
+    CompactionCursor& cursor = table.compaction_cursor();
+    int budget = max_pages;
+
+    if (cursor.phase == CompactionCursor::Phase::LEAVES)
+        CHECK_FAILURE2(compact_leaves(table, cursor, budget, stats),
+                       std::nullopt);
+
+    if (cursor.phase == CompactionCursor::Phase::NODES)
+        CHECK_FAILURE2(compact_nodes(table, cursor, budget, stats),
+                       std::nullopt);
+
+    if (stats.done)
+    {
+        CHECK_FAILURE2(BufMgr().trim_file(table, stats.truncated_pages),
+                       std::nullopt);
+
+        cursor = CompactionCursor();
+    }
+
+    return stats;
+}
+
+std::optional<uint64_t> BPTree::bulk_load(
+    Table& table, const std::function<bool(page_data_t&)>& next,
+    double fill_factor)
+{
+    CHECK_FAILURE2(!table.read_only(), std::nullopt);
+    CHECK_FAILURE2(fill_factor > 0 && fill_factor <= 1, std::nullopt);
+
+    // the nodes are written around the buffer pool, so no one else may
+    // traverse the tree until it is linked
+    std::unique_lock tree_lock(table.tree_latch());
+
+    pagenum_t root_page_number;
+    CHECK_FAILURE2(buffer(
+                       [&](Page& header) {
+                           root_page_number =
+                               header.header_page().root_page_number;
+                       },
+                       table),
+                   std::nullopt);
+    CHECK_FAILURE2(root_page_number == NULL_PAGE_NUM, std::nullopt);
+
+    BulkLoader loader(table, fill_factor);
+
+    bool loaded = true;
+    page_data_t record{};
+    while (loaded && next(record))
+    {
+        loaded = loader.add(record);
+        record = page_data_t{};
+    }
+
+    if (!loaded || !loader.finish())
+    {
+        CHECK_FAILURE2(loader.abort(), std::nullopt);
+        return std::nullopt;
+    }
+
+    if (loader.root() != NULL_PAGE_NUM)
+    {
+        CHECK_FAILURE2(buffer(
+                           [&](Page& header) {
+                               header.header_page().root_page_number =
+                                   loader.root();
+
+                               header.mark_dirty();
+                           },
+                           table),
+                       std::nullopt);
+    }
+
+    return loader.num_records();
+}
+
+pagenum_t BPTree::make_node(Table& table, bool is_leaf, pagenum_t near)
+{
+    pagenum_t pagenum;
+    CHECK_FAILURE2(
+        BufMgr().create_page(table, is_leaf, pagenum,
+                             split_placement_ ? near : NULL_PAGE_NUM),
+        NULL_PAGE_NUM);
+
+    return pagenum;
+}
+
+pagenum_t BPTree::find_leaf(Table& table, int64_t key)
+{
+    // the caller holds the tree latch, so the header and the inner pages
+    // can only be modified by itself
+    pagenum_t root_page_number;
+    CHECK_FAILURE2(buffer(
+                       [&](Page& header) {
+                           root_page_number =
+                               header.header_page().root_page_number;
+                       },
+                       table, NULL_PAGE_NUM, PageLatch::NONE),
+                   NULL_PAGE_NUM);
+
+    if (root_page_number == NULL_PAGE_NUM)
+        return NULL_PAGE_NUM;
+
+    pagenum_t current_num = root_page_number;
+
+    bool run = true;
+    while (run)
+    {
+        CHECK_FAILURE2(
+            buffer(
+                [&](Page& current) {
+                    if (current.header().is_leaf)
+                    {
+                        run = false;
+                        return;
+                    }
+
+                    const auto branches = current.branches();
+
+                    const int child_idx =
+                        key_search::upper_bound(
+                            branches, current.header().num_keys, key) -
+                        1;
+
+                    current_num = (child_idx == -1)
+                                      ? current.header().page_a_number
+                                      : branches[child_idx].child_page_number;
+                },
+                table, current_num, PageLatch::NONE),
+            NULL_PAGE_NUM);
+    }
+
+    return current_num;
+}
+
+pagenum_t BPTree::find_leftmost_leaf(Table& table)
+{
+    pagenum_t current;
+    CHECK_FAILURE2(buffer(
+                       [&](Page& header) {
+                           current = header.header_page().root_page_number;
+                       },
+                       table, NULL_PAGE_NUM, PageLatch::NONE),
+                   NULL_PAGE_NUM);
+
+    bool is_leaf = (current == NULL_PAGE_NUM);
+    while (!is_leaf)
+    {
+        CHECK_FAILURE2(buffer(
+                           [&](Page& node) {
+                               is_leaf = node.header().is_leaf;
+                               if (!is_leaf)
+                                   current = node.header().page_a_number;
+                           },
+                           table, current, PageLatch::NONE),
+                       NULL_PAGE_NUM);
+    }
+
+    return current;
+}
+
+const page_t* BPTree::find_leaf(const MappedFile& file, int64_t key)
+{
+    const page_t* header = file.page(NULL_PAGE_NUM);
+    CHECK_FAILURE2(header != nullptr, nullptr);
+
+    if (header->file.root_page_number == NULL_PAGE_NUM)
+        return nullptr;
+
+    // a broken page ends the traversal instead of leaving the map, and a
+    // cycle of child pointers once it is deeper than the file has pages
+    const page_t* current = mapped_node(file, header->file.root_page_number);
+    for (std::size_t depth = 0;
+         current != nullptr && !current->node.header.is_leaf; ++depth)
+    {
+        if (depth == file.num_pages())
+            return nullptr;
+
+        const auto& node = current->node;
+        const auto branches = node.branch;
+
+        const int child_idx =
+            key_search::upper_bound(branches, node.header.num_keys, key) - 1;
+
+        const pagenum_t child = (child_idx == -1)
+                                    ? node.header.page_a_number
+                                    : branches[child_idx].child_page_number;
+        current = mapped_node(file, child);
+    }
+
+    return current;
+}
+
+bool BPTree::scan_mapped(const MappedFile& file, ScanCursor& cursor)
+{
+    const page_t* leaf = (cursor.next_leaf != NULL_PAGE_NUM)
+                             ? mapped_node(file, cursor.next_leaf)
+                             : find_leaf(file, cursor.next_key);
+
+    for (std::size_t num_leaves = 0; cursor.records.empty() && !cursor.done;
+         ++num_leaves)
+    {
+        // a broken sibling pointer ends the scan as well, and a cycle of
+        // them after more leaves than the file has pages
+        if (leaf == nullptr || !leaf->node.header.is_leaf ||
+            num_leaves == file.num_pages())
+        {
+            cursor.done = true;
+            break;
+        }
+
+        const auto& node = leaf->node;
+        for (int i = lower_bound_key(node.data, node.header.num_keys,
+                                     cursor.next_key);
+             i < node.header.num_keys && !cursor.done; ++i)
+        {
+            if (node.data[i].key > cursor.hi)
+                cursor.done = true;
+            else
+                cursor.records.push_back(node.data[i]);
+        }
+
+        if (!cursor.records.empty())
+            advance_scan(cursor, cursor.records.back().key);
+
+        cursor.next_leaf = node.header.page_a_number;
+        if (cursor.next_leaf == NULL_PAGE_NUM)
+            cursor.done = true;
+        else
+            leaf = mapped_node(file, cursor.next_leaf);
+    }
+
+    return true;
+}
+
+std::optional<page_data_t> BPTree::find_mapped(const MappedFile& file,
+                                               int64_t key)
+{
+    const page_t* leaf = find_leaf(file, key);
+    CHECK_FAILURE2(leaf != nullptr, std::nullopt);
+
+    const int num_keys = leaf->node.header.num_keys;
+    const int i = binary_search_key(leaf->node.data, num_keys, key);
+    CHECK_FAILURE2(i != num_keys, std::nullopt);
+
+    return leaf->node.data[i];
+}
+
+std::optional<pagenum_t> BPTree::find_leaf_optimistic(Table& table,
+                                                      int64_t key,
+                                                      version_t tree_version)
+{
+    pagenum_t current_num;
+    CHECK_FAILURE2(read_optimistic(table, NULL_PAGE_NUM,
+                                   [&](Page& header) {
+                                       current_num = header.header_page()
+                                                         .root_page_number;
+                                   }),
+                   std::nullopt);
+
+    if (current_num == NULL_PAGE_NUM)
+        return NULL_PAGE_NUM;
+
+    bool is_leaf = false;
+    while (!is_leaf)
+    {
+        pagenum_t child_num = NULL_PAGE_NUM;
+        CHECK_FAILURE2(
+            read_optimistic(
+                table, current_num,
+                [&](Page& current) {
+                    is_leaf = current.header().is_leaf;
+                    if (is_leaf)
+                        return;
+
+                    // a torn read must not run past the page
+                    const int num_keys = std::clamp<int>(
+                        current.header().num_keys, 0, INTERNAL_ORDER - 1);
+                    const auto branches = current.branches();
+
+                    const int child_idx =
+                        key_search::upper_bound(branches, num_keys, key) - 1;
+
+                    child_num = (child_idx == -1)
+                                    ? current.header().page_a_number
+                                    : branches[child_idx].child_page_number;
+                }),
+            std::nullopt);
+
+        // a child pointer is followed only while no split or merge is running
+        CHECK_FAILURE2(table.tree_latch().validate(tree_version), std::nullopt);
 
-            // not need to wait
-            memcpy(page.data()[i].value, value, PAGE_DATA_VALUE_SIZE);
-            page.mark_dirty();
+        if (!is_leaf)
+            current_num = child_num;
+    }
 
-            const lsn_t lsn =
-                LogMgr().log_update(xact->id(), xact->last_lsn(), hid,
-                                    PAGE_DATA_VALUE_SIZE, old_data, new_data); 
-            page.header().page_lsn = lsn;
-            xact->last_lsn(lsn);
+    return current_num;
+}
 
-            return true;
-        },
-        table, leaf));
+template <typename Function>
+bool BPTree::with_leaf(Table& table, int64_t key, PageLatch latch,
+                       Function&& func)
+{
+    TreeLatch& tree = table.tree_latch();
 
-    if (need_wait)
+    for (int i = 0; optimistic_reads_ && i < MAX_OPTIMISTIC_RETRIES; ++i)
     {
-        lock_obj->wait();
-
+        const auto tree_version = tree.begin_read();
+        if (!tree_version.has_value())
+        {
+            // a split or merge is running
+            std::this_thread::yield();
+            continue;
+        }
+
+        const auto leaf = find_leaf_optimistic(table, key, tree_version.value());
+        if (!leaf.has_value())
+            continue;
+
+        if (leaf.value() == NULL_PAGE_NUM)
+        {
+            if (tree.validate(tree_version.value()))
+                return false;
+
+            continue;
+        }
+
+        bool valid = false;
+        bool result = false;
         CHECK_FAILURE(buffer(
             [&](Page& page) {
-                memcpy(page.data()[hid.offset].value, value,
-                       PAGE_DATA_VALUE_SIZE);
-                page.mark_dirty();
-
-                const lsn_t lsn = LogMgr().log_update(
-                    xact->id(), xact->last_lsn(), hid, PAGE_DATA_VALUE_SIZE,
-                    old_data, new_data);
-                page.header().page_lsn = lsn;
-                xact->last_lsn(lsn);
+                // once the leaf is latched, only a split or merge started
+                // after the traversal could have moved the key out of it
+                valid = tree.validate(tree_version.value());
+                if (valid)
+                    result = func(page);
             },
-            table, leaf));
+            table, leaf.value(), latch));
+
+        if (valid)
+            return result;
     }
 
-    return true;
-}
+    std::shared_lock tree_lock(tree);
 
-pagenum_t BPTree::make_node(Table& table, bool is_leaf)
-{
-    pagenum_t pagenum;
-    CHECK_FAILURE2(BufMgr().create_page(table, is_leaf, pagenum),
-                   NULL_PAGE_NUM);
+    const pagenum_t leaf = find_leaf(table, key);
+    CHECK_FAILURE(leaf != NULL_PAGE_NUM);
 
-    return pagenum;
+    return buffer(func, table, leaf, latch);
 }
 
-pagenum_t BPTree::find_leaf(Table& table, int64_t key)
+template <typename Batch, typename Function>
+bool BPTree::for_each_leaf(Table& table, Batch& batch, PageLatch latch,
+                           Function&& func)
 {
     pagenum_t root_page_number;
-    CHECK_FAILURE2(buffer(
-                       [&](Page& header) {
-                           root_page_number =
-                               header.header_page().root_page_number;
-                       },
-                       table),
-                   NULL_PAGE_NUM);
+    CHECK_FAILURE(buffer(
+        [&](Page& header) {
+            root_page_number = header.header_page().root_page_number;
+        },
+        table, NULL_PAGE_NUM, PageLatch::NONE));
 
     if (root_page_number == NULL_PAGE_NUM)
-        return NULL_PAGE_NUM;
+        return true;
 
-    pagenum_t current_num = root_page_number;
+    // the height may have changed since the last descent
+    batch.leaf_depth = -1;
 
-    bool run = true;
-    while (run)
-    {
-        CHECK_FAILURE2(
-            buffer(
-                [&](Page& current) {
-                    if (current.header().is_leaf)
-                    {
-                        run = false;
-                        return;
-                    }
+    return for_each_leaf(table, root_page_number, 0, batch, batch.resolved,
+                         batch.order.size(), latch, func);
+}
 
-                    const auto branches = current.branches();
+template <typename Batch, typename Function>
+bool BPTree::for_each_leaf(Table& table, pagenum_t node, int depth,
+                           Batch& batch, std::size_t first, std::size_t last,
+                           PageLatch latch, Function&& func)
+{
+    if (depth == batch.leaf_depth)
+    {
+        return buffer(
+            [&](Page& leaf) { return func(leaf, first, last); }, table, node,
+            latch);
+    }
 
-                    int child_idx = std::distance(
-                        branches,
-                        std::upper_bound(branches,
-                                         branches + current.header().num_keys,
-                                         key, [](auto lhs, const auto& rhs) {
-                                             return lhs < rhs.key;
-                                         }));
+    bool is_leaf = false;
+    CHECK_FAILURE(buffer(
+        [&](Page& page) {
+            is_leaf = page.header().is_leaf;
+            if (is_leaf)
+                return true;
 
-                    --child_idx;
+            // the keys going down to the same child share its pin
+            const int num_keys = page.header().num_keys;
+            auto branches = page.branches();
+            for (std::size_t pos = first; pos < last && !batch.stopped;)
+            {
+                const int child_idx =
+                    key_search::upper_bound(branches, num_keys,
+                                            batch.key(pos)) -
+                    1;
+
+                // up to the first key of the next child
+                std::size_t end = last;
+                if (child_idx + 1 < num_keys)
+                {
+                    const int64_t bound = branches[child_idx + 1].key;
+                    end = std::distance(
+                        begin(batch.order),
+                        std::partition_point(
+                            begin(batch.order) + pos, begin(batch.order) + last,
+                            [&](std::size_t i) {
+                                return batch.key_of(i) < bound;
+                            }));
+                }
 
-                    current_num = (child_idx == -1)
-                                      ? current.header().page_a_number
+                const pagenum_t child =
+                    (child_idx == -1) ? page.header().page_a_number
                                       : branches[child_idx].child_page_number;
-                },
-                table, current_num),
-            NULL_PAGE_NUM);
-    }
+                CHECK_FAILURE(for_each_leaf(table, child, depth + 1, batch,
+                                            pos, end, latch, func));
 
-    return current_num;
+                pos = end;
+            }
+
+            return true;
+        },
+        table, node, PageLatch::NONE));
+
+    if (!is_leaf)
+        return true;
+
+    // the first leaf reached is pinned again, latched this time
+    batch.leaf_depth = depth;
+
+    return for_each_leaf(table, node, depth, batch, first, last, latch, func);
+}
+
+int BPTree::merge_threshold(const Table& table, bool is_leaf)
+{
+    const int max_keys = is_leaf ? LEAF_ORDER - 1 : INTERNAL_ORDER - 1;
+
+    return static_cast<int>(table.policy().merge_threshold * max_keys);
+}
+
+int BPTree::split_pivot(const Table& table, int length, int min, int max)
+{
+    const int pivot =
+        static_cast<int>(std::ceil(length * table.policy().split_fill));
+
+    return std::clamp(pivot, min, max);
 }
 
 int BPTree::path_to_root(Table& table, pagenum_t child_num)
@@ -378,29 +1440,52 @@ int BPTree::path_to_root(Table& table, pagenum_t child_num)
     return length;
 }
 
-bool BPTree::insert_into_leaf(Table& table, pagenum_t leaf,
-                              const page_data_t& record)
+std::optional<bool> BPTree::try_insert_into_leaf(Table& table,
+                                                 const page_data_t& record)
 {
-    return buffer(
+    const pagenum_t leaf = find_leaf(table, record.key);
+    if (leaf == NULL_PAGE_NUM)
+        return std::nullopt;
+
+    std::optional<bool> result{ std::nullopt };
+    CHECK_FAILURE(buffer(
         [&](Page& leaf) {
             const int num_keys = leaf.header().num_keys;
-            auto data = leaf.data();
 
-            const int insertion_point = std::distance(
-                data, std::lower_bound(data, data + num_keys, record.key,
-                                       [](const auto& lhs, auto rhs) {
-                                           return lhs.key < rhs;
-                                       }));
+            if (binary_search_key(leaf.data(), num_keys, record.key) !=
+                num_keys)
+                result = false;
+            else if (num_keys < LEAF_ORDER - 1)
+                result = insert_into_leaf(leaf, record);
+        },
+        table, leaf));
+
+    return result;
+}
+
+bool BPTree::insert_into_leaf(Table& table, pagenum_t leaf,
+                              const page_data_t& record)
+{
+    return buffer([&](Page& leaf) { return insert_into_leaf(leaf, record); },
+                  table, leaf);
+}
 
-            for (int i = num_keys; i > insertion_point; --i)
-                data[i] = data[i - 1];
+bool BPTree::insert_into_leaf(Page& leaf, const page_data_t& record)
+{
+    const int num_keys = leaf.header().num_keys;
+    auto data = leaf.data();
 
-            data[insertion_point] = record;
-            ++leaf.header().num_keys;
+    const int insertion_point = lower_bound_key(data, num_keys, record.key);
 
-            leaf.mark_dirty();
-        },
-        table, leaf);
+    for (int i = num_keys; i > insertion_point; --i)
+        data[i] = data[i - 1];
+
+    data[insertion_point] = record;
+    ++leaf.header().num_keys;
+
+    leaf.mark_dirty();
+
+    return true;
 }
 
 bool BPTree::insert_into_parent(Table& table, pagenum_t left, pagenum_t right,
@@ -506,9 +1591,10 @@ bool BPTree::insert_into_leaf_after_splitting(Table& table, pagenum_t leaf,
                                               const page_data_t& record)
 {
     std::array<page_data_t, LEAF_ORDER> temp_data;
-    const int split_pivot = cut(LEAF_ORDER - 1);
+    // both leaves keep a record
+    const int pivot = split_pivot(table, LEAF_ORDER - 1, 1, LEAF_ORDER - 1);
 
-    const pagenum_t new_leaf = make_node(table, true);
+    const pagenum_t new_leaf = make_node(table, true, leaf);
     CHECK_FAILURE(new_leaf != NULL_PAGE_NUM);
 
     pagenum_t parent_page_number, page_a_number;
@@ -520,11 +1606,8 @@ bool BPTree::insert_into_leaf_after_splitting(Table& table, pagenum_t leaf,
             const int num_keys = leaf.header().num_keys;
             const auto data = leaf.data();
 
-            const int insertion_point = std::distance(
-                data,
-                std::lower_bound(
-                    data, data + (LEAF_ORDER - 1), record.key,
-                    [](const auto& lhs, auto rhs) { return lhs.key < rhs; }));
+            const int insertion_point =
+                lower_bound_key(data, LEAF_ORDER - 1, record.key);
 
             for (int i = 0, j = 0; i < num_keys; ++i, ++j)
             {
@@ -537,7 +1620,7 @@ bool BPTree::insert_into_leaf_after_splitting(Table& table, pagenum_t leaf,
 
             leaf.header().num_keys = 0;
 
-            for (int i = 0; i < split_pivot; ++i)
+            for (int i = 0; i < pivot; ++i)
             {
                 data[i] = temp_data[i];
                 ++leaf.header().num_keys;
@@ -554,7 +1637,7 @@ bool BPTree::insert_into_leaf_after_splitting(Table& table, pagenum_t leaf,
         [&](Page& new_leaf) {
             auto new_data = new_leaf.data();
 
-            for (int i = split_pivot, j = 0; i < LEAF_ORDER; ++i, ++j)
+            for (int i = pivot, j = 0; i < LEAF_ORDER; ++i, ++j)
             {
                 new_data[j] = temp_data[i];
                 ++new_leaf.header().num_keys;
@@ -578,9 +1661,11 @@ bool BPTree::insert_into_node_after_splitting(Table& table, pagenum_t old,
                                               int64_t key)
 {
     std::array<page_branch_t, INTERNAL_ORDER> temp_data;
-    const int split_pivot = cut(INTERNAL_ORDER);
+    // both nodes keep a key
+    const int pivot =
+        split_pivot(table, INTERNAL_ORDER, 2, INTERNAL_ORDER - 1);
 
-    const pagenum_t new_page = make_node(table, false);
+    const pagenum_t new_page = make_node(table, false, old);
     CHECK_FAILURE(new_page != NULL_PAGE_NUM);
 
     pagenum_t parent_page_number;
@@ -598,7 +1683,7 @@ bool BPTree::insert_into_node_after_splitting(Table& table, pagenum_t old,
             temp_data[left_index].child_page_number = right;
 
             old.header().num_keys = 0;
-            for (int i = 0; i < split_pivot - 1; ++i)
+            for (int i = 0; i < pivot - 1; ++i)
             {
                 branches[i] = temp_data[i];
                 ++old.header().num_keys;
@@ -615,10 +1700,10 @@ bool BPTree::insert_into_node_after_splitting(Table& table, pagenum_t old,
         [&](Page& new_page) {
             auto new_branches = new_page.branches();
 
-            k_prime = temp_data[split_pivot - 1].key;
+            k_prime = temp_data[pivot - 1].key;
             new_page.header().page_a_number =
-                temp_data[split_pivot - 1].child_page_number;
-            for (int i = split_pivot, j = 0; i < INTERNAL_ORDER; ++i, ++j)
+                temp_data[pivot - 1].child_page_number;
+            for (int i = pivot, j = 0; i < INTERNAL_ORDER; ++i, ++j)
             {
                 new_branches[j] = temp_data[i];
                 ++new_page.header().num_keys;
@@ -650,6 +1735,34 @@ bool BPTree::insert_into_node_after_splitting(Table& table, pagenum_t old,
     return insert_into_parent(table, old, new_page, k_prime);
 }
 
+std::optional<bool> BPTree::try_remove_from_leaf(Table& table, int64_t key)
+{
+    const pagenum_t leaf = find_leaf(table, key);
+    if (leaf == NULL_PAGE_NUM)
+        return false;
+
+    std::optional<bool> result{ std::nullopt };
+    CHECK_FAILURE(buffer(
+        [&](Page& leaf) {
+            const int num_keys = leaf.header().num_keys;
+
+            if (binary_search_key(leaf.data(), num_keys, key) == num_keys)
+            {
+                result = false;
+            }
+            else if (num_keys - 1 > merge_threshold(table, true))
+            {
+                remove_record_from_leaf(leaf, key);
+                leaf.mark_dirty();
+
+                result = true;
+            }
+        },
+        table, leaf));
+
+    return result;
+}
+
 bool BPTree::delete_entry(Table& table, pagenum_t node, int64_t key)
 {
     pagenum_t parent;
@@ -680,7 +1793,7 @@ bool BPTree::delete_entry(Table& table, pagenum_t node, int64_t key)
     if (root_page_number == node)
         return adjust_root(table, node);
 
-    if (node_num_keys > MERGE_THRESHOLD)
+    if (node_num_keys > merge_threshold(table, is_leaf))
         return true;
 
     int neighbor_index, k_prime_index;
@@ -715,7 +1828,15 @@ bool BPTree::delete_entry(Table& table, pagenum_t node, int64_t key)
         buffer([&](Page& left) { left_num_keys = left.header().num_keys; },
                table, left));
 
-    if (left_num_keys + node_num_keys < capacity)
+    // the neighbour gives an entry only when it stays above the threshold,
+    // and when the merged node would leave less free than the bias asks
+    const int merged_keys = left_num_keys + node_num_keys;
+    const int max_merged_keys = static_cast<int>(
+        (1 - table.policy().redistribution_bias) * (capacity - 1));
+
+    if (merged_keys < capacity &&
+        (merged_keys <= max_merged_keys ||
+         left_num_keys <= merge_threshold(table, is_leaf) + 1))
         return coalesce_nodes(table, parent, *left_ptr, *right_ptr, k_prime);
 
     return redistribute_nodes(table, parent, *left_ptr, *right_ptr,
@@ -1003,3 +2124,253 @@ bool BPTree::redistribute_nodes_to_right(Table& table, Page& parent, Page& left,
 
     return true;
 }
+
+bool BPTree::compact_leaves(Table& table, CompactionCursor& cursor,
+                            int& budget, CompactionStats& stats)
+{
+    pagenum_t leaf = cursor.next_key.has_value()
+                         ? find_leaf(table, cursor.next_key.value())
+                         : find_leftmost_leaf(table);
+
+    while (leaf != NULL_PAGE_NUM && budget > 0)
+    {
+        --budget;
+
+        bool merged;
+        CHECK_FAILURE(try_merge_leaf(table, leaf, merged));
+        if (merged)
+        {
+            // again, with the new right sibling
+            ++stats.merged_leaves;
+            continue;
+        }
+
+        // right after the previous leaf when the page is free, otherwise
+        // at least before where it is
+        pagenum_t moved;
+        CHECK_FAILURE(move_node(table, leaf, cursor.last_leaf + 1, moved));
+        if (moved != NULL_PAGE_NUM)
+        {
+            --budget;
+            ++stats.moved_pages;
+            leaf = moved;
+        }
+
+        cursor.last_leaf = leaf;
+        CHECK_FAILURE(buffer(
+            [&](Page& page) { leaf = page.header().page_a_number; }, table,
+            leaf, PageLatch::SHARED));
+    }
+
+    if (leaf == NULL_PAGE_NUM)
+    {
+        cursor.phase = CompactionCursor::Phase::NODES;
+        return true;
+    }
+
+    // the leaf holding the key when the next batch starts, even if it is
+    // split or merged meanwhile
+    return buffer(
+        [&](Page& page) {
+            if (page.header().num_keys > 0)
+                cursor.next_key = page.data()[0].key;
+        },
+        table, leaf, PageLatch::SHARED);
+}
+
+bool BPTree::compact_nodes(Table& table, CompactionCursor& cursor,
+                           int& budget, CompactionStats& stats)
+{
+    for (; budget > 0; --budget)
+    {
+        pagenum_t last;
+        CHECK_FAILURE(buffer(
+            [&](Page&) { last = table.file()->last_node_page(); }, table,
+            NULL_PAGE_NUM, PageLatch::SHARED));
+
+        pagenum_t moved = NULL_PAGE_NUM;
+        if (last != NULL_PAGE_NUM)
+            CHECK_FAILURE(move_node(table, last, NULL_PAGE_NUM + 1, moved));
+
+        if (moved == NULL_PAGE_NUM)
+        {
+            // no free page is left before the last node
+            stats.done = true;
+            return true;
+        }
+
+        ++stats.moved_pages;
+    }
+
+    return true;
+}
+
+bool BPTree::try_merge_leaf(Table& table, pagenum_t leaf, bool& merged)
+{
+    merged = false;
+
+    int num_keys;
+    pagenum_t parent, right;
+    CHECK_FAILURE(buffer(
+        [&](Page& leaf) {
+            num_keys = leaf.header().num_keys;
+            parent = leaf.header().parent_page_number;
+            right = leaf.header().page_a_number;
+        },
+        table, leaf, PageLatch::SHARED));
+
+    if (right == NULL_PAGE_NUM)
+        return true;
+
+    bool fits;
+    CHECK_FAILURE(buffer(
+        [&](Page& right) {
+            fits = right.header().parent_page_number == parent &&
+                   num_keys + right.header().num_keys <= COMPACTION_LEAF_FILL;
+        },
+        table, right, PageLatch::SHARED));
+
+    if (!fits)
+        return true;
+
+    // the key separating the leaves in their parent
+    int64_t k_prime;
+    CHECK_FAILURE(buffer(
+        [&](Page& parent) {
+            const int index = get_neighbor_index(parent, right);
+            CHECK_FAILURE(index >= 0 && index < parent.header().num_keys);
+
+            k_prime = parent.branches()[index].key;
+
+            return true;
+        },
+        table, parent, PageLatch::SHARED));
+
+    CHECK_FAILURE(coalesce_nodes(table, parent, leaf, right, k_prime));
+    merged = true;
+
+    return true;
+}
+
+bool BPTree::move_node(Table& table, pagenum_t node, pagenum_t first,
+                       pagenum_t& to)
+{
+    CHECK_FAILURE(BufMgr().move_page(table, node, first, to));
+    if (to == NULL_PAGE_NUM)
+        return true;
+
+    pagenum_t parent;
+    bool is_leaf;
+    std::vector<pagenum_t> children;
+    CHECK_FAILURE(buffer(
+        [&](Page& moved) {
+            parent = moved.header().parent_page_number;
+            is_leaf = moved.header().is_leaf;
+
+            if (!is_leaf)
+            {
+                const int num_keys = moved.header().num_keys;
+                children.push_back(moved.header().page_a_number);
+                for (int i = 0; i < num_keys; ++i)
+                    children.push_back(moved.branches()[i].child_page_number);
+            }
+        },
+        table, to, PageLatch::SHARED));
+
+    if (parent == NULL_PAGE_NUM)
+    {
+        CHECK_FAILURE(buffer(
+            [&](Page& header) {
+                header.header_page().root_page_number = to;
+
+                header.mark_dirty();
+            },
+            table));
+    }
+    else
+    {
+        CHECK_FAILURE(buffer(
+            [&](Page& parent) {
+                if (parent.header().page_a_number == node)
+                    parent.header().page_a_number = to;
+
+                const int num_keys = parent.header().num_keys;
+                for (int i = 0; i < num_keys; ++i)
+                {
+                    if (parent.branches()[i].child_page_number == node)
+                        parent.branches()[i].child_page_number = to;
+                }
+
+                parent.mark_dirty();
+            },
+            table, parent));
+    }
+
+    for (pagenum_t child : children)
+    {
+        CHECK_FAILURE(buffer(
+            [&](Page& child) {
+                child.header().parent_page_number = to;
+
+                child.mark_dirty();
+            },
+            table, child));
+    }
+
+    if (!is_leaf)
+        return true;
+
+    // the leaf before it in key order. it is the child before it in the
+    // parent, or else the last leaf below the key that separates the first
+    // ancestor not leftmost in its parent from the child before it.
+    pagenum_t left = NULL_PAGE_NUM;
+    for (pagenum_t child = to, current = parent; current != NULL_PAGE_NUM;)
+    {
+        int index;
+        int64_t k_prime;
+        pagenum_t before, up;
+        CHECK_FAILURE(buffer(
+            [&](Page& current) {
+                index = get_neighbor_index(current, child);
+                CHECK_FAILURE(index < current.header().num_keys);
+
+                if (index >= 0)
+                {
+                    k_prime = current.branches()[index].key;
+                    before = (index == 0)
+                                 ? current.header().page_a_number
+                                 : current.branches()[index - 1]
+                                       .child_page_number;
+                }
+
+                up = current.header().parent_page_number;
+
+                return true;
+            },
+            table, current, PageLatch::SHARED));
+
+        if (index >= 0)
+        {
+            left = (child == to) ? before : find_leaf(table, k_prime - 1);
+            CHECK_FAILURE(left != NULL_PAGE_NUM);
+            break;
+        }
+
+        child = current;
+        current = up;
+    }
+
+    if (left == NULL_PAGE_NUM)
+        return true;
+
+    return buffer(
+        [&](Page& left) {
+            if (left.header().page_a_number == node)
+            {
+                left.header().page_a_number = to;
+
+                left.mark_dirty();
+            }
+        },
+        table, left);
+}
@@ -4,23 +4,42 @@
 #include "page.h"
 
 #include <memory.h>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <thread>
 
-#include <iostream>
-
-void BufferBlock::lock(bool lock)
+void BufferBlock::lock(PageLatch latch)
 {
-    ++pin_count_;
+    assert(pin_count() > 0);
 
-    // if (lock)
-    //     mutex_.lock();
+    if (latch == PageLatch::SHARED)
+    {
+        latch_.lock_shared();
+    }
+    else if (latch == PageLatch::EXCLUSIVE)
+    {
+        latch_.lock();
+        version_.begin_write();
+    }
 }
 
-void BufferBlock::unlock()
+void BufferBlock::unlock(PageLatch latch)
 {
     assert(pin_count() > 0);
-    // mutex_.unlock();
-    --pin_count_;
+
+    if (latch == PageLatch::SHARED)
+    {
+        latch_.unlock_shared();
+    }
+    else if (latch == PageLatch::EXCLUSIVE)
+    {
+        version_.end_write();
+        latch_.unlock();
+    }
+
+    if (--pin_count_ == 0)
+        partition_->notify_unpinned();
 }
 
 page_t& BufferBlock::frame()
@@ -43,6 +62,12 @@ void BufferBlock::clear()
 
     is_dirty_ = false;
     pin_count_ = 0;
+    read_ahead_ = false;
+}
+
+void BufferBlock::pin()
+{
+    ++pin_count_;
 }
 
 int BufferBlock::pin_count() const
@@ -50,23 +75,543 @@ int BufferBlock::pin_count() const
     return pin_count_.load();
 }
 
-bool BufferManager::initialize(int num_buf)
+bool BufferPartition::init_frames(page_t* frames, int num_frames,
+                                  ReplacementPolicy policy)
+{
+    replacer_ = Replacer::create(policy, num_frames);
+    CHECK_FAILURE(replacer_ != nullptr);
+
+    block_tbl_ = PageTable(num_frames);
+
+    blocks_ = std::vector<BufferBlock>(num_frames);
+    for (int i = 0; i < num_frames; ++i)
+    {
+        BufferBlock& block = blocks_[i];
+        block.frame_ = &frames[i];
+        block.partition_ = this;
+
+        free_blocks_.emplace_back(&block);
+    }
+
+    return true;
+}
+
+template <typename Pred>
+bool BufferPartition::drop_blocks(std::unique_lock<std::mutex>& lock,
+                                  Pred&& pred, bool write_back)
+{
+    for (std::size_t i = 0; i < blocks_.size();)
+    {
+        BufferBlock* block = &blocks_[i];
+
+        if (block->table_id() == -1 || !pred(block))
+        {
+            ++i;
+            continue;
+        }
+
+        if (block->pin_count() > 0)
+        {
+            // the block may hold another page after waiting, check it again
+            wait_unpinned(lock, block);
+            continue;
+        }
+
+        const table_page_t tpid{ block->table_id(), block->pagenum() };
+
+        replacer_->erase(block);
+        if (!write_back)
+            block->is_dirty_ = false;
+        CHECK_FAILURE(clear_block(block));
+
+        block_tbl_.erase(tpid);
+        free_blocks_.emplace_back(block);
+        ++i;
+    }
+
+    return true;
+}
+
+bool BufferPartition::shutdown_frames()
+{
+    std::unique_lock lock(mutex_);
+
+    CHECK_FAILURE(drop_blocks(lock, [](BufferBlock*) { return true; }));
+
+    free_blocks_.clear();
+    blocks_.clear();
+
+    return true;
+}
+
+bool BufferPartition::close_table(table_id_t table_id)
+{
+    std::unique_lock lock(mutex_);
+
+    return drop_blocks(lock, [table_id](BufferBlock* block) {
+        return block->table_id() == table_id;
+    });
+}
+
+bool BufferPartition::drop_pages(table_id_t table_id, pagenum_t first,
+                                 pagenum_t end)
+{
+    std::unique_lock lock(mutex_);
+
+    return drop_blocks(
+        lock,
+        [table_id, first, end](BufferBlock* block) {
+            return block->table_id() == table_id &&
+                   block->pagenum() >= first && block->pagenum() < end;
+        },
+        false);
+}
+
+void BufferPartition::begin_flush(table_id_t table_id,
+                                  std::vector<BufferBlock*>& blocks,
+                                  lsn_t& page_lsn)
+{
+    std::scoped_lock lock(mutex_);
+
+    for (auto& block : blocks_)
+    {
+        // a frame in i/o is being read, or written back on its own. a pinned
+        // one may be changed by its writer before its log records are
+        // written, it is left to the single page write-backs.
+        if (block.table_id() == -1 || !block.is_dirty_ ||
+            block.io_in_progress_ || block.pin_count() > 0)
+            continue;
+
+        if (table_id != -1 && block.table_id() != table_id)
+            continue;
+
+        if (block.pagenum() != NULL_PAGE_NUM)
+            page_lsn = std::max<lsn_t>(page_lsn,
+                                       block.frame_->node.header.page_lsn);
+
+        // cleared before writing, so a concurrent modification is not lost
+        block.is_dirty_ = false;
+        block.io_in_progress_ = true;
+        block.pin();
+
+        blocks.emplace_back(&block);
+    }
+}
+
+void BufferPartition::end_flush(BufferBlock* block, bool written)
+{
+    std::scoped_lock lock(mutex_);
+
+    if (!written)
+        block->is_dirty_ = true;
+
+    block->io_in_progress_ = false;
+    --block->pin_count_;
+    block->cond_.notify_all();
+
+    if (waiters_.load() > 0)
+        unpin_cond_.notify_all();
+}
+
+bool BufferPartition::write_back_table(table_id_t table_id)
+{
+    std::unique_lock lock(mutex_);
+
+    for (std::size_t i = 0; i < blocks_.size();)
+    {
+        BufferBlock* block = &blocks_[i];
+
+        if ((table_id != -1 && block->table_id() != table_id) ||
+            (!block->is_dirty_ && !block->io_in_progress_))
+        {
+            ++i;
+            continue;
+        }
+
+        if (block->pin_count() > 0)
+        {
+            // the block may hold another page after waiting, check it again
+            wait_unpinned(lock, block);
+            continue;
+        }
+
+        CHECK_FAILURE(write_back(lock, block));
+        ++i;
+    }
+
+    return true;
+}
+
+BufferBlock* BufferPartition::get_block(Table& table, pagenum_t pagenum,
+                                        bool& read_ahead)
+{
+    const table_page_t tpid{ table.id(), pagenum };
+    const auto eviction_deadline =
+        std::chrono::steady_clock::now() + MAX_EVICTION_WAIT;
+
+    std::unique_lock lock(mutex_);
+
+    while (true)
+    {
+        if (BufferBlock* current = block_tbl_.find(tpid); current != nullptr)
+        {
+            // wait for the frame, not for the whole partition
+            if (current->io_in_progress_)
+            {
+                current->cond_.wait(lock);
+                continue;
+            }
+
+            current->pin();
+
+            replacer_->touch(current);
+            ++stats_.hits;
+
+            read_ahead = current->read_ahead_;
+            current->read_ahead_ = false;
+
+            return current;
+        }
+
+        BufferBlock* victim = find_victim();
+        if (victim == nullptr)
+        {
+            // every frame is pinned, back off until one is released
+            CHECK_FAILURE2(wait_any_unpinned(lock, eviction_deadline),
+                           nullptr);
+            continue;
+        }
+
+        // the page can be requested by others while it is written back,
+        // so look it up again afterwards
+        if (victim->is_dirty_)
+        {
+            CHECK_FAILURE2(write_back(lock, victim), nullptr);
+            ++stats_.writebacks;
+            continue;
+        }
+
+        if (victim->table_id() != -1)
+            CHECK_FAILURE2(eviction(victim), nullptr);
+
+        CHECK_FAILURE2(read_page(lock, victim, table, pagenum), nullptr);
+        ++stats_.misses;
+
+        read_ahead = true;
+
+        return victim;
+    }
+}
+
+bool BufferPartition::prefetch_block(Table& table, pagenum_t pagenum,
+                                     pagenum_t& next_leaf)
+{
+    const table_page_t tpid{ table.id(), pagenum };
+
+    next_leaf = NULL_PAGE_NUM;
+
+    std::unique_lock lock(mutex_);
+
+    BufferBlock* block;
+    while (true)
+    {
+        if (block = block_tbl_.find(tpid); block != nullptr)
+        {
+            if (block->io_in_progress_)
+            {
+                block->cond_.wait(lock);
+                continue;
+            }
+
+            break;
+        }
+
+        // a prefetch is only a hint, it does not wait for a pinned frame
+        BufferBlock* victim = find_victim();
+        if (victim == nullptr)
+            return false;
+
+        if (victim->is_dirty_)
+        {
+            CHECK_FAILURE(write_back(lock, victim));
+            ++stats_.writebacks;
+            continue;
+        }
+
+        if (victim->table_id() != -1)
+            CHECK_FAILURE(eviction(victim));
+
+        CHECK_FAILURE(read_page(lock, victim, table, pagenum));
+        ++stats_.prefetched;
+
+        victim->read_ahead_ = true;
+
+        --victim->pin_count_;
+        if (waiters_.load() > 0)
+            unpin_cond_.notify_all();
+
+        block = victim;
+        break;
+    }
+
+    // the page latch is not waited for under the partition latch, so the
+    // sibling link is skipped while the page is modified
+    if (pagenum != NULL_PAGE_NUM && block->latch_.try_lock_shared())
+    {
+        const page_header_t& header = block->frame_->node.header;
+        if (header.is_leaf)
+            next_leaf = header.page_a_number;
+
+        block->latch_.unlock_shared();
+    }
+
+    return true;
+}
+
+std::size_t BufferPartition::clean(double dirty_ratio, std::size_t max_pages)
+{
+    std::unique_lock lock(mutex_);
+
+    const std::size_t num_frames = blocks_.size();
+    const std::size_t dirty_limit = num_frames * dirty_ratio;
+
+    // frames this close to the victim end are cleaned regardless of ratio
+    const std::size_t horizon = std::max<std::size_t>(1, num_frames / 4);
+
+    std::size_t num_dirty = std::count_if(
+        begin(blocks_), end(blocks_),
+        [](const auto& block) { return block.is_dirty_.load(); });
+
+    std::vector<BufferBlock*> candidates;
+    replacer_->cold_blocks(candidates, num_frames);
+
+    std::size_t written = 0;
+    for (std::size_t i = 0; i < candidates.size() && written < max_pages; ++i)
+    {
+        if (i >= horizon && num_dirty <= dirty_limit)
+            break;
+
+        // the partition may have changed while the latch was released
+        BufferBlock* block = candidates[i];
+        if (!block->is_dirty_ || block->pin_count() > 0 ||
+            block->io_in_progress_ || block->table_id() == -1)
+            continue;
+
+        if (!write_back(lock, block))
+            break;
+
+        ++written;
+        if (num_dirty > 0)
+            --num_dirty;
+    }
+
+    stats_.cleaned += written;
+
+    return written;
+}
+
+void BufferPartition::add_stats(BufferStats& stats)
+{
+    std::scoped_lock lock(mutex_);
+
+    stats.hits += stats_.hits;
+    stats.misses += stats_.misses;
+    stats.evictions += stats_.evictions;
+    stats.writebacks += stats_.writebacks;
+    stats.cleaned += stats_.cleaned;
+    stats.prefetched += stats_.prefetched;
+}
+
+void BufferPartition::reset_stats()
+{
+    std::scoped_lock lock(mutex_);
+
+    stats_ = BufferStats();
+}
+
+BufferBlock* BufferPartition::find_victim()
+{
+    if (!free_blocks_.empty())
+    {
+        BufferBlock* block = free_blocks_.back();
+        free_blocks_.pop_back();
+
+        return block;
+    }
+
+    return replacer_->victim();
+}
+
+bool BufferPartition::write_back(std::unique_lock<std::mutex>& lock,
+                                 BufferBlock* block)
+{
+    block->pin();
+    block->io_in_progress_ = true;
+
+    lock.unlock();
+    const bool success = flush_block(block);
+    lock.lock();
+
+    block->io_in_progress_ = false;
+    --block->pin_count_;
+    block->cond_.notify_all();
+
+    if (waiters_.load() > 0)
+        unpin_cond_.notify_all();
+
+    return success;
+}
+
+void BufferPartition::wait_unpinned(std::unique_lock<std::mutex>& lock,
+                                    BufferBlock* block)
+{
+    ++waiters_;
+    unpin_cond_.wait(lock, [block] { return block->pin_count() == 0; });
+    --waiters_;
+}
+
+bool BufferPartition::wait_any_unpinned(
+    std::unique_lock<std::mutex>& lock,
+    std::chrono::steady_clock::time_point deadline)
+{
+    ++waiters_;
+    const bool timeout =
+        unpin_cond_.wait_until(lock, deadline) == std::cv_status::timeout;
+    --waiters_;
+
+    return !timeout;
+}
+
+void BufferPartition::notify_unpinned()
+{
+    if (waiters_.load() == 0)
+        return;
+
+    // taking the latch orders this notification after the waiter's check
+    std::scoped_lock lock(mutex_);
+    unpin_cond_.notify_all();
+}
+
+bool BufferPartition::read_page(std::unique_lock<std::mutex>& lock,
+                                BufferBlock* victim, Table& table,
+                                pagenum_t pagenum)
+{
+    const table_page_t tpid{ table.id(), pagenum };
+
+    // reserve the frame, then read the page without the partition latch
+    victim->table_id_ = table.id();
+    victim->pagenum_ = pagenum;
+    victim->io_in_progress_ = true;
+    victim->pin();
+
+    block_tbl_.insert(tpid, victim);
+
+    lock.unlock();
+    const bool success = table.file()->file_read_page(pagenum, victim->frame_);
+    lock.lock();
+
+    victim->io_in_progress_ = false;
+    victim->cond_.notify_all();
+
+    if (!success)
+    {
+        block_tbl_.erase(tpid);
+        victim->clear();
+        free_blocks_.emplace_back(victim);
+
+        return false;
+    }
+
+    replacer_->insert(victim);
+
+    return true;
+}
+
+BufferBlock* BufferPartition::eviction(BufferBlock* block)
+{
+    const table_id_t table_id = block->table_id();
+    const pagenum_t pagenum = block->pagenum();
+
+    replacer_->erase(block);
+
+    CHECK_FAILURE2(clear_block(block), nullptr);
+    block_tbl_.erase({ table_id, pagenum });
+
+    ++stats_.evictions;
+
+    return block;
+}
+
+bool BufferPartition::flush_block(BufferBlock* block)
+{
+    if (!block->is_dirty_)
+        return true;
+
+    const table_id_t table_id = block->table_id();
+    const pagenum_t pagenum = block->pagenum();
+
+    // WAL: the log records of this page must be on the disk before the page
+    if (pagenum != NULL_PAGE_NUM)
+    {
+        const lsn_t page_lsn = block->frame_->node.header.page_lsn;
+        if (page_lsn != NULL_LSN && page_lsn >= LogMgr().flushed_lsn())
+            CHECK_FAILURE(LogMgr().force());
+    }
+
+    // cleared before writing, so a concurrent modification is not lost
+    block->is_dirty_ = false;
+
+    if (!TblMgr().get_table(table_id).value()->file()->file_write_page(
+            pagenum, block->frame_))
+    {
+        block->is_dirty_ = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool BufferPartition::clear_block(BufferBlock* block)
+{
+    CHECK_FAILURE(flush_block(block));
+
+    block->clear();
+
+    return true;
+}
+
+bool BufferManager::initialize(int num_buf, const DBConfig& config)
 {
     CHECK_FAILURE(instance_ == nullptr);
 
     instance_ = new (std::nothrow) BufferManager;
     CHECK_FAILURE(instance_ != nullptr);
 
-    CHECK_FAILURE(instance_->init_lru(num_buf));
+    CHECK_FAILURE(instance_->init_partitions(num_buf, config));
+
+    CHECK_FAILURE(FileManager::initialize(config));
+
+    if (config.cleaner_interval_ms > 0)
+    {
+        instance_->cleaner_ =
+            std::thread(&BufferManager::cleaner_main, instance_, config);
+    }
+
+    instance_->read_ahead_pages_ = config.read_ahead_pages;
+    instance_->prefetcher_ =
+        std::thread(&BufferManager::prefetcher_main, instance_);
 
-    return FileManager::initialize();
+    return true;
 }
 
 bool BufferManager::shutdown()
 {
     CHECK_FAILURE(instance_ != nullptr);
 
-    CHECK_FAILURE(instance_->shutdown_lru());
+    instance_->stop_cleaner();
+    instance_->stop_prefetcher();
+
+    CHECK_FAILURE(instance_->shutdown_partitions());
 
     CHECK_FAILURE(FileManager::shutdown());
 
@@ -81,86 +626,307 @@ BufferManager& BufferManager::get_instance()
     return *instance_;
 }
 
-bool BufferManager::init_lru(int num_buf)
+void BufferManager::cleaner_main(DBConfig config)
+{
+    const auto interval =
+        std::chrono::milliseconds(config.cleaner_interval_ms);
+    const std::size_t max_pages = std::max(1, config.cleaner_batch_pages);
+
+    std::unique_lock lock(cleaner_mutex_);
+
+    while (!cleaner_cond_.wait_for(lock, interval,
+                                   [this] { return stop_cleaner_; }))
+    {
+        lock.unlock();
+
+        for (auto& part : partitions_)
+        {
+            part->clean(config.cleaner_dirty_ratio, max_pages);
+        }
+
+        lock.lock();
+    }
+}
+
+void BufferManager::stop_cleaner()
+{
+    if (!cleaner_.joinable())
+        return;
+
+    {
+        std::scoped_lock lock(cleaner_mutex_);
+        stop_cleaner_ = true;
+    }
+    cleaner_cond_.notify_all();
+
+    cleaner_.join();
+}
+
+void BufferManager::enqueue_prefetch(const PrefetchRequest& request)
+{
+    {
+        std::scoped_lock lock(prefetch_mutex_);
+
+        if (prefetch_queue_.size() >= MAX_PREFETCH_QUEUE)
+            return;
+
+        prefetch_queue_.emplace_back(request);
+    }
+    prefetch_cond_.notify_all();
+}
+
+void BufferManager::prefetcher_main()
+{
+    std::unique_lock lock(prefetch_mutex_);
+
+    while (true)
+    {
+        prefetch_cond_.wait(lock, [this] {
+            return stop_prefetcher_ || !prefetch_queue_.empty();
+        });
+
+        if (stop_prefetcher_)
+            return;
+
+        const PrefetchRequest request = prefetch_queue_.front();
+        prefetch_queue_.pop_front();
+
+        prefetching_ = request.table;
+        lock.unlock();
+
+        Table& table = *request.table;
+
+        // pages past the end of the file are never read
+        const pagenum_t num_pages = table.file()->num_pages();
+
+        pagenum_t pagenum = request.pagenum;
+        for (int i = 0; i < request.depth; ++i)
+        {
+            if (pagenum == NULL_PAGE_NUM || pagenum >= num_pages)
+                break;
+
+            pagenum_t next_leaf;
+            if (!partition(table.id(), pagenum)
+                     .prefetch_block(table, pagenum, next_leaf))
+                break;
+
+            pagenum = next_leaf;
+        }
+
+        lock.lock();
+        prefetching_ = nullptr;
+        prefetch_cond_.notify_all();
+    }
+}
+
+void BufferManager::stop_prefetcher()
+{
+    if (!prefetcher_.joinable())
+        return;
+
+    {
+        std::scoped_lock lock(prefetch_mutex_);
+        stop_prefetcher_ = true;
+    }
+    prefetch_cond_.notify_all();
+
+    prefetcher_.join();
+}
+
+void BufferManager::cancel_prefetch(Table& table)
+{
+    std::unique_lock lock(prefetch_mutex_);
+
+    prefetch_queue_.erase(
+        std::remove_if(begin(prefetch_queue_), end(prefetch_queue_),
+                       [&table](const PrefetchRequest& request) {
+                           return request.table == &table;
+                       }),
+        end(prefetch_queue_));
+
+    prefetch_cond_.wait(lock, [&] { return prefetching_ != &table; });
+}
+
+void BufferManager::detect_sequential(Table& table, Page& page,
+                                      PageLatch latch)
+{
+    if (read_ahead_pages_ <= 0)
+        return;
+
+    const pagenum_t pagenum = page.pagenum();
+
+    // the header of a page is only read under its latch
+    const bool is_leaf = latch != PageLatch::NONE &&
+                         pagenum != NULL_PAGE_NUM && page.header().is_leaf;
+    const pagenum_t next_leaf =
+        is_leaf ? page.header().page_a_number : NULL_PAGE_NUM;
+
+    pagenum_t first = NULL_PAGE_NUM, last = NULL_PAGE_NUM;
+    bool siblings = false;
+    {
+        std::scoped_lock lock(read_ahead_mutex_);
+        ReadAhead& state = read_ahead_[table.id()];
+
+        // along the file, ahead of the run by half the window at least
+        if (pagenum == state.last_pagenum + 1)
+        {
+            ++state.run;
+        }
+        else
+        {
+            state.run = 1;
+            state.ahead_until = NULL_PAGE_NUM;
+        }
+        state.last_pagenum = pagenum;
+
+        if (state.run >= READ_AHEAD_TRIGGER &&
+            pagenum + read_ahead_pages_ / 2 >= state.ahead_until)
+        {
+            first = std::max(pagenum, state.ahead_until) + 1;
+            last = pagenum + read_ahead_pages_;
+            state.ahead_until = last;
+        }
+
+        // along the sibling chain, which is not in file order after splits
+        if (is_leaf)
+        {
+            if (pagenum == state.next_leaf)
+            {
+                ++state.leaf_run;
+            }
+            else
+            {
+                state.leaf_run = 1;
+                state.leaves_ahead = 0;
+            }
+            state.next_leaf = next_leaf;
+
+            if (state.leaves_ahead > 0)
+                --state.leaves_ahead;
+
+            if (state.leaf_run >= READ_AHEAD_TRIGGER &&
+                next_leaf != NULL_PAGE_NUM &&
+                state.leaves_ahead <= read_ahead_pages_ / 2)
+            {
+                siblings = true;
+                state.leaves_ahead = read_ahead_pages_;
+            }
+        }
+    }
+
+    for (pagenum_t i = first; i != NULL_PAGE_NUM && i <= last; ++i)
+        prefetch(table, i);
+
+    if (siblings)
+        prefetch_siblings(table, next_leaf, read_ahead_pages_);
+}
+
+bool BufferManager::init_partitions(int num_buf, const DBConfig& config)
 {
     if (num_buf <= 0)
     {
         return false;
     }
 
-    page_arr_ = new (std::nothrow) page_t[num_buf];
-    CHECK_FAILURE(page_arr_ != nullptr);
+    int num_partitions = config.buffer_partitions;
+    if (num_partitions <= 0)
+    {
+        const int max_partitions = std::max<int>(
+            1, 2 * std::thread::hardware_concurrency());
+
+        num_partitions = std::clamp(num_buf / MIN_FRAMES_PER_PARTITION, 1,
+                                    max_partitions);
+    }
+    num_partitions = std::min(num_partitions, num_buf);
+
+    CHECK_FAILURE(frame_arena_.allocate(num_buf, config));
 
-    for (int i = 0; i < num_buf; ++i)
+    // spread the remainder so that partition sizes differ at most by one
+    page_t* frames = frame_arena_.frames();
+    for (int i = 0; i < num_partitions; ++i)
     {
-        BufferBlock* block = new (std::nothrow) BufferBlock;
-        CHECK_FAILURE(block != nullptr);
+        const int num_frames =
+            num_buf / num_partitions + (i < num_buf % num_partitions);
 
-        block->frame_ = &page_arr_[i];
+        auto part = std::make_unique<BufferPartition>();
+        CHECK_FAILURE(
+            part->init_frames(frames, num_frames, config.replacement_policy));
 
-        enqueue(block);
+        partitions_.emplace_back(std::move(part));
+        frames += num_frames;
     }
 
     return true;
 }
 
-bool BufferManager::shutdown_lru()
+bool BufferManager::shutdown_partitions()
 {
-    // list is empty
-    if (head_ == nullptr)
+    for (auto& part : partitions_)
     {
-        return true;
+        CHECK_FAILURE(part->shutdown_frames());
     }
 
-    BufferBlock* tmp;
-    BufferBlock* current = head_;
-    do
-    {
-        while (current->pin_count() > 0)
-            ;
+    partitions_.clear();
 
-        CHECK_FAILURE(clear_block(current));
+    frame_arena_.release();
 
-        tmp = current->next_;
-        delete current;
-        current = tmp;
-    } while (current != head_);
+    return true;
+}
 
-    delete[] page_arr_;
+BufferPartition& BufferManager::partition(table_id_t table_id,
+                                          pagenum_t pagenum)
+{
+    const std::size_t hash = std::hash<table_page_t>()({ table_id, pagenum });
 
-    return true;
+    return *partitions_[hash % partitions_.size()];
 }
 
-bool BufferManager::open_table(Table& table)
+int BufferManager::num_partitions() const
 {
-    return FileMgr().open_table(table);
+    return static_cast<int>(partitions_.size());
 }
 
-bool BufferManager::close_table(Table& table)
+BufferStats BufferManager::stats()
 {
-    const table_id_t tid = table.id();
+    BufferStats stats;
 
-    for (const auto& pr : block_tbl_)
+    for (auto& part : partitions_)
     {
-        if (pr.second->table_id() != tid)
-            continue;
+        part->add_stats(stats);
+    }
 
-        while (pr.second->pin_count() > 0)
-            ;
+    return stats;
+}
 
-        CHECK_FAILURE(clear_block(pr.second));
+void BufferManager::reset_stats()
+{
+    for (auto& part : partitions_)
+    {
+        part->reset_stats();
     }
+}
 
-    for (auto it = begin(block_tbl_); it != end(block_tbl_);)
+bool BufferManager::open_table(Table& table)
+{
     {
-        if (it->second->table_id() == tid)
-        {
-            it = block_tbl_.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
+        std::scoped_lock lock(read_ahead_mutex_);
+        read_ahead_[table.id()] = ReadAhead();
+    }
+
+    return FileMgr().open_table(table);
+}
+
+bool BufferManager::close_table(Table& table)
+{
+    cancel_prefetch(table);
+
+    // the frames are dropped one by one after they are clean, the pinned
+    // ones are written back by close_table() once they are unpinned
+    CHECK_FAILURE(flush_batch(table.id()));
+
+    for (auto& part : partitions_)
+    {
+        CHECK_FAILURE(part->close_table(table.id()));
     }
 
     return FileMgr().close_table(table);
@@ -168,23 +934,101 @@ bool BufferManager::close_table(Table& table)
 
 bool BufferManager::sync_all()
 {
-    std::scoped_lock lock(mutex_);
+    CHECK_FAILURE(flush_batch(-1));
 
-    for (auto& pr : block_tbl_)
+    // the batch leaves out the pinned frames
+    for (auto& part : partitions_)
     {
-        CHECK_FAILURE(clear_block(pr.second));
+        CHECK_FAILURE(part->write_back_table(-1));
     }
 
     return true;
 }
 
-bool BufferManager::create_page(Table& table, bool is_leaf, pagenum_t& pagenum)
+bool BufferManager::flush_batch(table_id_t table_id)
+{
+    std::vector<BufferBlock*> blocks;
+    lsn_t page_lsn = NULL_LSN;
+
+    for (auto& part : partitions_)
+    {
+        part->begin_flush(table_id, blocks, page_lsn);
+    }
+
+    // WAL: the log records of the pages must be on the disk before them
+    bool success = true;
+    if (page_lsn != NULL_LSN && page_lsn >= LogMgr().flushed_lsn())
+        success = LogMgr().force();
+
+    std::sort(begin(blocks), end(blocks),
+              [](BufferBlock* lhs, BufferBlock* rhs) {
+                  return lhs->table_id() < rhs->table_id();
+              });
+
+    std::vector<PageWrite> pages;
+    for (std::size_t first = 0; first < blocks.size();)
+    {
+        const table_id_t tid = blocks[first]->table_id();
+
+        std::size_t last = first;
+        pages.clear();
+        for (; last < blocks.size() && blocks[last]->table_id() == tid; ++last)
+        {
+            BufferBlock* block = blocks[last];
+            pages.push_back({ block->pagenum(), &block->frame() });
+        }
+
+        const bool written =
+            success &&
+            TblMgr().get_table(tid).value()->file()->file_write_pages(pages);
+
+        for (std::size_t i = first; i < last; ++i)
+            blocks[i]->partition_->end_flush(blocks[i], written);
+
+        success = success && written;
+        first = last;
+    }
+
+    return success;
+}
+
+bool BufferManager::create_page(Table& table, bool is_leaf, pagenum_t& pagenum,
+                                pagenum_t near)
 {
     pagenum = NULL_PAGE_NUM;
 
+    // the free space of the table is guarded by the header page latch
     return buffer(
         [&](Page& header) {
-            CHECK_FAILURE(table.file()->file_alloc_page(header, pagenum));
+            FreeSpaceMap& free_space = table.file()->free_space();
+
+            auto take = [&]() -> std::optional<pagenum_t> {
+                if (near != NULL_PAGE_NUM)
+                {
+                    if (auto free_page =
+                            free_space.allocate_near(near, PLACEMENT_DISTANCE);
+                        free_page.has_value())
+                        return free_page;
+                }
+
+                return free_space.allocate();
+            };
+
+            auto free_page = take();
+            if (!free_page.has_value())
+            {
+                const pagenum_t first = header.header_page().num_pages;
+                CHECK_FAILURE(table.file()->file_alloc_extent(header));
+                CHECK_FAILURE(store_free_bits(
+                    table, header, first,
+                    header.header_page().num_pages - first));
+
+                free_page = take();
+                CHECK_FAILURE(free_page.has_value());
+            }
+
+            pagenum = free_page.value();
+            CHECK_FAILURE(store_free_bits(table, header, pagenum, 1));
 
             return buffer(
                 [&](Page& new_page) {
@@ -205,154 +1049,197 @@ bool BufferManager::free_page(Table& table, pagenum_t pagenum)
 {
     return buffer(
         [&](Page& header) {
-            return buffer(
-                [&](Page& free_page) {
-                    free_page.free_header().next_free_page_number =
-                        header.header_page().free_page_number;
-
-                    header.header_page().free_page_number = pagenum;
+            table.file()->free_space().set_free(pagenum, true);
 
-                    free_page.mark_dirty();
-                    header.mark_dirty();
-
-                    return true;
-                },
-                table, pagenum);
+            return store_free_bits(table, header, pagenum, 1);
         },
         table);
 }
 
-bool BufferManager::get_page(Table& table, pagenum_t pagenum,
-                             std::optional<Page>& page, bool page_lock)
+bool BufferManager::move_page(Table& table, pagenum_t from, pagenum_t first,
+                              pagenum_t& to)
 {
-    std::scoped_lock lock(mutex_);
-
-    table_id_t table_id = table.id();
+    to = NULL_PAGE_NUM;
 
-    BufferBlock* current = head_;
-
-    auto it = block_tbl_.find({ table_id, pagenum });
-
-    if (it != end(block_tbl_))
-    {
-        current = it->second;
-        current->lock(page_lock);
-    }
-    else
-    {
-        if (current->table_id_ != -1)
-            current = eviction();
-
-        CHECK_FAILURE(current != nullptr);
-
-        current->lock(page_lock);
-
-        current->table_id_ = table_id;
-        current->pagenum_ = pagenum;
+    return buffer(
+        [&](Page& header) {
+            FreeSpaceMap& free_space = table.file()->free_space();
 
-        CHECK_FAILURE(table.file()->file_read_page(pagenum, current->frame_));
+            const auto free_page = free_space.allocate_in(first, from);
+            if (!free_page.has_value())
+                return true;
 
-        block_tbl_.insert_or_assign({ table_id, pagenum }, current);
-    }
+            to = free_page.value();
+            free_space.set_free(from, true);
 
-    unlink_and_enqueue(current);
-    page.emplace(*current);
+            CHECK_FAILURE(store_free_bits(table, header, to, 1));
+            CHECK_FAILURE(store_free_bits(table, header, from, 1));
 
-    return true;
+            return buffer(
+                [&](Page& source) {
+                    return buffer(
+                        [&](Page& target) {
+                            target.header() = source.header();
+                            memcpy(target.data(), source.data(),
+                                   PAGE_SIZE - PAGE_HEADER_SIZE);
+
+                            target.mark_dirty();
+                        },
+                        table, to);
+                },
+                table, from, PageLatch::SHARED);
+        },
+        table);
 }
 
-void BufferManager::enqueue(BufferBlock* block)
+bool BufferManager::trim_file(Table& table, uint64_t& num_pages)
 {
-    // <- past       new ->
-    //  head <> ... <> tail
-
-    assert((head_ == nullptr && tail_ == nullptr) ||
-           (head_ != nullptr && tail_ != nullptr));
+    num_pages = 0;
 
-    // when linked list is empty
-    if (head_ == nullptr)
-    {
-        head_ = block;
-        tail_ = block;
+    // no page past the new end is read ahead meanwhile
+    cancel_prefetch(table);
 
-        head_->next_ = block;
-        tail_->prev_ = block;
-    }
-    else
+    // the moved nodes, the root and the free bits they imply are only in
+    // the pool, they are durable before the file loses the old copies
+    CHECK_FAILURE(flush_batch(table.id()));
+    for (auto& part : partitions_)
     {
-        block->prev_ = tail_;
-        tail_->next_ = block;
-        tail_ = block;
+        CHECK_FAILURE(part->write_back_table(table.id()));
     }
 
-    head_->prev_ = tail_;
-    tail_->next_ = head_;
+    return buffer(
+        [&](Page& header) {
+            const uint64_t old_pages = header.header_page().num_pages;
+            const uint64_t new_pages = table.file()->last_node_page() + 1;
+            if (new_pages >= old_pages)
+                return true;
+
+            // dropped before the file is cut, so that none of them is
+            // written back past the end
+            for (auto& part : partitions_)
+            {
+                CHECK_FAILURE(
+                    part->drop_pages(table.id(), new_pages, old_pages));
+            }
+
+            CHECK_FAILURE(table.file()->file_truncate(header, new_pages));
+            num_pages = old_pages - new_pages;
+
+            return true;
+        },
+        table);
 }
 
-void BufferManager::unlink_and_enqueue(BufferBlock* block)
+bool BufferManager::allocate_run(Table& table, uint64_t count,
+                                 pagenum_t& first)
 {
-    BufferBlock* prev = block->prev_;
-    BufferBlock* next = block->next_;
+    first = NULL_PAGE_NUM;
 
-    block->prev_ = nullptr;
-    block->next_ = nullptr;
+    return buffer(
+        [&](Page& header) {
+            FreeSpaceMap& free_space = table.file()->free_space();
+
+            // a bitmap page may split an extent, the next one follows it
+            auto run = free_space.allocate_run(count);
+            while (!run.has_value())
+            {
+                const pagenum_t old_pages = header.header_page().num_pages;
+                CHECK_FAILURE(table.file()->file_alloc_extent(header));
+                CHECK_FAILURE(store_free_bits(
+                    table, header, old_pages,
+                    header.header_page().num_pages - old_pages));
+
+                run = free_space.allocate_run(count);
+            }
+
+            first = run.value();
+            CHECK_FAILURE(store_free_bits(table, header, first, count));
+
+            // freed pages may still be cached, and written back over the
+            // new ones
+            for (auto& part : partitions_)
+            {
+                CHECK_FAILURE(
+                    part->drop_pages(table.id(), first, first + count));
+            }
+
+            return true;
+        },
+        table);
+}
 
-    prev->next_ = next;
-    next->prev_ = prev;
+bool BufferManager::store_free_bits(Table& table, Page& header,
+                                    pagenum_t first, uint64_t count)
+{
+    const FreeSpaceMap& free_space = table.file()->free_space();
 
-    if (block == head_)
-    {
-        head_ = next;
-    }
-    if (block == tail_)
+    // a word at a time
+    const pagenum_t end = first + count;
+    pagenum_t pagenum = first - first % 64;
+
+    for (; pagenum < end && pagenum < File::HEADER_FREE_BITS; pagenum += 64)
     {
-        tail_ = prev;
+        header.header_page().free_bits[pagenum / 64] =
+            free_space.word(pagenum);
+        header.mark_dirty();
     }
 
-    enqueue(block);
-}
-
-BufferBlock* BufferManager::eviction()
-{
-    BufferBlock* victim = head_;
-    while (victim->pin_count() > 0)
+    while (pagenum < end)
     {
-        victim = victim->next_;
-        assert(victim != head_);
+        const pagenum_t bitmap_page = File::bitmap_page_of(pagenum);
+        const pagenum_t range_end =
+            std::min(end, bitmap_page + File::BITMAP_FREE_BITS);
+
+        CHECK_FAILURE(buffer(
+            [&](Page& bitmap) {
+                for (; pagenum < range_end; pagenum += 64)
+                {
+                    bitmap.bitmap_page().free_bits[(pagenum - bitmap_page) /
+                                                   64] =
+                        free_space.word(pagenum);
+                }
+
+                bitmap.mark_dirty();
+            },
+            table, bitmap_page));
     }
 
-    return eviction(victim);
+    return true;
 }
 
-BufferBlock* BufferManager::eviction(BufferBlock* block)
+bool BufferManager::get_page(Table& table, pagenum_t pagenum,
+                             std::optional<Page>& page, PageLatch latch)
 {
-    // dump_frame_stat();
+    bool read_ahead = false;
+    BufferBlock* block =
+        partition(table.id(), pagenum).get_block(table, pagenum, read_ahead);
+    CHECK_FAILURE(block != nullptr);
 
-    const table_id_t table_id = block->table_id();
-    const pagenum_t pagenum = block->pagenum();
+    // a latch is never waited for while the partition latch is held
+    block->lock(latch);
+    page.emplace(*block, latch);
 
-    CHECK_FAILURE2(clear_block(block), nullptr);
-    block_tbl_.erase({ table_id, pagenum });
+    // only reads are looked at, hits on cached pages stay cheap
+    if (read_ahead)
+        detect_sequential(table, page.value(), latch);
 
-    return block;
+    return true;
 }
 
-bool BufferManager::clear_block(BufferBlock* block)
+void BufferManager::prefetch(Table& table, pagenum_t pagenum)
 {
-    const table_id_t table_id = block->table_id();
-    const pagenum_t pagenum = block->pagenum();
-
-    if (block->is_dirty_)
-    {
-        if (LogMgr().find_page(table_id, pagenum))
-            CHECK_FAILURE(LogMgr().force());
-
-        CHECK_FAILURE(
-            TblMgr().get_table(table_id).value()->file()->file_write_page(
-                pagenum, block->frame_));
-    }
+    enqueue_prefetch({ &table, pagenum, 1 });
+}
 
-    block->clear();
+void BufferManager::prefetch(Table& table,
+                             const std::vector<pagenum_t>& pagenums)
+{
+    for (pagenum_t pagenum : pagenums)
+        prefetch(table, pagenum);
+}
 
-    return true;
+void BufferManager::prefetch_siblings(Table& table, pagenum_t leaf,
+                                      int depth)
+{
+    enqueue_prefetch({ &table, leaf, depth });
 }
@@ -0,0 +1,219 @@
+#include "bulk_load.h"
+
+#include "bpt.h"
+#include "buffer.h"
+#include "common.h"
+#include "table.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+int filled(double fill_factor, int capacity, int min)
+{
+    return std::clamp(static_cast<int>(std::lround(fill_factor * capacity)),
+                      min, capacity);
+}
+}  // namespace
+
+BulkLoader::BulkLoader(Table& table, double fill_factor)
+    : table_(table),
+      leaf_fill_(filled(fill_factor, BPTree::LEAF_ORDER - 1, 1)),
+      internal_fill_(filled(fill_factor, BPTree::INTERNAL_ORDER - 1, 2)),
+      levels_(1)
+{
+}
+
+bool BulkLoader::add(const page_data_t& record)
+{
+    CHECK_FAILURE(num_records_ == 0 || record.key > last_key_);
+
+    Node& leaf = levels_[0].open;
+    if (leaf.page == nullptr)
+    {
+        CHECK_FAILURE(open_node(leaf, true));
+        leaf.first_key = record.key;
+    }
+    else if (leaf.page->node.header.num_keys == leaf_fill_)
+    {
+        // the right sibling is known before the leaf is written
+        Node next;
+        CHECK_FAILURE(open_node(next, true));
+        next.first_key = record.key;
+
+        leaf.page->node.header.page_a_number = next.pagenum;
+
+        Node full = std::move(leaf);
+        leaf = std::move(next);
+        CHECK_FAILURE(close_node(0, full));
+    }
+
+    page_header_t& header = leaf.page->node.header;
+    leaf.page->node.data[header.num_keys++] = record;
+
+    last_key_ = record.key;
+    ++num_records_;
+
+    return true;
+}
+
+bool BulkLoader::finish()
+{
+    // a level placing its last node may open the one above it
+    for (std::size_t level = 0; num_records_ > 0; ++level)
+    {
+        Level& nodes = levels_[level];
+        if (nodes.open.page != nullptr)
+        {
+            Node last = std::move(nodes.open);
+            CHECK_FAILURE(close_node(level, last));
+        }
+
+        if (nodes.num_nodes == 1)
+        {
+            nodes.pending.page->node.header.parent_page_number =
+                NULL_PAGE_NUM;
+            root_ = nodes.pending.pagenum;
+            CHECK_FAILURE(write(nodes.pending));
+            break;
+        }
+
+        CHECK_FAILURE(place(level, nodes.pending, true));
+    }
+
+    CHECK_FAILURE(flush());
+
+    // the rest of the last runs is not used
+    for (PageRun* run : { &leaf_pages_, &internal_pages_ })
+    {
+        for (; run->left > 0; --run->left)
+        {
+            CHECK_FAILURE(BufMgr().free_page(table_, run->next++));
+        }
+    }
+
+    return true;
+}
+
+bool BulkLoader::abort()
+{
+    pending_writes_.clear();
+    writes_.clear();
+
+    for (const auto& [first, count] : runs_)
+    {
+        for (pagenum_t pagenum = first; pagenum < first + count; ++pagenum)
+        {
+            CHECK_FAILURE(BufMgr().free_page(table_, pagenum));
+        }
+    }
+
+    runs_.clear();
+    leaf_pages_ = PageRun();
+    internal_pages_ = PageRun();
+
+    return true;
+}
+
+uint64_t BulkLoader::num_records() const
+{
+    return num_records_;
+}
+
+pagenum_t BulkLoader::root() const
+{
+    return root_;
+}
+
+bool BulkLoader::open_node(Node& node, bool is_leaf)
+{
+    PageRun& run = is_leaf ? leaf_pages_ : internal_pages_;
+    if (run.left == 0)
+    {
+        CHECK_FAILURE(BufMgr().allocate_run(table_, RUN_PAGES, run.next));
+
+        runs_.emplace_back(run.next, RUN_PAGES);
+        run.left = RUN_PAGES;
+    }
+
+    node.page = std::make_unique<page_t>();
+    node.pagenum = run.next++;
+    --run.left;
+
+    page_header_t& header = node.page->node.header;
+    header.parent_page_number = NULL_PAGE_NUM;
+    header.is_leaf = is_leaf;
+    header.num_keys = 0;
+    header.page_lsn = 0;
+    header.page_a_number = NULL_PAGE_NUM;
+
+    return true;
+}
+
+bool BulkLoader::close_node(std::size_t level, Node& node)
+{
+    Level& nodes = levels_[level];
+    if (nodes.num_nodes++ > 0)
+        CHECK_FAILURE(place(level, nodes.pending, false));
+
+    nodes.pending = std::move(node);
+
+    return true;
+}
+
+bool BulkLoader::place(std::size_t level, Node& node, bool last)
+{
+    if (level + 1 == levels_.size())
+        levels_.emplace_back();
+
+    Node& parent = levels_[level + 1].open;
+
+    // the last child joins a full parent in its spare slot
+    const bool has_room =
+        parent.page != nullptr &&
+        (last || parent.page->node.header.num_keys + 1 < internal_fill_);
+
+    if (has_room)
+    {
+        page_header_t& header = parent.page->node.header;
+        parent.page->node.branch[header.num_keys++] = { node.first_key,
+                                                        node.pagenum };
+    }
+    else
+    {
+        Node full = std::move(parent);
+
+        CHECK_FAILURE(open_node(parent, false));
+        parent.first_key = node.first_key;
+        parent.page->node.header.page_a_number = node.pagenum;
+
+        if (full.page != nullptr)
+            CHECK_FAILURE(close_node(level + 1, full));
+    }
+
+    node.page->node.header.parent_page_number = parent.pagenum;
+
+    return write(node);
+}
+
+bool BulkLoader::write(Node& node)
+{
+    writes_.push_back({ node.pagenum, node.page.get() });
+    pending_writes_.emplace_back(std::move(node.page));
+
+    if (writes_.size() >= WRITE_BATCH)
+        CHECK_FAILURE(flush());
+
+    return true;
+}
+
+bool BulkLoader::flush()
+{
+    CHECK_FAILURE(table_.file()->file_write_pages(writes_));
+
+    writes_.clear();
+    pending_writes_.clear();
+
+    return true;
+}
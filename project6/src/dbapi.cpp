@@ -1,5 +1,6 @@
 #include "dbapi.h"
 
+#include "bpt.h"
 #include "common.h"
 #include "lock.h"
 #include "log.h"
@@ -9,15 +10,33 @@
 
 #include <cstring>
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
+
+namespace
+{
+std::vector<page_data_t> make_records(const int64_t* keys, char** values,
+                                      int num_records)
+{
+    std::vector<page_data_t> records(num_records);
+    for (int i = 0; i < num_records; ++i)
+    {
+        records[i].key = keys[i];
+        strncpy(records[i].value, values[i], PAGE_DATA_VALUE_SIZE);
+    }
+
+    return records;
+}
+}  // namespace
 
 int init_db(int num_buf, int flag, int log_num, char* log_path,
-            char* logmsg_path)
+            char* logmsg_path, const DBConfig& config)
 {
     CHECK_FAILURE2(LockManager::initialize(), FAIL);
     CHECK_FAILURE2(LogManager::initialize(std::string(log_path)), FAIL);
     CHECK_FAILURE2(XactManager::initialize(), FAIL);
-    CHECK_FAILURE2(TableManager::initialize(num_buf), FAIL);
+    CHECK_FAILURE2(TableManager::initialize(num_buf, config), FAIL);
 
     Recovery recovery{ std::string(logmsg_path),
                        static_cast<RecoveryMode>(flag), log_num };
@@ -46,6 +65,17 @@ int open_table(char* pathname)
     return -1;
 }
 
+int open_table_read_only(char* pathname)
+{
+    CHECK_FAILURE2(TableManager::is_initialized(), -1);
+
+    if (auto table_id = TblMgr().open_table(pathname, true);
+        table_id.has_value())
+        return table_id.value();
+
+    return -1;
+}
+
 int close_table(int table_id)
 {
     CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
@@ -53,6 +83,18 @@ int close_table(int table_id)
     return TblMgr().close_table(table_id) ? SUCCESS : FAIL;
 }
 
+int db_set_tree_policy(int table_id, const TreePolicy& policy)
+{
+    CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
+
+    auto table = TblMgr().get_table(table_id);
+    CHECK_FAILURE2(table.has_value(), FAIL);
+
+    CHECK_FAILURE2(BPTree::set_policy(*table.value(), policy), FAIL);
+
+    return SUCCESS;
+}
+
 int db_insert(int table_id, int64_t key, char* value)
 {
     CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
@@ -87,6 +129,34 @@ int db_find(int table_id, int64_t key, char* ret_val, int trx_id)
     return SUCCESS;
 }
 
+int db_find_many(int table_id, const int64_t* keys, int num_keys,
+                 char** ret_vals, int* found, int trx_id)
+{
+    CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
+    CHECK_FAILURE2(num_keys >= 0, FAIL);
+
+    auto table = TblMgr().get_table(table_id);
+    CHECK_FAILURE2(table.has_value(), FAIL);
+
+    Xact* xact = XactMgr().get(trx_id);
+    CHECK_FAILURE2(xact != nullptr, FAIL);
+
+    std::vector<std::optional<page_data_t>> records;
+    CHECK_FAILURE2(table.value()->find_many(
+                       std::vector<int64_t>(keys, keys + num_keys), records,
+                       xact),
+                   FAIL);
+
+    for (int i = 0; i < num_keys; ++i)
+    {
+        found[i] = records[i].has_value();
+        if (records[i].has_value())
+            strncpy(ret_vals[i], records[i]->value, PAGE_DATA_VALUE_SIZE);
+    }
+
+    return SUCCESS;
+}
+
 int db_delete(int table_id, int64_t key)
 {
     CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
@@ -114,6 +184,144 @@ int db_update(int table_id, int64_t key, char* value, int trx_id)
     return SUCCESS;
 }
 
+int db_insert_batch(int table_id, const int64_t* keys, char** values,
+                    int num_records, int* inserted)
+{
+    CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
+    CHECK_FAILURE2(num_records >= 0, FAIL);
+
+    auto table = TblMgr().get_table(table_id);
+    CHECK_FAILURE2(table.has_value(), FAIL);
+
+    std::vector<bool> results;
+    CHECK_FAILURE2(table.value()->insert_many(
+                       make_records(keys, values, num_records), results),
+                   FAIL);
+
+    if (inserted != nullptr)
+        std::copy(begin(results), end(results), inserted);
+
+    return SUCCESS;
+}
+
+int db_update_batch(int table_id, const int64_t* keys, char** values,
+                    int num_records, int* updated, int trx_id)
+{
+    CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
+    CHECK_FAILURE2(num_records >= 0, FAIL);
+
+    auto table = TblMgr().get_table(table_id);
+    CHECK_FAILURE2(table.has_value(), FAIL);
+
+    Xact* xact = XactMgr().get(trx_id);
+    CHECK_FAILURE2(xact != nullptr, FAIL);
+
+    std::vector<bool> results;
+    CHECK_FAILURE2(table.value()->update_many(
+                       make_records(keys, values, num_records), results, xact),
+                   FAIL);
+
+    if (updated != nullptr)
+        std::copy(begin(results), end(results), updated);
+
+    return SUCCESS;
+}
+
+int db_scan_open(int table_id, int64_t lo, int64_t hi, int trx_id)
+{
+    CHECK_FAILURE2(TableManager::is_initialized(), 0);
+
+    CHECK_FAILURE2(TblMgr().get_table(table_id).has_value(), 0);
+    CHECK_FAILURE2(XactMgr().get(trx_id) != nullptr, 0);
+
+    ScanCursor cursor;
+    cursor.table_id = table_id;
+    cursor.trx_id = trx_id;
+    cursor.next_key = lo;
+    cursor.hi = hi;
+    cursor.done = lo > hi;
+
+    return TblMgr().open_scan(std::move(cursor));
+}
+
+int db_scan_next(int scan_id, int64_t* key, char* ret_val)
+{
+    CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
+
+    auto scan = TblMgr().get_scan(scan_id);
+    CHECK_FAILURE2(scan.has_value(), FAIL);
+
+    ScanCursor& cursor = *scan.value();
+    if (cursor.position == cursor.records.size())
+    {
+        CHECK_FAILURE2(!cursor.done, FAIL);
+
+        auto table = TblMgr().get_table(cursor.table_id);
+        CHECK_FAILURE2(table.has_value(), FAIL);
+
+        Xact* xact = XactMgr().get(cursor.trx_id);
+        CHECK_FAILURE2(xact != nullptr, FAIL);
+
+        CHECK_FAILURE2(table.value()->scan(cursor, xact), FAIL);
+        CHECK_FAILURE2(!cursor.records.empty(), FAIL);
+    }
+
+    const page_data_t& record = cursor.records[cursor.position++];
+    *key = record.key;
+    strncpy(ret_val, record.value, PAGE_DATA_VALUE_SIZE);
+
+    return SUCCESS;
+}
+
+int db_scan_close(int scan_id)
+{
+    CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
+    CHECK_FAILURE2(TblMgr().close_scan(scan_id), FAIL);
+
+    return SUCCESS;
+}
+
+int db_compact(int table_id, int max_pages, int* done,
+               int64_t* reclaimed_bytes)
+{
+    CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
+
+    auto table = TblMgr().get_table(table_id);
+    CHECK_FAILURE2(table.has_value(), FAIL);
+
+    const auto stats = table.value()->compact(max_pages);
+    CHECK_FAILURE2(stats.has_value(), FAIL);
+
+    if (done != nullptr)
+        *done = stats->done;
+    if (reclaimed_bytes != nullptr)
+        *reclaimed_bytes = stats->reclaimed_bytes();
+
+    return SUCCESS;
+}
+
+int db_bulk_load(int table_id, BulkLoadSource next, void* context,
+                 double fill_factor, int64_t* num_records)
+{
+    CHECK_FAILURE2(TableManager::is_initialized(), FAIL);
+    CHECK_FAILURE2(next != nullptr, FAIL);
+
+    auto table = TblMgr().get_table(table_id);
+    CHECK_FAILURE2(table.has_value(), FAIL);
+
+    const auto loaded = table.value()->bulk_load(
+        [&](page_data_t& record) {
+            return next(context, &record.key, record.value) != 0;
+        },
+        fill_factor);
+    CHECK_FAILURE2(loaded.has_value(), FAIL);
+
+    if (num_records != nullptr)
+        *num_records = loaded.value();
+
+    return SUCCESS;
+}
+
 int trx_begin()
 {
     CHECK_FAILURE2(TableManager::is_initialized(), 0);
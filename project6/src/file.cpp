@@ -7,9 +7,32 @@
 
 #include <fcntl.h>
 #include <memory.h>
+#include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
-#include <cassert>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// skips the bytes at the front of the vector
+void advance(iovec*& iov, int& count, std::size_t bytes)
+{
+    for (; count > 0 && bytes >= iov->iov_len; ++iov, --count)
+        bytes -= iov->iov_len;
+
+    if (count > 0)
+    {
+        iov->iov_base = static_cast<char*>(iov->iov_base) + bytes;
+        iov->iov_len -= bytes;
+    }
+}
+}  // namespace
 
 File::~File()
 {
@@ -19,6 +42,10 @@ File::~File()
 File::File(File&& other)
 {
     file_handle_ = other.file_handle_;
+    direct_ = other.direct_;
+    extent_pages_ = other.extent_pages_;
+    num_pages_ = other.num_pages_.load();
+    free_space_ = std::move(other.free_space_);
 
     other.file_handle_ = -1;
 }
@@ -26,32 +53,64 @@ File::File(File&& other)
 File& File::operator=(File&& other)
 {
     file_handle_ = other.file_handle_;
+    direct_ = other.direct_;
+    extent_pages_ = other.extent_pages_;
+    num_pages_ = other.num_pages_.load();
+    free_space_ = std::move(other.free_space_);
 
     other.file_handle_ = -1;
 
     return *this;
 }
 
-bool File::open(const std::string& filename)
+bool File::open(const std::string& filename, bool direct_io)
 {
     if (is_open())
         close();
 
     const bool create_new = (access(filename.c_str(), F_OK) == -1);
 
-    if ((file_handle_ = ::open(
-             filename.c_str(), O_RDWR | O_CREAT | O_DSYNC,
-             S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH)) == -1)
+    constexpr mode_t mode =
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+
+    // every transfer is a whole page from an aligned page_t, as O_DIRECT
+    // requires. a file system without it rejects the flag with EINVAL.
+    direct_ = false;
+    if (direct_io)
+    {
+        file_handle_ =
+            ::open(filename.c_str(), O_RDWR | O_CREAT | O_DIRECT, mode);
+        direct_ = file_handle_ != -1;
+    }
+
+    if (!direct_ &&
+        (file_handle_ = ::open(filename.c_str(), O_RDWR | O_CREAT, mode)) == -1)
         return false;
 
+    // the file must not be mapped by a read only table meanwhile
+    if (flock(file_handle_, LOCK_EX | LOCK_NB) == -1)
+    {
+        close();
+        return false;
+    }
+
+    page_t file_header;
     if (create_new)
     {
-        page_t file_header;
         memset(&file_header, 0, PAGE_SIZE);
         file_header.file.num_pages = 1;
+        file_header.file.free_space_format =
+            static_cast<uint64_t>(FreeSpaceFormat::BITMAP);
 
         CHECK_FAILURE(file_write_page(0, &file_header));
     }
+    else
+    {
+        CHECK_FAILURE(file_read_page(0, &file_header));
+    }
+
+    CHECK_FAILURE(load_free_space(file_header));
+    num_pages_ = file_header.file.num_pages;
 
     filename_ = filename;
 
@@ -64,6 +123,7 @@ void File::close()
         return;
 
     ::close(file_handle_);
+    file_handle_ = -1;
 }
 
 const std::string& File::filename() const
@@ -71,59 +131,355 @@ const std::string& File::filename() const
     return filename_;
 }
 
+bool File::is_direct() const
+{
+    return direct_;
+}
+
 bool File::is_open() const
 {
     return file_handle_ > 0;
 }
 
-bool File::file_alloc_page(Page& header, pagenum_t& pagenum)
+pagenum_t File::bitmap_page_of(pagenum_t pagenum)
+{
+    if (pagenum < HEADER_FREE_BITS)
+        return NULL_PAGE_NUM;
+
+    return pagenum - (pagenum - HEADER_FREE_BITS) % BITMAP_FREE_BITS;
+}
+
+bool File::file_alloc_extent(Page& header)
+{
+    const uint64_t first = header.header_page().num_pages;
+    const uint64_t new_pages = extent_pages(first);
+
+    CHECK_FAILURE(extend(first, new_pages));
+
+    free_space_.resize(first + new_pages);
+    free_space_.set_free(first, new_pages, true);
+
+    // a bitmap page starting a range in the extent is not read by anyone
+    // yet, so it is written here, before num_pages_ lets it be read
+    pagenum_t bitmap_page = bitmap_page_of(first);
+    if (bitmap_page < first)
+        bitmap_page = (bitmap_page == NULL_PAGE_NUM)
+                          ? HEADER_FREE_BITS
+                          : bitmap_page + BITMAP_FREE_BITS;
+
+    bool written = false;
+    for (; bitmap_page < first + new_pages; bitmap_page += BITMAP_FREE_BITS)
+    {
+        free_space_.set_free(bitmap_page, false);
+
+        CHECK_FAILURE(write_bitmap_page(bitmap_page));
+        written = true;
+    }
+
+    if (written)
+        CHECK_FAILURE(sync());
+
+    header.header_page().num_pages = first + new_pages;
+    header.mark_dirty();
+
+    num_pages_ = first + new_pages;
+
+    return true;
+}
+
+bool File::file_truncate(Page& header, uint64_t num_pages)
+{
+    const uint64_t old_pages = header.header_page().num_pages;
+    CHECK_FAILURE(num_pages > 0 && num_pages <= old_pages);
+
+    if (num_pages == old_pages)
+        return true;
+
+    // the pages cut off are not read from now on. the free bits of them
+    // left in the header and bitmap pages are ignored, past num_pages.
+    num_pages_ = num_pages;
+    free_space_.resize(num_pages);
+
+    header.header_page().num_pages = num_pages;
+    header.mark_dirty();
+
+    // the header is durable before the file is cut, as a file longer than
+    // its header says is still read, but not a shorter one. the nodes it
+    // points to are durable already, written back by the caller.
+    page_t file_header;
+    file_header.file = header.header_page();
+    CHECK_FAILURE(file_write_page(NULL_PAGE_NUM, &file_header));
+    CHECK_FAILURE(sync());
+
+    return ftruncate(file_handle_, num_pages * PAGE_SIZE) == 0;
+}
+
+FreeSpaceMap& File::free_space()
+{
+    return free_space_;
+}
+
+pagenum_t File::last_node_page() const
 {
-    pagenum = NULL_PAGE_NUM;
+    // a bitmap page is in use as long as the file reaches into its range
+    pagenum_t last = free_space_.last_used(free_space_.size());
+    while (last != NULL_PAGE_NUM && bitmap_page_of(last) == last)
+        last = free_space_.last_used(last);
+
+    return last;
+}
 
-    if (header.header_page().free_page_number != NULL_PAGE_NUM)
+bool File::load_free_space(page_t& header)
+{
+    free_space_ = FreeSpaceMap();
+    free_space_.resize(header.file.num_pages);
+
+    switch (static_cast<FreeSpaceFormat>(header.file.free_space_format))
     {
-        const pagenum_t free_page_number = header.header_page().free_page_number;
+        case FreeSpaceFormat::FREE_LIST:
+        case FreeSpaceFormat::CONVERTING:
+            return convert_free_list(header);
 
-        pagenum = header.header_page().free_page_number;
+        case FreeSpaceFormat::BITMAP:
+            break;
 
-        page_t free_page;
-        CHECK_FAILURE(file_read_page(free_page_number, &free_page));
+        default:
+            return false;
+    }
 
-        header.header_page().free_page_number = free_page.node.free_header.next_free_page_number;
+    free_space_.load(0, header.file.free_bits, HEADER_PAGE_FREE_WORDS);
 
-        CHECK_FAILURE(file_write_page(free_page_number, &free_page));
+    page_t bitmap;
+    for (pagenum_t pagenum = HEADER_FREE_BITS;
+         pagenum < header.file.num_pages; pagenum += BITMAP_FREE_BITS)
+    {
+        CHECK_FAILURE(file_read_page(pagenum, &bitmap));
+        free_space_.load(pagenum / 64, bitmap.bitmap.free_bits,
+                         BITMAP_PAGE_FREE_WORDS);
+    }
+
+    return true;
+}
+
+bool File::convert_free_list(page_t& header)
+{
+    // the pages where the bitmap pages go are moved out of the way first
+    if (header.file.num_pages > HEADER_FREE_BITS ||
+        static_cast<FreeSpaceFormat>(header.file.free_space_format) ==
+            FreeSpaceFormat::CONVERTING)
+    {
+        CHECK_FAILURE(move_bitmap_pages(header));
     }
     else
     {
-        pagenum = header.header_page().num_pages;
+        CHECK_FAILURE(load_free_list(header));
+    }
 
-        if (capacity() <= header.header_page().num_pages)
-            CHECK_FAILURE(extend(header, NEW_PAGES_WHEN_NO_FREE_PAGES));
+    for (pagenum_t pagenum = HEADER_FREE_BITS;
+         pagenum < header.file.num_pages; pagenum += BITMAP_FREE_BITS)
+        CHECK_FAILURE(write_bitmap_page(pagenum));
+    CHECK_FAILURE(sync());
 
-        ++header.header_page().num_pages;
+    header.file.free_page_number = NULL_PAGE_NUM;
+    header.file.free_space_format =
+        static_cast<uint64_t>(FreeSpaceFormat::BITMAP);
+
+    for (size_t i = 0; i < HEADER_PAGE_FREE_WORDS; ++i)
+    {
+        header.file.free_bits[i] = (i * 64 < header.file.num_pages)
+                                       ? free_space_.word(i * 64)
+                                       : 0;
+    }
+
+    return file_write_page(0, &header);
+}
+
+bool File::load_free_list(page_t& header)
+{
+    const uint64_t num_pages = header.file.num_pages;
+
+    // a page on the list at most once, even when the list is broken
+    page_t free_page;
+    pagenum_t pagenum = header.file.free_page_number;
+    for (uint64_t i = 0; i < num_pages && pagenum != NULL_PAGE_NUM; ++i)
+    {
+        CHECK_FAILURE(pagenum < num_pages);
+        CHECK_FAILURE(file_read_page(pagenum, &free_page));
+
+        free_space_.set_free(pagenum, true);
+        pagenum = free_page.node.free_header.next_free_page_number;
     }
-    
-    header.mark_dirty();
 
     return true;
 }
 
-bool File::extend(Page& header, uint64_t new_pages)
+pagenum_t File::moved_page(pagenum_t pagenum, uint64_t old_pages)
 {
-    const uint64_t prev_size = header.header_page().num_pages;
-    const uint64_t new_size = prev_size + new_pages;
+    if (pagenum < HEADER_FREE_BITS || pagenum >= old_pages ||
+        bitmap_page_of(pagenum) != pagenum)
+        return pagenum;
+
+    // the copies follow each other, around the bitmap pages past the end
+    uint64_t index = (pagenum - HEADER_FREE_BITS) / BITMAP_FREE_BITS;
+    pagenum_t target = old_pages;
+    for (;; ++target)
+    {
+        if (bitmap_page_of(target) != target && index-- == 0)
+            return target;
+    }
+}
+
+bool File::move_bitmap_pages(page_t& header)
+{
+    const bool copied =
+        static_cast<FreeSpaceFormat>(header.file.free_space_format) ==
+        FreeSpaceFormat::CONVERTING;
+    const uint64_t old_pages =
+        copied ? header.file.free_bits[0] : header.file.num_pages;
+
+    const pagenum_t last_bitmap_page = bitmap_page_of(old_pages - 1);
+    const uint64_t num_pages =
+        (last_bitmap_page == NULL_PAGE_NUM)
+            ? old_pages
+            : moved_page(last_bitmap_page, old_pages) + 1;
+
+    // the copies are durable before the header tells they are there, and
+    // the pages copied are overwritten by the bitmap pages only after it.
+    // a conversion cut off by a crash is taken up again from the copies.
+    if (!copied)
+    {
+        CHECK_FAILURE(extend(old_pages, num_pages - old_pages));
+
+        page_t page;
+        for (pagenum_t pagenum = HEADER_FREE_BITS; pagenum < old_pages;
+             pagenum += BITMAP_FREE_BITS)
+        {
+            CHECK_FAILURE(file_read_page(pagenum, &page));
+
+            iovec iov{ &page, PAGE_SIZE };
+            CHECK_FAILURE(
+                writev(moved_page(pagenum, old_pages) * PAGE_SIZE, &iov, 1));
+        }
+        CHECK_FAILURE(sync());
+
+        header.file.num_pages = num_pages;
+        header.file.free_space_format =
+            static_cast<uint64_t>(FreeSpaceFormat::CONVERTING);
+        header.file.free_bits[0] = old_pages;
+        CHECK_FAILURE(file_write_page(0, &header));
+    }
 
-    return ftruncate(file_handle_, new_size * PAGE_SIZE) == 0;
+    CHECK_FAILURE(header.file.num_pages == num_pages);
+    free_space_.resize(num_pages);
+
+    return load_tree_pages(header, old_pages);
 }
 
-size_t File::capacity() const
+bool File::load_tree_pages(page_t& header, uint64_t old_pages)
 {
-    struct stat s;
-    fstat(file_handle_, &s);
+    const uint64_t num_pages = header.file.num_pages;
+
+    // the pages not in the tree are free, some of them may have been left
+    // off the free list
+    free_space_.set_free(1, num_pages - 1, true);
+    for (pagenum_t pagenum = HEADER_FREE_BITS; pagenum < num_pages;
+         pagenum += BITMAP_FREE_BITS)
+        free_space_.set_free(pagenum, false);
+
+    header.file.root_page_number =
+        moved_page(header.file.root_page_number, old_pages);
+
+    // the nodes with their parents, which the moved ones have changed
+    std::vector<std::pair<pagenum_t, pagenum_t>> nodes;
+    if (header.file.root_page_number != NULL_PAGE_NUM)
+        nodes.emplace_back(header.file.root_page_number, NULL_PAGE_NUM);
+
+    page_t page;
+    while (!nodes.empty())
+    {
+        const auto [pagenum, parent] = nodes.back();
+        nodes.pop_back();
+
+        // a broken tree is not followed around
+        CHECK_FAILURE(pagenum < num_pages && free_space_.is_free(pagenum));
+        free_space_.set_free(pagenum, false);
+
+        CHECK_FAILURE(file_read_page(pagenum, &page));
+        page_header_t& node = page.node.header;
+
+        // the right sibling of a leaf, or the leftmost child
+        const pagenum_t page_a = moved_page(node.page_a_number, old_pages);
+        bool changed = node.parent_page_number != parent ||
+                       node.page_a_number != page_a;
+        node.parent_page_number = parent;
+        node.page_a_number = page_a;
+
+        if (!node.is_leaf)
+        {
+            CHECK_FAILURE(node.num_keys >= 0 &&
+                          node.num_keys <=
+                              static_cast<int>(PAGE_BRANCHES_IN_PAGE));
+
+            nodes.emplace_back(page_a, pagenum);
+            for (int i = 0; i < node.num_keys; ++i)
+            {
+                pagenum_t& child = page.node.branch[i].child_page_number;
+                const pagenum_t moved = moved_page(child, old_pages);
+
+                changed = changed || child != moved;
+                child = moved;
+                nodes.emplace_back(child, pagenum);
+            }
+        }
+
+        if (changed)
+        {
+            iovec iov{ &page, PAGE_SIZE };
+            CHECK_FAILURE(writev(pagenum * PAGE_SIZE, &iov, 1));
+        }
+    }
+
+    return sync();
+}
 
-    assert(s.st_size % PAGE_SIZE == 0);
+bool File::write_bitmap_page(pagenum_t bitmap_page)
+{
+    page_t bitmap;
+    for (size_t i = 0; i < BITMAP_PAGE_FREE_WORDS; ++i)
+    {
+        const pagenum_t pagenum = bitmap_page + i * 64;
+        bitmap.bitmap.free_bits[i] =
+            (pagenum < free_space_.size()) ? free_space_.word(pagenum) : 0;
+    }
 
-    return s.st_size / PAGE_SIZE;
+    iovec iov{ &bitmap, PAGE_SIZE };
+    return writev(bitmap_page * PAGE_SIZE, &iov, 1);
+}
+
+uint64_t File::extent_pages(uint64_t num_pages) const
+{
+    if (extent_pages_ > 0)
+        return extent_pages_;
+
+    return std::clamp(num_pages / 8, MIN_EXTENT_PAGES, MAX_EXTENT_PAGES);
+}
+
+bool File::extend(uint64_t first, uint64_t new_pages)
+{
+    // one allocation of the whole extent, instead of a size change per page
+    if (fallocate(file_handle_, 0, first * PAGE_SIZE,
+                  new_pages * PAGE_SIZE) == 0)
+        return true;
+
+    // e.g. a file system without fallocate
+    CHECK_FAILURE(errno == EOPNOTSUPP);
+
+    return ftruncate(file_handle_, (first + new_pages) * PAGE_SIZE) == 0;
+}
+
+uint64_t File::num_pages() const
+{
+    return num_pages_;
 }
 
 bool File::file_read_page(pagenum_t pagenum, page_t* dest)
@@ -136,27 +492,244 @@ bool File::file_write_page(pagenum_t pagenum, const page_t* src)
     return write(PAGE_SIZE, pagenum * PAGE_SIZE, src);
 }
 
+bool File::file_write_pages(std::vector<PageWrite>& pages)
+{
+    if (pages.empty())
+        return true;
+
+    std::sort(begin(pages), end(pages),
+              [](const PageWrite& lhs, const PageWrite& rhs) {
+                  return lhs.pagenum < rhs.pagenum;
+              });
+
+    std::vector<iovec> iov;
+    iov.reserve(pages.size());
+    for (const PageWrite& page : pages)
+        iov.push_back({ const_cast<page_t*>(page.page), PAGE_SIZE });
+
+    // every run is in flight at once
+    std::vector<IORequest> requests;
+    for (std::size_t first = 0; first < pages.size();)
+    {
+        std::size_t last = first;
+        while (last + 1 < pages.size() &&
+               pages[last + 1].pagenum == pages[last].pagenum + 1 &&
+               last + 1 - first < IOV_MAX)
+            ++last;
+
+        IORequest request;
+        request.op = IOOp::WRITE;
+        request.fd = file_handle_;
+        request.iov = &iov[first];
+        request.iov_count = static_cast<int>(last - first + 1);
+        request.offset = pages[first].pagenum * PAGE_SIZE;
+        requests.emplace_back(request);
+
+        first = last + 1;
+    }
+
+    FileMgr().io().submit(requests.data(), requests.size());
+    FileMgr().io().wait(requests.data(), requests.size());
+
+    for (IORequest& request : requests)
+    {
+        // the rest of a short or interrupted write is written on its own
+        const std::size_t written = std::max<ssize_t>(request.result, 0);
+        if (request.result < 0 && request.result != -EINTR)
+            return false;
+
+        advance(request.iov, request.iov_count, written);
+        CHECK_FAILURE(
+            writev(request.offset + written, request.iov, request.iov_count));
+    }
+
+    return sync();
+}
+
 bool File::read(size_t size, size_t offset, void* value)
 {
-    return pread(file_handle_, value, size, offset) >= 0;
+    iovec iov{ value, size };
+
+    IORequest request;
+    request.op = IOOp::READ;
+    request.fd = file_handle_;
+    request.iov = &iov;
+    request.iov_count = 1;
+    request.offset = offset;
+
+    FileMgr().io().submit(&request, 1);
+    FileMgr().io().wait(&request, 1);
+
+    return request.result >= 0;
 }
 
 bool File::write(size_t size, size_t offset, const void* value)
 {
-    if (pwrite(file_handle_, value, size, offset) == -1)
+    iovec iov{ const_cast<void*>(value), size };
+
+    CHECK_FAILURE(writev(offset, &iov, 1));
+
+    return sync();
+}
+
+bool File::writev(size_t offset, iovec* iov, int count)
+{
+    while (count > 0)
+    {
+        IORequest request;
+        request.op = IOOp::WRITE;
+        request.fd = file_handle_;
+        request.iov = iov;
+        request.iov_count = count;
+        request.offset = offset;
+
+        FileMgr().io().submit(&request, 1);
+        FileMgr().io().wait(&request, 1);
+
+        if (request.result < 0)
+        {
+            if (request.result == -EINTR)
+                continue;
+
+            return false;
+        }
+
+        // continue a short write after the written bytes
+        offset += request.result;
+        advance(iov, count, request.result);
+    }
+
+    return true;
+}
+
+bool File::sync()
+{
+    IORequest request;
+    request.op = IOOp::SYNC;
+    request.fd = file_handle_;
+
+    FileMgr().io().submit(&request, 1);
+    FileMgr().io().wait(&request, 1);
+
+    return request.result == 0;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+    close();
+
+    filename_ = std::move(other.filename_);
+    file_handle_ = other.file_handle_;
+    pages_ = other.pages_;
+    num_pages_ = other.num_pages_;
+
+    other.file_handle_ = -1;
+    other.pages_ = nullptr;
+    other.num_pages_ = 0;
+
+    return *this;
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+    if (is_open())
+        close();
+
+    file_handle_ = ::open(filename.c_str(), O_RDONLY);
+    CHECK_FAILURE(file_handle_ != -1);
+
+    // fails while a writer holds the exclusive lock
+    struct stat s;
+    if (flock(file_handle_, LOCK_SH | LOCK_NB) == -1 ||
+        fstat(file_handle_, &s) == -1 ||
+        static_cast<size_t>(s.st_size) < PAGE_SIZE)
+    {
+        close();
+        return false;
+    }
+
+    num_pages_ = s.st_size / PAGE_SIZE;
+
+    void* addr = mmap(nullptr, num_pages_ * PAGE_SIZE, PROT_READ, MAP_SHARED,
+                      file_handle_, 0);
+    if (addr == MAP_FAILED)
+    {
+        close();
         return false;
+    }
+
+    pages_ = static_cast<const page_t*>(addr);
+
+    // a lookup touches one page per level, the kernel read-ahead of the
+    // neighbours would be wasted. the header page is read by every lookup.
+    madvise(addr, num_pages_ * PAGE_SIZE, MADV_RANDOM);
+    madvise(addr, PAGE_SIZE, MADV_WILLNEED);
+
+    filename_ = filename;
 
-    fsync(file_handle_);
     return true;
 }
 
-bool FileManager::initialize()
+void MappedFile::close()
+{
+    if (pages_ != nullptr)
+        munmap(const_cast<page_t*>(pages_), num_pages_ * PAGE_SIZE);
+    if (file_handle_ != -1)
+        ::close(file_handle_);
+
+    file_handle_ = -1;
+    pages_ = nullptr;
+    num_pages_ = 0;
+}
+
+const std::string& MappedFile::filename() const
+{
+    return filename_;
+}
+
+bool MappedFile::is_open() const
+{
+    return pages_ != nullptr;
+}
+
+const page_t* MappedFile::page(pagenum_t pagenum) const
+{
+    if (pagenum >= num_pages_)
+        return nullptr;
+
+    return pages_ + pagenum;
+}
+
+size_t MappedFile::num_pages() const
+{
+    return num_pages_;
+}
+
+bool FileManager::initialize(const DBConfig& config)
 {
     CHECK_FAILURE(instance_ == nullptr);
 
     instance_ = new (std::nothrow) FileManager;
+    CHECK_FAILURE(instance_ != nullptr);
 
-    return instance_ != nullptr;
+    instance_->io_ =
+        IOBackend::create(config.io_backend, config.io_queue_depth);
+    CHECK_FAILURE(instance_->io_ != nullptr);
+
+    instance_->direct_io_ = config.direct_io;
+    instance_->extent_pages_ = std::max(config.file_extent_pages, 0);
+
+    return true;
 }
 
 bool FileManager::shutdown()
@@ -174,13 +747,32 @@ FileManager& FileManager::get_instnace()
     return *instance_;
 }
 
+IOBackend& FileManager::io()
+{
+    return *io_;
+}
+
 bool FileManager::open_table(Table& table)
 {
     auto it = files_.find(table.filename());
     CHECK_FAILURE(it == end(files_));
+    CHECK_FAILURE(mapped_files_.find(table.filename()) == end(mapped_files_));
+
+    if (table.read_only())
+    {
+        MappedFile file;
+        CHECK_FAILURE(file.open(table.filename()));
+
+        auto [mapped_it, inserted] =
+            mapped_files_.emplace(table.filename(), std::move(file));
+        table.set_mapped_file(&mapped_it->second);
+
+        return true;
+    }
 
     File file;
-    CHECK_FAILURE(file.open(table.filename()));
+    CHECK_FAILURE(file.open(table.filename(), direct_io_));
+    file.extent_pages_ = extent_pages_;
 
     files_.insert_or_assign(table.filename(), std::move(file));
 
@@ -191,6 +783,17 @@ bool FileManager::open_table(Table& table)
 
 bool FileManager::close_table(Table& table)
 {
+    if (table.read_only())
+    {
+        auto it = mapped_files_.find(table.filename());
+        CHECK_FAILURE(it != end(mapped_files_));
+
+        table.set_mapped_file(nullptr);
+        mapped_files_.erase(it);
+
+        return true;
+    }
+
     auto it = files_.find(table.filename());
     CHECK_FAILURE(it != end(files_));
 
@@ -0,0 +1,211 @@
+#include "frame_arena.h"
+
+#include "common.h"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+static_assert(std::is_trivially_default_constructible_v<page_t>,
+              "frames are used as mapped, without being constructed");
+
+namespace
+{
+constexpr int MAX_NUMA_NODES = std::numeric_limits<unsigned long>::digits;
+
+std::size_t round_up(std::size_t size, std::size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// nodes listed in /sys/devices/system/node/online, e.g. "0-1,3"
+unsigned long online_numa_nodes()
+{
+    std::ifstream file("/sys/devices/system/node/online");
+
+    std::string list;
+    if (!(file >> list))
+        return 1;
+
+    unsigned long mask = 0;
+
+    std::size_t pos = 0;
+    while (pos < list.size())
+    {
+        std::size_t end;
+        const int first = std::stoi(list.substr(pos), &end);
+        pos += end;
+
+        int last = first;
+        if (pos < list.size() && list[pos] == '-')
+        {
+            last = std::stoi(list.substr(pos + 1), &end);
+            pos += end + 1;
+        }
+
+        for (int node = first; node <= last && node < MAX_NUMA_NODES; ++node)
+            mask |= 1UL << node;
+
+        // skip ','
+        ++pos;
+    }
+
+    return (mask != 0) ? mask : 1;
+}
+}  // namespace
+
+FrameArena::~FrameArena()
+{
+    release();
+}
+
+bool FrameArena::allocate(std::size_t num_frames, const DBConfig& config)
+{
+    CHECK_FAILURE(addr_ == nullptr);
+    CHECK_FAILURE(num_frames > 0);
+
+    const std::size_t size = num_frames * sizeof(page_t);
+
+    if (!config.huge_pages || !map_huge_pages(size))
+    {
+        CHECK_FAILURE(map_pages(size, config.huge_pages));
+    }
+
+    if (!set_numa_policy(config))
+    {
+        release();
+        return false;
+    }
+
+    return true;
+}
+
+void FrameArena::release()
+{
+    if (addr_ == nullptr)
+        return;
+
+    munmap(addr_, size_);
+
+    addr_ = nullptr;
+    size_ = 0;
+    huge_pages_ = false;
+}
+
+page_t* FrameArena::frames() const
+{
+    return static_cast<page_t*>(addr_);
+}
+
+std::size_t FrameArena::size() const
+{
+    return size_;
+}
+
+bool FrameArena::huge_pages() const
+{
+    return huge_pages_;
+}
+
+bool FrameArena::map_huge_pages(std::size_t size)
+{
+#ifdef MAP_HUGETLB
+    size = round_up(size, HUGE_PAGE_SIZE);
+
+    // fails when not enough huge pages are reserved (vm.nr_hugepages)
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr == MAP_FAILED)
+        return false;
+
+    addr_ = addr;
+    size_ = size;
+    huge_pages_ = true;
+
+    return true;
+#else
+    (void)size;
+    return false;
+#endif
+}
+
+bool FrameArena::map_pages(std::size_t size, bool advise_huge_pages)
+{
+    size = round_up(size, PAGE_SIZE);
+
+    if (!advise_huge_pages || size < HUGE_PAGE_SIZE)
+    {
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        CHECK_FAILURE(addr != MAP_FAILED);
+
+        addr_ = addr;
+        size_ = size;
+
+        return true;
+    }
+
+    // transparent huge pages only back 2MB aligned ranges, so map a little
+    // more and trim it to an aligned start
+    const std::size_t mapped_size = size + HUGE_PAGE_SIZE;
+
+    void* addr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK_FAILURE(addr != MAP_FAILED);
+
+    const auto begin = reinterpret_cast<std::uintptr_t>(addr);
+    const std::uintptr_t aligned = round_up(begin, HUGE_PAGE_SIZE);
+
+    if (aligned > begin)
+        munmap(addr, aligned - begin);
+
+    const std::size_t tail = begin + mapped_size - (aligned + size);
+    if (tail > 0)
+        munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+    addr_ = reinterpret_cast<void*>(aligned);
+    size_ = size;
+
+#ifdef MADV_HUGEPAGE
+    // only advice, the kernel may not have transparent huge pages enabled
+    madvise(addr_, size_, MADV_HUGEPAGE);
+#endif
+
+    return true;
+}
+
+bool FrameArena::set_numa_policy(const DBConfig& config)
+{
+    int mode;
+    unsigned long mask;
+
+    switch (config.numa_policy)
+    {
+        case NumaPolicy::NONE:
+            return true;
+        case NumaPolicy::INTERLEAVE:
+            mode = MPOL_INTERLEAVE;
+            mask = online_numa_nodes();
+            break;
+        case NumaPolicy::BIND:
+            CHECK_FAILURE(config.numa_node >= 0 &&
+                          config.numa_node < MAX_NUMA_NODES);
+            mode = MPOL_BIND;
+            mask = 1UL << config.numa_node;
+            break;
+        default:
+            return false;
+    }
+
+    // the pages are not touched yet, so every frame is placed by the policy.
+    // the kernel takes maxnode as one more than the number of mask bits.
+    return syscall(SYS_mbind, addr_, size_, mode, &mask, MAX_NUMA_NODES + 1,
+                   0) == 0;
+}
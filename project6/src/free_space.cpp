@@ -0,0 +1,255 @@
+#include "free_space.h"
+
+#include <algorithm>
+
+namespace
+{
+constexpr uint64_t BITS_IN_WORD = 64;
+
+// the bits of the word that stand for pages before the end
+uint64_t valid_bits(std::size_t index, uint64_t size)
+{
+    const uint64_t first = index * BITS_IN_WORD;
+    if (first + BITS_IN_WORD <= size)
+        return ~uint64_t{ 0 };
+    if (first >= size)
+        return 0;
+
+    return (uint64_t{ 1 } << (size - first)) - 1;
+}
+}  // namespace
+
+uint64_t FreeSpaceMap::size() const
+{
+    return size_;
+}
+
+uint64_t FreeSpaceMap::num_free() const
+{
+    return num_free_;
+}
+
+void FreeSpaceMap::resize(uint64_t num_pages)
+{
+    if (num_pages < size_)
+    {
+        set_free(num_pages, size_ - num_pages, false);
+        cursor_ = std::min(cursor_, num_pages);
+    }
+
+    words_.resize((num_pages + BITS_IN_WORD - 1) / BITS_IN_WORD, 0);
+    size_ = num_pages;
+}
+
+void FreeSpaceMap::load(std::size_t first_word, const uint64_t* words,
+                        std::size_t count)
+{
+    for (std::size_t i = 0; i < count && first_word + i < words_.size(); ++i)
+    {
+        uint64_t& word = words_[first_word + i];
+        const uint64_t bits = words[i] & valid_bits(first_word + i, size_);
+
+        num_free_ += __builtin_popcountll(bits);
+        num_free_ -= __builtin_popcountll(word);
+        word = bits;
+    }
+}
+
+bool FreeSpaceMap::is_free(pagenum_t pagenum) const
+{
+    return pagenum < size_ && (word(pagenum) >> (pagenum % BITS_IN_WORD)) & 1;
+}
+
+void FreeSpaceMap::set_free(pagenum_t pagenum, bool free)
+{
+    if (pagenum >= size_ || is_free(pagenum) == free)
+        return;
+
+    const uint64_t bit = uint64_t{ 1 } << (pagenum % BITS_IN_WORD);
+    if (free)
+    {
+        words_[pagenum / BITS_IN_WORD] |= bit;
+        ++num_free_;
+    }
+    else
+    {
+        words_[pagenum / BITS_IN_WORD] &= ~bit;
+        --num_free_;
+    }
+}
+
+void FreeSpaceMap::set_free(pagenum_t first, uint64_t count, bool free)
+{
+    for (pagenum_t pagenum = first; pagenum < first + count; ++pagenum)
+        set_free(pagenum, free);
+}
+
+uint64_t FreeSpaceMap::word(pagenum_t pagenum) const
+{
+    return words_[pagenum / BITS_IN_WORD];
+}
+
+std::optional<pagenum_t> FreeSpaceMap::allocate(pagenum_t hint)
+{
+    if (num_free_ == 0)
+        return std::nullopt;
+
+    pagenum_t start = (hint != 0) ? hint : cursor_;
+    if (start >= size_)
+        start = 0;
+
+    pagenum_t pagenum = find_free(start, size_);
+    if (pagenum == size_)
+        pagenum = find_free(0, start);
+
+    set_free(pagenum, false);
+    cursor_ = pagenum + 1;
+
+    return pagenum;
+}
+
+std::optional<pagenum_t> FreeSpaceMap::allocate_near(pagenum_t pagenum,
+                                                     uint64_t distance)
+{
+    if (num_free_ == 0 || pagenum >= size_)
+        return std::nullopt;
+
+    const pagenum_t end = std::min<pagenum_t>(size_, pagenum + 1 + distance);
+    pagenum_t found = find_free(pagenum + 1, end);
+
+    if (found == end)
+    {
+        // the closest one before, a word at a time from the page backwards
+        const pagenum_t begin = (pagenum > distance) ? pagenum - distance : 0;
+        found = end;
+
+        for (pagenum_t from = begin; from < pagenum;)
+        {
+            const pagenum_t free = find_free(from, pagenum);
+            if (free == pagenum)
+                break;
+
+            found = free;
+            from = free + 1;
+        }
+
+        if (found == end)
+            return std::nullopt;
+    }
+
+    set_free(found, false);
+
+    return found;
+}
+
+std::optional<pagenum_t> FreeSpaceMap::allocate_run(uint64_t count,
+                                                    pagenum_t hint)
+{
+    if (count == 0 || num_free_ < count)
+        return std::nullopt;
+
+    pagenum_t start = (hint != 0) ? hint : cursor_;
+    if (start >= size_)
+        start = 0;
+
+    auto search = [&](pagenum_t from,
+                      pagenum_t to) -> std::optional<pagenum_t> {
+        while (true)
+        {
+            const pagenum_t first = find_free(from, to);
+            if (first == to || first + count > to)
+                return std::nullopt;
+
+            const pagenum_t used = find_used(first, first + count);
+            if (used == first + count)
+                return first;
+
+            from = used;
+        }
+    };
+
+    // the runs from the start, then the ones before it
+    auto first = search(start, size_);
+    if (!first.has_value())
+        first = search(0, std::min<pagenum_t>(size_, start + count - 1));
+    if (!first.has_value())
+        return std::nullopt;
+
+    set_free(first.value(), count, false);
+    cursor_ = first.value() + count;
+
+    return first;
+}
+
+std::optional<pagenum_t> FreeSpaceMap::allocate_in(pagenum_t from,
+                                                   pagenum_t to)
+{
+    to = std::min<pagenum_t>(to, size_);
+    if (num_free_ == 0 || from >= to)
+        return std::nullopt;
+
+    const pagenum_t pagenum = find_free(from, to);
+    if (pagenum == to)
+        return std::nullopt;
+
+    set_free(pagenum, false);
+
+    return pagenum;
+}
+
+pagenum_t FreeSpaceMap::last_used(pagenum_t before) const
+{
+    before = std::min<pagenum_t>(before, size_);
+
+    // a word at a time, from the page backwards
+    while (before > 0)
+    {
+        const std::size_t index = (before - 1) / BITS_IN_WORD;
+        const uint64_t below = before - index * BITS_IN_WORD;
+        const uint64_t mask = (below == BITS_IN_WORD)
+                                  ? ~uint64_t{ 0 }
+                                  : (uint64_t{ 1 } << below) - 1;
+
+        const uint64_t bits = ~words_[index] & mask;
+        if (bits != 0)
+            return index * BITS_IN_WORD + 63 - __builtin_clzll(bits);
+
+        before = index * BITS_IN_WORD;
+    }
+
+    return 0;
+}
+
+pagenum_t FreeSpaceMap::find_free(pagenum_t from, pagenum_t to) const
+{
+    while (from < to)
+    {
+        const std::size_t index = from / BITS_IN_WORD;
+        const uint64_t bits = words_[index] & (~uint64_t{ 0 }
+                                               << (from % BITS_IN_WORD));
+        if (bits != 0)
+            return std::min<pagenum_t>(
+                index * BITS_IN_WORD + __builtin_ctzll(bits), to);
+
+        from = (index + 1) * BITS_IN_WORD;
+    }
+
+    return to;
+}
+
+pagenum_t FreeSpaceMap::find_used(pagenum_t from, pagenum_t to) const
+{
+    while (from < to)
+    {
+        const std::size_t index = from / BITS_IN_WORD;
+        const uint64_t bits = ~words_[index] & (~uint64_t{ 0 }
+                                                << (from % BITS_IN_WORD));
+        if (bits != 0)
+            return std::min<pagenum_t>(
+                index * BITS_IN_WORD + __builtin_ctzll(bits), to);
+
+        from = (index + 1) * BITS_IN_WORD;
+    }
+
+    return to;
+}
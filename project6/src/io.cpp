@@ -0,0 +1,418 @@
+#include "io.h"
+
+#include "common.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace
+{
+void execute(IORequest& request)
+{
+    ssize_t result = 0;
+
+    switch (request.op)
+    {
+        case IOOp::READ:
+            result = preadv(request.fd, request.iov, request.iov_count,
+                            request.offset);
+            break;
+        case IOOp::WRITE:
+            result = pwritev(request.fd, request.iov, request.iov_count,
+                             request.offset);
+            break;
+        case IOOp::SYNC:
+            result = fdatasync(request.fd);
+            break;
+    }
+
+    request.result = (result == -1) ? -errno : result;
+}
+
+bool all_done(IORequest* requests, std::size_t count)
+{
+    return std::all_of(requests, requests + count,
+                       [](const IORequest& request) { return request.done; });
+}
+
+template <typename T>
+T* ring_ptr(void* ring, unsigned offset)
+{
+    return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+}  // namespace
+
+std::unique_ptr<IOBackend> IOBackend::create(IOBackendType type,
+                                             int queue_depth)
+{
+    queue_depth = std::clamp(queue_depth, 1, 4096);
+
+    switch (type)
+    {
+        case IOBackendType::PREAD:
+            return std::make_unique<PreadBackend>();
+
+        case IOBackendType::IO_URING: {
+            auto backend = std::make_unique<IOUringBackend>();
+            if (backend->init(queue_depth))
+                return backend;
+
+            // e.g. an old kernel, or io_uring disabled by seccomp
+            return std::make_unique<ThreadPoolBackend>(
+                std::min(queue_depth, 64));
+        }
+
+        case IOBackendType::THREAD_POOL:
+            return std::make_unique<ThreadPoolBackend>(
+                std::min(queue_depth, 64));
+    }
+
+    return nullptr;
+}
+
+IOBackendType PreadBackend::type() const
+{
+    return IOBackendType::PREAD;
+}
+
+void PreadBackend::submit(IORequest* requests, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        execute(requests[i]);
+        requests[i].done = true;
+    }
+}
+
+void PreadBackend::wait(IORequest*, std::size_t)
+{
+}
+
+ThreadPoolBackend::ThreadPoolBackend(int num_threads)
+{
+    for (int i = 0; i < num_threads; ++i)
+        workers_.emplace_back(&ThreadPoolBackend::worker_main, this);
+}
+
+ThreadPoolBackend::~ThreadPoolBackend()
+{
+    {
+        std::scoped_lock lock(mutex_);
+        stop_ = true;
+    }
+    queue_cond_.notify_all();
+
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+IOBackendType ThreadPoolBackend::type() const
+{
+    return IOBackendType::THREAD_POOL;
+}
+
+void ThreadPoolBackend::submit(IORequest* requests, std::size_t count)
+{
+    {
+        std::scoped_lock lock(mutex_);
+
+        for (std::size_t i = 0; i < count; ++i)
+            queue_.emplace_back(&requests[i]);
+    }
+
+    if (count == 1)
+        queue_cond_.notify_one();
+    else
+        queue_cond_.notify_all();
+}
+
+void ThreadPoolBackend::wait(IORequest* requests, std::size_t count)
+{
+    std::unique_lock lock(mutex_);
+
+    done_cond_.wait(lock, [&] { return all_done(requests, count); });
+}
+
+void ThreadPoolBackend::worker_main()
+{
+    std::unique_lock lock(mutex_);
+
+    while (true)
+    {
+        queue_cond_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+
+        if (stop_)
+            return;
+
+        IORequest* request = queue_.front();
+        queue_.pop_front();
+
+        lock.unlock();
+        execute(*request);
+        lock.lock();
+
+        request->done = true;
+        done_cond_.notify_all();
+    }
+}
+
+IOUringBackend::~IOUringBackend()
+{
+    if (reaper_.joinable())
+    {
+        {
+            std::scoped_lock lock(mutex_);
+            stop_ = true;
+        }
+
+        reaper_cond_.notify_one();
+        reaper_.join();
+    }
+
+    if (sqes_ != nullptr)
+        munmap(sqes_, sqes_size_);
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+        munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_ != nullptr)
+        munmap(sq_ring_, sq_ring_size_);
+    if (ring_fd_ >= 0)
+        close(ring_fd_);
+}
+
+bool IOUringBackend::init(unsigned entries)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring_fd_ = syscall(__NR_io_uring_setup, entries, &params);
+    CHECK_FAILURE(ring_fd_ >= 0);
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap)
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+    void* sq_ring =
+        mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    CHECK_FAILURE(sq_ring != MAP_FAILED);
+    sq_ring_ = sq_ring;
+
+    if (single_mmap)
+    {
+        cq_ring_ = sq_ring_;
+    }
+    else
+    {
+        void* cq_ring =
+            mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        CHECK_FAILURE(cq_ring != MAP_FAILED);
+        cq_ring_ = cq_ring;
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    CHECK_FAILURE(sqes != MAP_FAILED);
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_tail_ = ring_ptr<unsigned>(sq_ring_, params.sq_off.tail);
+    sq_array_ = ring_ptr<unsigned>(sq_ring_, params.sq_off.array);
+    sq_mask_ = *ring_ptr<unsigned>(sq_ring_, params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+
+    cq_head_ = ring_ptr<unsigned>(cq_ring_, params.cq_off.head);
+    cq_tail_ = ring_ptr<unsigned>(cq_ring_, params.cq_off.tail);
+    cqes_ = ring_ptr<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+    cq_mask_ = *ring_ptr<unsigned>(cq_ring_, params.cq_off.ring_mask);
+    cq_entries_ = params.cq_entries;
+
+    reaper_ = std::thread(&IOUringBackend::reaper_main, this);
+
+    return true;
+}
+
+IOBackendType IOUringBackend::type() const
+{
+    return IOBackendType::IO_URING;
+}
+
+void IOUringBackend::submit(IORequest* requests, std::size_t count)
+{
+    std::unique_lock lock(mutex_);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        // a completion is never dropped for a full completion queue
+        if (inflight_ == cq_entries_)
+        {
+            flush();
+            space_cond_.wait(lock, [this] { return inflight_ < cq_entries_; });
+        }
+
+        if (pending_ == sq_entries_)
+            flush();
+
+        push(&requests[i]);
+        ++inflight_;
+    }
+
+    flush();
+}
+
+void IOUringBackend::wait(IORequest* requests, std::size_t count)
+{
+    std::unique_lock lock(mutex_);
+
+    done_cond_.wait(lock, [&] { return all_done(requests, count); });
+}
+
+void IOUringBackend::push(IORequest* request)
+{
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & sq_mask_;
+
+    io_uring_sqe& sqe = sqes_[index];
+    memset(&sqe, 0, sizeof(sqe));
+
+    switch (request->op)
+    {
+        case IOOp::READ:
+            sqe.opcode = IORING_OP_READV;
+            break;
+        case IOOp::WRITE:
+            sqe.opcode = IORING_OP_WRITEV;
+            break;
+        case IOOp::SYNC:
+            sqe.opcode = IORING_OP_FSYNC;
+            sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+            break;
+    }
+
+    sqe.fd = request->fd;
+    sqe.addr = reinterpret_cast<std::uint64_t>(request->iov);
+    sqe.len = request->iov_count;
+    sqe.off = request->offset;
+    sqe.user_data = reinterpret_cast<std::uint64_t>(request);
+
+    sq_array_[index] = index;
+
+    // the entry is visible to the kernel before the new tail
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++pending_;
+}
+
+void IOUringBackend::flush()
+{
+    while (pending_ > 0)
+    {
+        const int submitted = enter(pending_, 0, 0);
+        if (submitted < 0)
+        {
+            // out of kernel resources, let the completions drain
+            if (submitted == -EAGAIN || submitted == -EBUSY)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            fail_pending(submitted);
+            break;
+        }
+
+        pending_ -= submitted;
+    }
+
+    if (inflight_ > 0)
+        reaper_cond_.notify_one();
+}
+
+void IOUringBackend::fail_pending(int error)
+{
+    // the kernel reads the entries only while they are submitted, which is
+    // done under mutex_, so the ones not passed yet are taken back
+    const unsigned tail = *sq_tail_;
+    for (unsigned i = tail - pending_; i != tail; ++i)
+    {
+        const io_uring_sqe& sqe = sqes_[sq_array_[i & sq_mask_]];
+
+        auto* request = reinterpret_cast<IORequest*>(sqe.user_data);
+        request->result = error;
+        request->done = true;
+
+        --inflight_;
+    }
+
+    __atomic_store_n(sq_tail_, tail - pending_, __ATOMIC_RELEASE);
+    pending_ = 0;
+
+    done_cond_.notify_all();
+    space_cond_.notify_all();
+}
+
+int IOUringBackend::enter(unsigned to_submit, unsigned min_complete,
+                          unsigned flags)
+{
+    while (true)
+    {
+        const int result = syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+                                   min_complete, flags, nullptr, 0);
+        if (result >= 0)
+            return result;
+
+        if (errno != EINTR)
+            return -errno;
+    }
+}
+
+void IOUringBackend::reaper_main()
+{
+    while (true)
+    {
+        {
+            // the ring is waited on only with requests in flight, so the
+            // reaper stops without an entry passing through the kernel
+            std::unique_lock lock(mutex_);
+            reaper_cond_.wait(lock,
+                              [this] { return stop_ || inflight_ > 0; });
+
+            if (inflight_ == 0)
+                return;
+        }
+
+        // the queue is looked at even when the wait failed
+        if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0)
+            std::this_thread::yield();
+
+        std::scoped_lock lock(mutex_);
+
+        unsigned head = *cq_head_;
+        const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; ++head)
+        {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+
+            auto* request = reinterpret_cast<IORequest*>(cqe.user_data);
+            request->result = cqe.res;
+            request->done = true;
+
+            --inflight_;
+        }
+
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+        done_cond_.notify_all();
+        space_cond_.notify_all();
+    }
+}
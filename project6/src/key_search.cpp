@@ -0,0 +1,313 @@
+#include "key_search.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KEY_SEARCH_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+// keys left to the vector kernels once the binary search has narrowed them
+// down, see bench_key_search. the keys of a leaf are on a cache line each,
+// so fewer of them are gathered.
+constexpr int BRANCH_WINDOW = 16;
+constexpr int DATA_WINDOW = 8;
+
+SearchKernel kernel_ = key_search::detect();
+
+// the keys counted are the ones less than key, or not greater than key for
+// an upper bound
+template <bool Upper>
+bool counted(int64_t entry_key, int64_t key)
+{
+    return Upper ? entry_key <= key : entry_key < key;
+}
+
+template <bool Upper, typename T>
+int count_scalar(const T* entries, int size, int64_t key)
+{
+    int count = 0;
+    for (int i = 0; i < size; ++i)
+        count += counted<Upper>(entries[i].key, key);
+
+    return count;
+}
+
+#ifdef KEY_SEARCH_X86
+template <bool Upper>
+__attribute__((target("sse4.2"))) int count_sse42(__m128i keys,
+                                                   __m128i target)
+{
+    const __m128i greater = Upper ? _mm_cmpgt_epi64(keys, target)
+                                  : _mm_cmpgt_epi64(target, keys);
+    const int mask = _mm_movemask_pd(_mm_castsi128_pd(greater));
+
+    return Upper ? 2 - __builtin_popcount(mask) : __builtin_popcount(mask);
+}
+
+template <bool Upper>
+__attribute__((target("sse4.2"))) int count_sse42(
+    const page_branch_t* branches, int size, int64_t key)
+{
+    const __m128i target = _mm_set1_epi64x(key);
+
+    int count = 0;
+    int i = 0;
+    for (; i + 2 <= size; i += 2)
+    {
+        // the key halves of two branches
+        const __m128i first = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(branches + i));
+        const __m128i second = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(branches + i + 1));
+
+        count += count_sse42<Upper>(_mm_unpacklo_epi64(first, second), target);
+    }
+
+    return count + count_scalar<Upper>(branches + i, size - i, key);
+}
+
+template <bool Upper>
+__attribute__((target("sse4.2"))) int count_sse42(const page_data_t* data,
+                                                   int size, int64_t key)
+{
+    const __m128i target = _mm_set1_epi64x(key);
+
+    int count = 0;
+    int i = 0;
+    for (; i + 2 <= size; i += 2)
+    {
+        count += count_sse42<Upper>(
+            _mm_set_epi64x(data[i + 1].key, data[i].key), target);
+    }
+
+    return count + count_scalar<Upper>(data + i, size - i, key);
+}
+
+template <bool Upper>
+__attribute__((target("avx2"))) int count_avx2(__m256i keys, __m256i target)
+{
+    const __m256i greater = Upper ? _mm256_cmpgt_epi64(keys, target)
+                                  : _mm256_cmpgt_epi64(target, keys);
+    const int mask = _mm256_movemask_pd(_mm256_castsi256_pd(greater));
+
+    return Upper ? 4 - __builtin_popcount(mask) : __builtin_popcount(mask);
+}
+
+template <bool Upper>
+__attribute__((target("avx2"))) int count_avx2(const page_branch_t* branches,
+                                                int size, int64_t key)
+{
+    const __m256i target = _mm256_set1_epi64x(key);
+
+    int count = 0;
+    int i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        // the keys of four branches, out of order within the lanes, which
+        // does not matter to a count
+        const __m256i first = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(branches + i));
+        const __m256i second = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(branches + i + 2));
+
+        count +=
+            count_avx2<Upper>(_mm256_unpacklo_epi64(first, second), target);
+    }
+
+    return count + count_scalar<Upper>(branches + i, size - i, key);
+}
+
+template <bool Upper>
+__attribute__((target("avx2"))) int count_avx2(const page_data_t* data,
+                                                int size, int64_t key)
+{
+    constexpr int STRIDE = sizeof(page_data_t) / sizeof(int64_t);
+
+    const __m256i target = _mm256_set1_epi64x(key);
+    const __m256i offsets =
+        _mm256_set_epi64x(3 * STRIDE, 2 * STRIDE, STRIDE, 0);
+
+    int count = 0;
+    int i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        const __m256i keys = _mm256_i64gather_epi64(
+            reinterpret_cast<const long long*>(&data[i].key), offsets, 8);
+
+        count += count_avx2<Upper>(keys, target);
+    }
+
+    return count + count_scalar<Upper>(data + i, size - i, key);
+}
+
+__attribute__((target("sse4.2"))) int find_child_sse42(
+    const page_branch_t* branches, int size, pagenum_t child)
+{
+    const __m128i target = _mm_set1_epi64x(child);
+
+    int i = 0;
+    for (; i + 2 <= size; i += 2)
+    {
+        // the child halves of two branches
+        const __m128i first = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(branches + i));
+        const __m128i second = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(branches + i + 1));
+
+        const int mask = _mm_movemask_pd(_mm_castsi128_pd(
+            _mm_cmpeq_epi64(_mm_unpackhi_epi64(first, second), target)));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    return (i < size && branches[i].child_page_number == child) ? i : size;
+}
+
+__attribute__((target("avx2"))) int find_child_avx2(
+    const page_branch_t* branches, int size, pagenum_t child)
+{
+    const __m256i target = _mm256_set1_epi64x(child);
+
+    int i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        const __m256i first = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(branches + i));
+        const __m256i second = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(branches + i + 2));
+
+        // the odd lanes hold the children, the even ones the keys
+        const int first_mask = _mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpeq_epi64(first, target)));
+        const int second_mask = _mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpeq_epi64(second, target)));
+
+        const int mask = (first_mask & 0b1010) | ((second_mask & 0b1010) << 4);
+        if (mask != 0)
+            return i + (__builtin_ctz(mask) - 1) / 2;
+    }
+
+    for (; i < size; ++i)
+    {
+        if (branches[i].child_page_number == child)
+            return i;
+    }
+
+    return size;
+}
+#endif
+
+template <bool Upper, typename T>
+int count(const T* entries, int size, int64_t key)
+{
+    switch (kernel_)
+    {
+#ifdef KEY_SEARCH_X86
+        case SearchKernel::AVX2:
+            return count_avx2<Upper>(entries, size, key);
+
+        case SearchKernel::SSE42:
+            return count_sse42<Upper>(entries, size, key);
+#endif
+
+        default:
+            return count_scalar<Upper>(entries, size, key);
+    }
+}
+
+// a binary search down to the window, whose keys are counted
+template <bool Upper, typename T>
+int search(const T* entries, int size, int64_t key, int window)
+{
+    if (kernel_ == SearchKernel::SCALAR)
+        window = 1;
+
+    int first = 0;
+    while (size > window)
+    {
+        const int half = size / 2;
+        if (counted<Upper>(entries[first + half].key, key))
+        {
+            first += half + 1;
+            size -= half + 1;
+        }
+        else
+        {
+            size = half;
+        }
+    }
+
+    return first + count<Upper>(entries + first, size, key);
+}
+}  // namespace
+
+namespace key_search
+{
+SearchKernel detect()
+{
+#ifdef KEY_SEARCH_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return SearchKernel::AVX2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return SearchKernel::SSE42;
+#endif
+
+    return SearchKernel::SCALAR;
+}
+
+SearchKernel kernel()
+{
+    return kernel_;
+}
+
+bool set_kernel(SearchKernel kernel)
+{
+    if (static_cast<int>(kernel) > static_cast<int>(detect()))
+        return false;
+
+    kernel_ = kernel;
+
+    return true;
+}
+
+int lower_bound(const page_data_t* data, int size, int64_t key)
+{
+    return search<false>(data, size, key, DATA_WINDOW);
+}
+
+int lower_bound(const page_branch_t* branches, int size, int64_t key)
+{
+    return search<false>(branches, size, key, BRANCH_WINDOW);
+}
+
+int upper_bound(const page_branch_t* branches, int size, int64_t key)
+{
+    return search<true>(branches, size, key, BRANCH_WINDOW);
+}
+
+int find_child(const page_branch_t* branches, int size, pagenum_t child)
+{
+    switch (kernel_)
+    {
+#ifdef KEY_SEARCH_X86
+        case SearchKernel::AVX2:
+            return find_child_avx2(branches, size, child);
+
+        case SearchKernel::SSE42:
+            return find_child_sse42(branches, size, child);
+#endif
+
+        default:
+            for (int i = 0; i < size; ++i)
+            {
+                if (branches[i].child_page_number == child)
+                    return i;
+            }
+
+            return size;
+    }
+}
+}  // namespace key_search
@@ -0,0 +1,33 @@
+#include "latch.h"
+
+void TreeLatch::lock()
+{
+    mutex_.lock();
+    version_.begin_write();
+}
+
+void TreeLatch::unlock()
+{
+    version_.end_write();
+    mutex_.unlock();
+}
+
+void TreeLatch::lock_shared()
+{
+    mutex_.lock_shared();
+}
+
+void TreeLatch::unlock_shared()
+{
+    mutex_.unlock_shared();
+}
+
+std::optional<version_t> TreeLatch::begin_read() const
+{
+    return version_.begin_read();
+}
+
+bool TreeLatch::validate(version_t version) const
+{
+    return version_.validate(version);
+}
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <cassert>
 #include <new>
+#include <utility>
 
 Lock::Lock(Xact* xact, LockType type, HashTableEntry* sentinel)
     : xact_(xact), type_(type), sentinel_(sentinel)
@@ -78,13 +79,38 @@ LockManager& LockManager::get_instance()
 std::tuple<Lock*, LockAcquireResult> LockManager::acquire(HierarchyID hid,
                                                           Xact* xact,
                                                           LockType type)
+{
+    std::scoped_lock lock(mutex_);
+
+    return acquire_locked(hid, xact, type);
+}
+
+LockAcquireResult LockManager::acquire_many(
+    const std::vector<HierarchyID>& hids, Xact* xact, LockType type,
+    std::vector<Lock*>& locks)
+{
+    std::scoped_lock lock(mutex_);
+
+    for (const HierarchyID& hid : hids)
+    {
+        auto [lk, result] = acquire_locked(hid, xact, type);
+        if (lk != nullptr)
+            locks.emplace_back(lk);
+
+        if (result != LockAcquireResult::ACQUIRED)
+            return result;
+    }
+
+    return LockAcquireResult::ACQUIRED;
+}
+
+std::tuple<Lock*, LockAcquireResult> LockManager::acquire_locked(
+    HierarchyID hid, Xact* xact, LockType type)
 {
     const xact_id xid = xact->id();
 
     assert(type != LockType::NONE);
 
-    std::unique_lock lock(mutex_);
-
     HashTableEntry* entry;
 
     auto it = entries_.find(hid);
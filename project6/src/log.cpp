@@ -185,6 +185,8 @@ bool LogManager::initialize(const std::string& log_path)
                             sizeof(log_file_header), 0) > 0);
     }
 
+    instance_->flushed_lsn_ = instance_->header_.next_lsn;
+
     return true;
 }
 
@@ -230,6 +232,23 @@ lsn_t LogManager::log_update(xact_id xid, lsn_t last_lsn,
     });
 }
 
+lsn_t LogManager::log_updates(xact_id xid, lsn_t last_lsn,
+                              const std::vector<RecordUpdate>& updates)
+{
+    std::scoped_lock lock(mutex_);
+
+    for (const auto& update : updates)
+    {
+        const lsn_t lsn = header_.next_lsn;
+        append_log(Log::create_update(xid, lsn, last_lsn, update.hid,
+                                      PAGE_DATA_VALUE_SIZE, update.old_value,
+                                      update.new_value));
+        last_lsn = lsn;
+    }
+
+    return last_lsn;
+}
+
 lsn_t LogManager::log_rollback(xact_id xid, lsn_t last_lsn)
 {
     return logging([&](lsn_t lsn) {
@@ -285,17 +304,28 @@ bool LogManager::force()
 
     CHECK_FAILURE(pwrite(f_log_, &header_, sizeof(log_file_header), 0) != -1);
 
-    for (const auto& log : log_)
+    // the records follow each other in the file, so they are written at
+    // once rather than by a synchronous write each
+    if (!log_.empty())
     {
-        const std::size_t size = log->size();
+        std::vector<char> records;
+        records.reserve(header_.next_lsn - log_.front()->lsn());
+
+        for (const auto& log : log_)
+        {
+            const char* data = reinterpret_cast<const char*>(log.get());
+            records.insert(end(records), data, data + log->size());
+        }
 
-        CHECK_FAILURE(pwrite(f_log_, log.get(), size,
-                             log->lsn() + sizeof(log_file_header)) != -1);
+        CHECK_FAILURE(pwrite(f_log_, records.data(), records.size(),
+                             log_.front()->lsn() +
+                                 sizeof(log_file_header)) != -1);
     }
 
     fsync(f_log_);
 
     log_.clear();
+    flushed_lsn_ = header_.next_lsn;
 
     return true;
 }
@@ -310,6 +340,11 @@ lsn_t LogManager::next_lsn() const
     return header_.next_lsn;
 }
 
+lsn_t LogManager::flushed_lsn() const
+{
+    return flushed_lsn_.load();
+}
+
 void LogManager::truncate_log()
 {
     ftruncate(f_log_, sizeof(log_file_header));
@@ -5,13 +5,13 @@
 #include <memory.h>
 #include <utility>
 
-Page::Page(BufferBlock& block) : block_(block)
+Page::Page(BufferBlock& block, PageLatch latch) : block_(block), latch_(latch)
 {
 }
 
 Page::~Page() noexcept
 {
-    block_.unlock();
+    block_.unlock(latch_);
 }
 
 void Page::clear()
@@ -34,6 +34,16 @@ table_id_t Page::table_id() const
     return block_.table_id();
 }
 
+std::optional<version_t> Page::begin_read() const
+{
+    return block_.version_.begin_read();
+}
+
+bool Page::validate(version_t version) const
+{
+    return block_.version_.validate(version);
+}
+
 page_header_t& Page::header()
 {
     return const_cast<page_header_t&>(std::as_const(*this).header());
@@ -64,6 +74,16 @@ const free_page_header_t& Page::free_header() const
     return block_.frame().node.free_header;
 }
 
+bitmap_page_t& Page::bitmap_page()
+{
+    return const_cast<bitmap_page_t&>(std::as_const(*this).bitmap_page());
+}
+
+const bitmap_page_t& Page::bitmap_page() const
+{
+    return block_.frame().bitmap;
+}
+
 page_branch_t* Page::branches()
 {
     return const_cast<page_branch_t*>(std::as_const(*this).branches());
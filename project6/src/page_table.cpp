@@ -0,0 +1,117 @@
+#include "page_table.h"
+
+#include <cassert>
+#include <functional>
+#include <limits>
+
+PageTable::PageTable(std::size_t max_entries)
+{
+    // at most half full, so that probe sequences stay short
+    std::size_t capacity = 8;
+    int bits = 3;
+    while (capacity < 2 * max_entries)
+    {
+        capacity <<= 1;
+        ++bits;
+    }
+
+    slots_.resize(capacity);
+    mask_ = capacity - 1;
+    shift_ = std::numeric_limits<std::size_t>::digits - bits;
+}
+
+BufferBlock* PageTable::find(const table_page_t& tpid) const
+{
+    if (slots_.empty())
+        return nullptr;
+
+    const auto [table_id, pagenum] = tpid;
+
+    for (std::size_t i = home(table_id, pagenum);; i = next(i))
+    {
+        const Slot& slot = slots_[i];
+
+        if (slot.block == nullptr)
+            return nullptr;
+
+        if (slot.table_id == table_id && slot.pagenum == pagenum)
+            return slot.block;
+    }
+}
+
+void PageTable::insert(const table_page_t& tpid, BufferBlock* block)
+{
+    // one slot has to stay empty to end the probe sequences
+    assert(size_ + 1 < slots_.size());
+    assert(block != nullptr);
+
+    const auto [table_id, pagenum] = tpid;
+
+    std::size_t i = home(table_id, pagenum);
+    while (slots_[i].block != nullptr)
+    {
+        assert(slots_[i].table_id != table_id || slots_[i].pagenum != pagenum);
+        i = next(i);
+    }
+
+    slots_[i] = Slot{ table_id, pagenum, block };
+    ++size_;
+}
+
+void PageTable::erase(const table_page_t& tpid)
+{
+    if (slots_.empty())
+        return;
+
+    const auto [table_id, pagenum] = tpid;
+
+    std::size_t hole = home(table_id, pagenum);
+    while (slots_[hole].table_id != table_id ||
+           slots_[hole].pagenum != pagenum)
+    {
+        if (slots_[hole].block == nullptr)
+            return;
+
+        hole = next(hole);
+    }
+
+    // move back every following entry that may not live behind the hole,
+    // so that no probe sequence is cut by it
+    for (std::size_t i = next(hole); slots_[i].block != nullptr; i = next(i))
+    {
+        const std::size_t h = home(slots_[i].table_id, slots_[i].pagenum);
+
+        const bool reachable =
+            (hole <= i) ? (hole < h && h <= i) : (hole < h || h <= i);
+        if (reachable)
+            continue;
+
+        slots_[hole] = slots_[i];
+        hole = i;
+    }
+
+    slots_[hole] = Slot();
+    --size_;
+}
+
+std::size_t PageTable::size() const
+{
+    return size_;
+}
+
+std::size_t PageTable::capacity() const
+{
+    return slots_.size();
+}
+
+std::size_t PageTable::home(table_id_t table_id, pagenum_t pagenum) const
+{
+    // the low bits of the hash pick the buffer partition, so the slot is
+    // taken from the high bits
+    return std::hash<table_page_t>()({ table_id, pagenum }) >> shift_;
+}
+
+std::size_t PageTable::next(std::size_t index) const
+{
+    return (index + 1) & mask_;
+}
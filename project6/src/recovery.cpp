@@ -97,8 +97,15 @@ bool Recovery::redo()
     f_log_msg_ << "[REDO] Redo pass start\n";
 
     const lsn_t next_lsn = LogMgr().next_lsn();
+
+    // the pages of the following records are read while this one is redone
+    lsn_t prefetch_lsn = prefetch_redo(LogMgr().base_lsn(), next_lsn,
+                                       REDO_PREFETCH_DISTANCE);
+
     for (lsn_t lsn = LogMgr().base_lsn(); lsn < next_lsn;)
     {
+        prefetch_lsn = prefetch_redo(prefetch_lsn, next_lsn, 1);
+
         Log& log = logs_[lsn];
 
         f_log_msg_ << "LSN " << lsn + log.size() << " ";
@@ -176,6 +183,24 @@ bool Recovery::redo()
     return true;
 }
 
+lsn_t Recovery::prefetch_redo(lsn_t lsn, lsn_t next_lsn, int num_records)
+{
+    for (int i = 0; i < num_records && lsn < next_lsn; ++i)
+    {
+        Log& log = logs_[lsn];
+
+        if (log.type() == LogType::UPDATE || log.type() == LogType::COMPENSATE)
+        {
+            if (auto table = TblMgr().get_table(log.table_id()); table)
+                BufMgr().prefetch(*table.value(), log.pagenum());
+        }
+
+        lsn += log.size();
+    }
+
+    return lsn;
+}
+
 bool Recovery::undo()
 {
     f_log_msg_ << "[UNDO] Undo pass start\n";
@@ -237,7 +262,7 @@ bool Recovery::undo()
                         page.mark_dirty();
                     }
                 },
-                *table, log.pagenum(), false));
+                *table, log.pagenum(), PageLatch::EXCLUSIVE));
 
             if ((losers_[nexttrans] = log.last_lsn()) == NULL_LSN)
                 --no_nil_loser;
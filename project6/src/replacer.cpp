@@ -0,0 +1,342 @@
+#include "replacer.h"
+
+#include "buffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+BufferBlock* BlockList::head() const
+{
+    return head_;
+}
+
+std::size_t BlockList::size() const
+{
+    return size_;
+}
+
+bool BlockList::empty() const
+{
+    return size_ == 0;
+}
+
+void BlockList::push_back(BufferBlock* block)
+{
+    // <- past       new ->
+    //  head <> ... <> tail
+
+    if (head_ == nullptr)
+    {
+        head_ = block;
+
+        block->prev_ = block;
+        block->next_ = block;
+
+        ++size_;
+        return;
+    }
+
+    insert_before(head_, block);
+}
+
+void BlockList::insert_before(BufferBlock* pos, BufferBlock* block)
+{
+    BufferBlock* prev = pos->prev_;
+
+    block->prev_ = prev;
+    block->next_ = pos;
+
+    prev->next_ = block;
+    pos->prev_ = block;
+
+    ++size_;
+}
+
+void BlockList::remove(BufferBlock* block)
+{
+    assert(size_ > 0);
+
+    if (block->next_ == block)
+    {
+        head_ = nullptr;
+    }
+    else
+    {
+        block->prev_->next_ = block->next_;
+        block->next_->prev_ = block->prev_;
+
+        if (block == head_)
+            head_ = block->next_;
+    }
+
+    block->prev_ = nullptr;
+    block->next_ = nullptr;
+
+    --size_;
+}
+
+void BlockList::move_to_back(BufferBlock* block)
+{
+    if (block == head_)
+    {
+        // rotating the ring is enough
+        head_ = head_->next_;
+        return;
+    }
+
+    if (block == head_->prev_)
+        return;
+
+    remove(block);
+    push_back(block);
+}
+
+void BlockList::collect(BufferBlock* from, std::vector<BufferBlock*>& blocks,
+                        std::size_t limit) const
+{
+    BufferBlock* current = from;
+    for (std::size_t i = 0; i < size_ && blocks.size() < limit; ++i)
+    {
+        blocks.emplace_back(current);
+        current = current->next_;
+    }
+}
+
+std::unique_ptr<Replacer> Replacer::create(ReplacementPolicy policy,
+                                           int num_frames)
+{
+    switch (policy)
+    {
+        case ReplacementPolicy::LRU:
+            return std::make_unique<LRUReplacer>();
+
+        case ReplacementPolicy::CLOCK:
+            return std::make_unique<ClockReplacer>();
+
+        case ReplacementPolicy::TWO_Q:
+            return std::make_unique<TwoQReplacer>(num_frames);
+    }
+
+    return nullptr;
+}
+
+void LRUReplacer::insert(BufferBlock* block)
+{
+    list_.push_back(block);
+}
+
+void LRUReplacer::touch(BufferBlock* block)
+{
+    list_.move_to_back(block);
+}
+
+void LRUReplacer::erase(BufferBlock* block)
+{
+    list_.remove(block);
+}
+
+BufferBlock* LRUReplacer::victim()
+{
+    BufferBlock* victim = list_.head();
+    for (std::size_t i = 0; i < list_.size(); ++i, victim = victim->next_)
+    {
+        if (victim->pin_count() == 0)
+            return victim;
+    }
+
+    return nullptr;
+}
+
+void LRUReplacer::cold_blocks(std::vector<BufferBlock*>& blocks,
+                              std::size_t limit) const
+{
+    list_.collect(list_.head(), blocks, limit);
+}
+
+void ClockReplacer::insert(BufferBlock* block)
+{
+    block->referenced_ = false;
+
+    if (hand_ == nullptr)
+    {
+        ring_.push_back(block);
+        hand_ = block;
+        return;
+    }
+
+    // place the new block right behind the hand,
+    // so it survives one full sweep
+    ring_.insert_before(hand_, block);
+}
+
+void ClockReplacer::touch(BufferBlock* block)
+{
+    block->referenced_.store(true, std::memory_order_relaxed);
+}
+
+void ClockReplacer::erase(BufferBlock* block)
+{
+    if (hand_ == block)
+        hand_ = (ring_.size() == 1) ? nullptr : block->next_;
+
+    ring_.remove(block);
+}
+
+BufferBlock* ClockReplacer::victim()
+{
+    // two sweeps clear every reference bit
+    const std::size_t max_steps = 2 * ring_.size() + 1;
+    for (std::size_t i = 0; i < max_steps && hand_ != nullptr; ++i)
+    {
+        BufferBlock* current = hand_;
+        hand_ = hand_->next_;
+
+        if (current->pin_count() > 0)
+            continue;
+
+        if (current->referenced_.exchange(false, std::memory_order_relaxed))
+            continue;
+
+        return current;
+    }
+
+    return nullptr;
+}
+
+void ClockReplacer::cold_blocks(std::vector<BufferBlock*>& blocks,
+                                std::size_t limit) const
+{
+    ring_.collect(hand_, blocks, limit);
+}
+
+TwoQReplacer::TwoQReplacer(int num_frames)
+    : kin_(std::max(1, num_frames / 4)), kout_(std::max(1, num_frames / 2))
+{
+}
+
+void TwoQReplacer::insert(BufferBlock* block)
+{
+    block->referenced_ = false;
+
+    const table_page_t tpid{ block->table_id(), block->pagenum() };
+
+    auto it = a1out_tbl_.find(tpid);
+    if (it == end(a1out_tbl_))
+    {
+        // first reference
+        block->queue_ = BufferBlock::QUEUE_A1IN;
+        a1in_.push_back(block);
+        return;
+    }
+
+    // referenced again after leaving A1in, so it is a hot page
+    a1out_.erase(it->second);
+    a1out_tbl_.erase(it);
+
+    block->queue_ = BufferBlock::QUEUE_AM;
+    if (hand_ == nullptr)
+    {
+        am_.push_back(block);
+        hand_ = block;
+    }
+    else
+    {
+        am_.insert_before(hand_, block);
+    }
+}
+
+void TwoQReplacer::touch(BufferBlock* block)
+{
+    // correlated references in A1in are ignored on purpose
+    if (block->queue_ == BufferBlock::QUEUE_AM)
+        block->referenced_.store(true, std::memory_order_relaxed);
+}
+
+void TwoQReplacer::erase(BufferBlock* block)
+{
+    if (block->queue_ == BufferBlock::QUEUE_A1IN)
+    {
+        a1in_.remove(block);
+        remember({ block->table_id(), block->pagenum() });
+    }
+    else if (block->queue_ == BufferBlock::QUEUE_AM)
+    {
+        if (hand_ == block)
+            hand_ = (am_.size() == 1) ? nullptr : block->next_;
+
+        am_.remove(block);
+    }
+
+    block->queue_ = BufferBlock::QUEUE_NONE;
+}
+
+BufferBlock* TwoQReplacer::victim()
+{
+    BufferBlock* victim = nullptr;
+
+    if (a1in_.size() > kin_ || am_.empty())
+        victim = victim_from_a1in();
+
+    if (victim == nullptr)
+        victim = victim_from_am();
+
+    if (victim == nullptr)
+        victim = victim_from_a1in();
+
+    return victim;
+}
+
+BufferBlock* TwoQReplacer::victim_from_a1in()
+{
+    BufferBlock* victim = a1in_.head();
+    for (std::size_t i = 0; i < a1in_.size(); ++i, victim = victim->next_)
+    {
+        if (victim->pin_count() == 0)
+            return victim;
+    }
+
+    return nullptr;
+}
+
+BufferBlock* TwoQReplacer::victim_from_am()
+{
+    const std::size_t max_steps = 2 * am_.size() + 1;
+    for (std::size_t i = 0; i < max_steps && hand_ != nullptr; ++i)
+    {
+        BufferBlock* current = hand_;
+        hand_ = hand_->next_;
+
+        if (current->pin_count() > 0)
+            continue;
+
+        if (current->referenced_.exchange(false, std::memory_order_relaxed))
+            continue;
+
+        return current;
+    }
+
+    return nullptr;
+}
+
+void TwoQReplacer::cold_blocks(std::vector<BufferBlock*>& blocks,
+                               std::size_t limit) const
+{
+    a1in_.collect(a1in_.head(), blocks, limit);
+    am_.collect(hand_, blocks, limit);
+}
+
+void TwoQReplacer::remember(const table_page_t& tpid)
+{
+    if (a1out_tbl_.count(tpid) > 0)
+        return;
+
+    a1out_.push_back(tpid);
+    a1out_tbl_.emplace(tpid, std::prev(end(a1out_)));
+
+    if (a1out_.size() > kout_)
+    {
+        a1out_tbl_.erase(a1out_.front());
+        a1out_.pop_front();
+    }
+}
@@ -15,6 +15,11 @@ const std::string& Table::filename() const
     return filename_;
 }
 
+bool Table::read_only() const
+{
+    return read_only_;
+}
+
 bool Table::insert(const page_data_t& record)
 {
     return BPTree::insert(*this, record);
@@ -30,11 +35,66 @@ std::optional<page_data_t> Table::find(int64_t key, Xact* xact)
     return BPTree::find(*this, key, xact);
 }
 
+bool Table::find_many(const std::vector<int64_t>& keys,
+                      std::vector<std::optional<page_data_t>>& records,
+                      Xact* xact)
+{
+    return BPTree::find_many(*this, keys, records, xact);
+}
+
 bool Table::update(int64_t key, const char* value, Xact* xact)
 {
     return BPTree::update(*this, key, value, xact);
 }
 
+bool Table::insert_many(const std::vector<page_data_t>& records,
+                        std::vector<bool>& inserted)
+{
+    return BPTree::insert_many(*this, records, inserted);
+}
+
+bool Table::update_many(const std::vector<page_data_t>& records,
+                        std::vector<bool>& updated, Xact* xact)
+{
+    return BPTree::update_many(*this, records, updated, xact);
+}
+
+const TreePolicy& Table::policy() const
+{
+    return policy_;
+}
+
+void Table::set_policy(const TreePolicy& policy)
+{
+    policy_ = policy;
+}
+
+std::optional<LeafLayout> Table::leaf_layout()
+{
+    return BPTree::leaf_layout(*this);
+}
+
+std::optional<CompactionStats> Table::compact(int max_pages)
+{
+    return BPTree::compact(*this, max_pages);
+}
+
+std::optional<uint64_t> Table::bulk_load(
+    const std::function<bool(page_data_t&)>& next, double fill_factor)
+{
+    return BPTree::bulk_load(*this, next, fill_factor);
+}
+
+bool Table::scan(ScanCursor& cursor, Xact* xact)
+{
+    return BPTree::scan(*this, cursor, xact);
+}
+
+CompactionCursor& Table::compaction_cursor()
+{
+    return compaction_cursor_;
+}
+
 void Table::set_file(File* file)
 {
     file_ = file;
@@ -45,19 +105,37 @@ File* Table::file()
     return file_;
 }
 
-Table::Table(table_id_t id, std::string filename)
-    : id_(id), filename_(std::move(filename))
+void Table::set_mapped_file(MappedFile* mapped_file)
 {
+    mapped_file_ = mapped_file;
 }
 
-bool TableManager::initialize(int num_buf)
+MappedFile* Table::mapped_file()
+{
+    return mapped_file_;
+}
+
+TreeLatch& Table::tree_latch()
+{
+    return *tree_latch_;
+}
+
+Table::Table(table_id_t id, std::string filename, bool read_only)
+    : id_(id),
+      filename_(std::move(filename)),
+      read_only_(read_only),
+      tree_latch_(std::make_unique<TreeLatch>())
+{
+}
+
+bool TableManager::initialize(int num_buf, const DBConfig& config)
 {
     CHECK_FAILURE(instance_ == nullptr);
 
     instance_ = new (std::nothrow) TableManager;
     CHECK_FAILURE(instance_ != nullptr);
 
-    return BPTree::initialize(num_buf);
+    return BPTree::initialize(num_buf, config);
 }
 
 bool TableManager::shutdown()
@@ -82,7 +160,8 @@ bool TableManager::is_initialized()
     return instance_ != nullptr;
 }
 
-std::optional<table_id_t> TableManager::open_table(const std::string& filename)
+std::optional<table_id_t> TableManager::open_table(const std::string& filename,
+                                                   bool read_only)
 {
     std::regex re("DATA\\d+", std::regex::optimize);
     if (!std::regex_match(filename, re) && filename.find("DATA") != 0)
@@ -100,11 +179,13 @@ std::optional<table_id_t> TableManager::open_table(const std::string& filename)
 
     if (auto tblIt = tables_.find(new_table_id); tblIt != end(tables_))
     {
+        CHECK_FAILURE2(tblIt->second.read_only() == read_only, std::nullopt);
+
         return tblIt->second.id();
     }
 
-    Table table(new_table_id, filename);
-    CHECK_FAILURE(BPTree::open_table(table));
+    Table table(new_table_id, filename, read_only);
+    CHECK_FAILURE2(BPTree::open_table(table), std::nullopt);
 
     table_ids_.insert_or_assign(filename, new_table_id);
     tables_.insert_or_assign(new_table_id, std::move(table));
@@ -147,3 +228,30 @@ std::optional<Table*> TableManager::get_table(table_id_t tid)
 
     return &it->second;
 }
+
+int TableManager::open_scan(ScanCursor cursor)
+{
+    std::scoped_lock lock(scan_mutex_);
+
+    const int scan_id = next_scan_id_++;
+    scans_.emplace(scan_id, std::move(cursor));
+
+    return scan_id;
+}
+
+std::optional<ScanCursor*> TableManager::get_scan(int scan_id)
+{
+    std::scoped_lock lock(scan_mutex_);
+
+    auto it = scans_.find(scan_id);
+    CHECK_FAILURE2(it != end(scans_), std::nullopt);
+
+    return &it->second;
+}
+
+bool TableManager::close_scan(int scan_id)
+{
+    std::scoped_lock lock(scan_mutex_);
+
+    return scans_.erase(scan_id) > 0;
+}
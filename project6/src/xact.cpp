@@ -21,16 +21,10 @@ xact_id Xact::id() const
 LockAcquireResult Xact::add_lock(HierarchyID hid, LockType type,
                                  Lock** lock_obj)
 {
-    if (auto it = std::find_if(begin(locks_), end(locks_),
-                               [&](const Lock* lock) -> bool {
-                                   return (static_cast<int>(lock->type()) >=
-                                               static_cast<int>(type) &&
-                                           lock->sentinel()->hid == hid);
-                               });
-        it != end(locks_))
+    if (Lock* lk = find_lock(hid, type); lk != nullptr)
     {
         if (lock_obj != nullptr)
-            *lock_obj = *it;
+            *lock_obj = lk;
 
         return LockAcquireResult::ACQUIRED;
     }
@@ -50,6 +44,51 @@ LockAcquireResult Xact::add_lock(HierarchyID hid, LockType type,
     return result;
 }
 
+LockAcquireResult Xact::add_locks(const std::vector<HierarchyID>& hids,
+                                  LockType type, std::size_t& num_acquired,
+                                  Lock** lock_obj)
+{
+    // only the locks not held yet go to the lock manager
+    std::vector<HierarchyID> missing;
+    std::vector<std::size_t> indexes;
+    for (std::size_t i = 0; i < hids.size(); ++i)
+    {
+        if (find_lock(hids[i], type) == nullptr)
+        {
+            missing.push_back(hids[i]);
+            indexes.push_back(i);
+        }
+    }
+
+    std::vector<Lock*> locks;
+    const LockAcquireResult result =
+        missing.empty()
+            ? LockAcquireResult::ACQUIRED
+            : LockMgr().acquire_many(missing, this, type, locks);
+
+    locks_.insert(end(locks_), begin(locks), end(locks));
+
+    if (result == LockAcquireResult::ACQUIRED)
+    {
+        num_acquired = hids.size();
+        return result;
+    }
+
+    // the lock waited for is the last one given back
+    std::size_t blocked = locks.size();
+    if (result == LockAcquireResult::NEED_TO_WAIT)
+    {
+        --blocked;
+
+        if (lock_obj != nullptr)
+            *lock_obj = locks.back();
+    }
+
+    num_acquired = indexes[blocked];
+
+    return result;
+}
+
 bool Xact::release_all_locks()
 {
     for (auto& lk : locks_)
@@ -90,7 +129,7 @@ bool Xact::undo()
                            log->length());
                     page.mark_dirty();
                 },
-                *table, hid.pagenum, false));
+                *table, hid.pagenum, PageLatch::EXCLUSIVE));
         }
     }
 
@@ -124,6 +163,16 @@ lsn_t Xact::last_lsn() const
     return last_lsn_;
 }
 
+Lock* Xact::find_lock(const HierarchyID& hid, LockType type) const
+{
+    auto it = std::find_if(begin(locks_), end(locks_), [&](const Lock* lock) {
+        return static_cast<int>(lock->type()) >= static_cast<int>(type) &&
+               lock->sentinel()->hid == hid;
+    });
+
+    return (it != end(locks_)) ? *it : nullptr;
+}
+
 bool XactManager::initialize()
 {
     CHECK_FAILURE(instance_ == nullptr);
@@ -215,6 +264,13 @@ Xact* XactManager::get(xact_id id) const
     return it->second;
 }
 
+std::size_t XactManager::num_active() const
+{
+    std::scoped_lock lock(mutex_);
+
+    return xacts_.size();
+}
+
 void XactManager::acquire_xact_lock(Xact* xact)
 {
     std::scoped_lock lock(mutex_);
@@ -0,0 +1,81 @@
+#ifndef TEST_UTIL_H_
+#define TEST_UTIL_H_
+
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+// what the unit tests share: the files of the database they open, the
+// failures counted by expect(), and the records inserted with a value
+// named after their key
+
+inline constexpr const char* TABLE_NAME = "DATA1";
+inline constexpr const char* LOG_PATH = "unittest.log";
+inline constexpr const char* LOGMSG_PATH = "unittest_logmsg.txt";
+
+// small, so that the tests also go to the file
+inline constexpr int TEST_NUM_BUF = 256;
+
+inline std::atomic<int> num_errors{ 0 };
+
+// only the first failures are printed, all of them are counted
+inline void expect(bool cond, const char* what)
+{
+    if (!cond && num_errors++ < 10)
+        std::fprintf(stderr, "FAIL: %s\n", what);
+}
+
+inline std::string value_of(int64_t key)
+{
+    return "value" + std::to_string(key);
+}
+
+inline bool open_db(int num_buf = TEST_NUM_BUF,
+                    const DBConfig& config = DBConfig())
+{
+    return init_db(num_buf, 0, 0, const_cast<char*>(LOG_PATH),
+                   const_cast<char*>(LOGMSG_PATH), config) == SUCCESS;
+}
+
+inline Table& table_of(int table_id)
+{
+    return *TblMgr().get_table(table_id).value();
+}
+
+inline void insert(int table_id, int64_t key)
+{
+    expect(db_insert(table_id, key,
+                     const_cast<char*>(value_of(key).c_str())) == SUCCESS,
+           "insert");
+}
+
+// the table and the log, before a test starts on a new table
+inline void remove_db()
+{
+    unlink(TABLE_NAME);
+    unlink(LOG_PATH);
+}
+
+// the exit code of the test, once its files are removed
+inline int test_result()
+{
+    remove_db();
+    unlink(LOGMSG_PATH);
+
+    if (num_errors > 0)
+    {
+        std::printf("%d errors\n", num_errors.load());
+        return 1;
+    }
+
+    std::printf("OK\n");
+    return 0;
+}
+
+#endif  // TEST_UTIL_H_
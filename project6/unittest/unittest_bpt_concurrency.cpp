@@ -0,0 +1,279 @@
+// multi-threaded insert / find / delete stress test of the b+ tree.
+// it has to pass without any serialization outside the library.
+// then transactions are aborted on a deadlock while readers latch the leaf.
+//
+// usage: unittest_bpt_concurrency [keys_per_thread] [threads]
+
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// with the key, for the failures of the workers
+void expect(bool cond, const char* what, int64_t key)
+{
+    if (!cond && num_errors++ < 10)
+        std::fprintf(stderr, "FAIL: %s (key %ld)\n", what, key);
+}
+
+bool find_value(int table_id, int64_t key, std::string& value)
+{
+    auto res = table_of(table_id).find(key, nullptr);
+    if (!res.has_value())
+        return false;
+
+    value = res.value().value;
+    return true;
+}
+
+template <typename Function>
+void run_threads(int num_threads, Function&& func)
+{
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i)
+        threads.emplace_back(func, i);
+    for (auto& t : threads)
+        t.join();
+}
+
+// keys are interleaved between the threads, so they split the same leaves
+int64_t key_of(int thread, int i, int num_threads)
+{
+    return static_cast<int64_t>(i) * num_threads + thread;
+}
+
+void insert_and_find(int table_id, int num_keys, int num_threads)
+{
+    // half of the threads insert, the others look up what is already there
+    const int num_writers = (num_threads + 1) / 2;
+    std::vector<std::atomic<int>> progress(num_writers);
+
+    run_threads(num_threads, [&](int thread) {
+        if (thread < num_writers)
+        {
+            for (int i = 0; i < num_keys; ++i)
+            {
+                const int64_t key = key_of(thread, i, num_writers);
+                std::string value = value_of(key);
+
+                expect(db_insert(table_id, key, value.data()) == SUCCESS,
+                       "insert", key);
+                progress[thread] = i + 1;
+            }
+            return;
+        }
+
+        for (int round = 0; round < 4; ++round)
+        {
+            for (int writer = 0; writer < num_writers; ++writer)
+            {
+                const int inserted = progress[writer];
+                for (int i = 0; i < inserted; ++i)
+                {
+                    const int64_t key = key_of(writer, i, num_writers);
+
+                    std::string value;
+                    expect(find_value(table_id, key, value),
+                           "find of an inserted key", key);
+                    expect(value == value_of(key), "value of a found key",
+                           key);
+                }
+            }
+        }
+    });
+
+    // duplicated keys are rejected, even when inserted concurrently
+    std::atomic<int> num_success{ 0 };
+    run_threads(num_threads, [&](int) {
+        for (int i = 0; i < num_keys; i += 16)
+        {
+            std::string value = value_of(i);
+            if (db_insert(table_id, i, value.data()) == SUCCESS)
+                ++num_success;
+        }
+    });
+    expect(num_success == 0, "insert of a duplicated key", -1);
+}
+
+// odd keys leave the leaves half full, the upper half empties them,
+// so both the in-leaf removal and the merges run concurrently
+bool is_deleted(int64_t key, int64_t total)
+{
+    return key % 2 == 1 || key >= total / 2;
+}
+
+void delete_and_find(int table_id, int num_keys, int num_threads)
+{
+    const int num_writers = (num_threads + 1) / 2;
+    const int64_t total = static_cast<int64_t>(num_keys) * num_writers;
+
+    run_threads(num_threads, [&](int thread) {
+        if (thread < num_writers)
+        {
+            for (int64_t key = thread; key < total; key += num_writers)
+            {
+                if (is_deleted(key, total))
+                    expect(db_delete(table_id, key) == SUCCESS, "delete",
+                           key);
+            }
+            return;
+        }
+
+        for (int64_t key = 0; key < total / 2; key += 2)
+        {
+            std::string value;
+            expect(find_value(table_id, key, value),
+                   "find of a key that is not deleted", key);
+            expect(value == value_of(key), "value of a found key", key);
+        }
+    });
+}
+
+void verify(int table_id, int num_keys, int num_threads)
+{
+    const int num_writers = (num_threads + 1) / 2;
+    const int64_t total = static_cast<int64_t>(num_keys) * num_writers;
+
+    for (int64_t key = 0; key < total; ++key)
+    {
+        std::string value;
+        const bool found = find_value(table_id, key, value);
+
+        if (!is_deleted(key, total))
+        {
+            expect(found, "find after the workers are done", key);
+            expect(value == value_of(key), "value after the workers are done",
+                   key);
+        }
+        else
+        {
+            expect(!found, "find of a deleted key", key);
+        }
+    }
+}
+
+// two transactions wait for each other on records next to each other. the
+// one that finds the deadlock, in an update or a find, is aborted once it
+// no longer latches the leaf, while readers keep latching it.
+void abort_on_deadlock(int table_id, int num_threads, int64_t key,
+                       bool by_find)
+{
+    for (int64_t k = key; k < key + 2; ++k)
+    {
+        std::string value = value_of(k);
+        expect(db_insert(table_id, k, value.data()) == SUCCESS, "insert", k);
+    }
+
+    char locked[] = "locked";
+    const int first = trx_begin();
+    const int second = trx_begin();
+    expect(db_update(table_id, key, locked, first) == SUCCESS, "update", key);
+    expect(db_update(table_id, key + 1, locked, second) == SUCCESS, "update",
+           key + 1);
+
+    std::atomic<bool> done{ false };
+    std::vector<std::thread> readers;
+    for (int i = 0; i < num_threads; ++i)
+    {
+        readers.emplace_back([&] {
+            while (!done)
+            {
+                std::string value;
+                expect(find_value(table_id, key + 1, value),
+                       "find during an abort", key + 1);
+            }
+        });
+    }
+
+    // the first waits for the second
+    std::thread waiter([&] {
+        char value[] = "first";
+        expect(db_update(table_id, key + 1, value, first) == SUCCESS,
+               "update after the abort", key + 1);
+        expect(trx_commit(first) == first, "commit", key + 1);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // and the second for the first
+    if (by_find)
+    {
+        char value[PAGE_DATA_VALUE_SIZE];
+        expect(db_find(table_id, key, value, second) != SUCCESS,
+               "a deadlock in find", key);
+    }
+    else
+    {
+        char value[] = "second";
+        expect(db_update(table_id, key, value, second) != SUCCESS,
+               "a deadlock in update", key);
+    }
+
+    waiter.join();
+    done = true;
+    for (auto& t : readers)
+        t.join();
+
+    std::string value;
+    expect(find_value(table_id, key, value) && value == "locked",
+           "the update of the committed transaction", key);
+    expect(find_value(table_id, key + 1, value) && value == "first",
+           "the update after the abort", key + 1);
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_keys = (argc > 1) ? std::atoi(argv[1]) : 20000;
+    const int num_threads = (argc > 2) ? std::atoi(argv[2]) : 8;
+
+    remove_db();
+
+    if (!open_db())
+    {
+        std::fprintf(stderr, "failed to initialize the database\n");
+        return 1;
+    }
+
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+    if (table_id < 0)
+    {
+        std::fprintf(stderr, "failed to open %s\n", TABLE_NAME);
+        return 1;
+    }
+
+    insert_and_find(table_id, num_keys, num_threads);
+    std::printf("insert / find is done.\n");
+
+    delete_and_find(table_id, num_keys, num_threads);
+    std::printf("delete / find is done.\n");
+
+    verify(table_id, num_keys, num_threads);
+
+    abort_on_deadlock(table_id, num_threads, -4, false);
+    abort_on_deadlock(table_id, num_threads, -2, true);
+    std::printf("abort on a deadlock is done.\n");
+
+    // the pages written through the buffer pool have to read back the same
+    expect(shutdown_db() == SUCCESS, "shutdown", -1);
+    unlink(LOG_PATH);
+
+    expect(open_db(), "reopen", -1);
+    verify(open_table(const_cast<char*>(TABLE_NAME)), num_keys, num_threads);
+    expect(shutdown_db() == SUCCESS, "shutdown", -1);
+
+    return test_result();
+}
@@ -0,0 +1,214 @@
+// bottom-up bulk loading of a table. every record loaded is found, the
+// leaves are filled to the fill factor and placed in key order, and the
+// tree is changed and reopened afterwards. a table which is not empty or
+// keys out of order are refused, and the table is left empty.
+//
+// usage: unittest_bulk_load [records]
+
+#include "bpt.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+// the keys loaded are spread, so that inserts fall between them
+constexpr int64_t KEY_STEP = 3;
+
+// the keys from first to last by KEY_STEP, then one out of order when
+// misplaced is not negative
+struct Source final
+{
+    int64_t next;
+    int64_t last;
+    int64_t misplaced{ -1 };
+};
+
+int next_record(void* context, int64_t* key, char* value)
+{
+    Source& source = *static_cast<Source*>(context);
+    if (source.next > source.last)
+    {
+        if (source.misplaced < 0)
+            return 0;
+
+        *key = source.misplaced;
+        source.misplaced = -1;
+    }
+    else
+    {
+        *key = source.next;
+        source.next += KEY_STEP;
+    }
+
+    std::strcpy(value, value_of(*key).c_str());
+    return 1;
+}
+
+// a new table in a new database
+int open_new_table()
+{
+    remove_db();
+
+    if (!open_db())
+        return -1;
+
+    return open_table(const_cast<char*>(TABLE_NAME));
+}
+
+// the header page, bitmap pages and nodes
+uint64_t used_pages(int table_id)
+{
+    File& file = *table_of(table_id).file();
+    return file.num_pages() - file.free_space().num_free();
+}
+
+void check_records(int table_id, const std::set<int64_t>& keys,
+                   int64_t max_key)
+{
+    for (int64_t key = 0; key <= max_key; ++key)
+    {
+        const auto record = table_of(table_id).find(key, nullptr);
+        if (keys.count(key) == 0)
+        {
+            expect(!record.has_value(), "a key not loaded found");
+            continue;
+        }
+
+        expect(record.has_value() && value_of(key) == record->value,
+               "a record loaded");
+    }
+}
+
+void run(int64_t num_records, double fill_factor)
+{
+    int table_id = open_new_table();
+    expect(table_id > 0, "init");
+
+    const int64_t max_key = num_records * KEY_STEP;
+    Source source{ 0, max_key - KEY_STEP };
+
+    int64_t loaded = 0;
+    expect(db_bulk_load(table_id, next_record, &source, fill_factor,
+                        &loaded) == SUCCESS,
+           "bulk load");
+    expect(loaded == num_records, "records loaded");
+
+    std::set<int64_t> keys;
+    for (int64_t key = 0; key < max_key; key += KEY_STEP)
+        keys.insert(key);
+
+    check_records(table_id, keys, max_key);
+
+    const auto layout = table_of(table_id).leaf_layout();
+    const int64_t per_leaf = std::max<int64_t>(
+        1, std::lround(fill_factor * (BPTree::LEAF_ORDER - 1)));
+    expect(layout.has_value() &&
+               static_cast<int64_t>(layout->num_leaves) ==
+                   (num_records + per_leaf - 1) / per_leaf,
+           "leaves filled to the fill factor");
+    // a leaf is not followed by its sibling only where a run of inner
+    // nodes comes between
+    expect(layout.has_value() && layout->fragmentation() < 0.05,
+           "leaves in key order");
+
+    // the tree takes inserts and deletes like one built by inserts
+    std::mt19937 gen(1);
+    for (int i = 0; i < num_records; ++i)
+    {
+        const int64_t key = gen() % (max_key + 100);
+        if (keys.count(key) != 0)
+        {
+            expect(db_delete(table_id, key) == SUCCESS, "delete");
+            keys.erase(key);
+        }
+        else
+        {
+            expect(db_insert(table_id, key,
+                             const_cast<char*>(value_of(key).c_str())) ==
+                       SUCCESS,
+                   "insert");
+            keys.insert(key);
+        }
+    }
+
+    check_records(table_id, keys, max_key + 100);
+    expect(shutdown_db() == SUCCESS, "shutdown");
+
+    unlink(LOG_PATH);
+    expect(open_db(), "reopen");
+    table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    check_records(table_id, keys, max_key + 100);
+    expect(table_of(table_id).leaf_layout().has_value(), "sibling chain");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+void run_refused()
+{
+    const int table_id = open_new_table();
+    expect(table_id > 0, "init");
+
+    Source source{ 0, 0 };
+    expect(db_bulk_load(table_id, next_record, &source, 0, nullptr) != SUCCESS,
+           "a fill factor of zero");
+    expect(db_bulk_load(table_id, next_record, &source, 1.5, nullptr) !=
+               SUCCESS,
+           "a fill factor over one");
+
+    // nothing to load
+    source = { 0, -1 };
+    int64_t loaded = -1;
+    expect(db_bulk_load(table_id, next_record, &source, 1, &loaded) ==
+                   SUCCESS &&
+               loaded == 0,
+           "no record");
+
+    // a key out of order after enough records for a few levels
+    source = { 0, 30000 * KEY_STEP, 1 };
+    const uint64_t used_before = used_pages(table_id);
+    expect(db_bulk_load(table_id, next_record, &source, 1, nullptr) != SUCCESS,
+           "a key out of order");
+    expect(!table_of(table_id).find(0, nullptr).has_value(),
+           "a table left empty");
+    expect(used_pages(table_id) == used_before, "pages freed");
+
+    char value[] = "value";
+    expect(db_insert(table_id, 7, value) == SUCCESS, "insert");
+
+    source = { 100, 200 };
+    expect(db_bulk_load(table_id, next_record, &source, 1, nullptr) != SUCCESS,
+           "a table which is not empty");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int64_t num_records = (argc > 1) ? std::atoll(argv[1]) : 30000;
+
+    for (double fill_factor : { 1.0, 0.7, 0.01 })
+        run(num_records, fill_factor);
+
+    // a root leaf, and a last inner node with a single child
+    run(1, 1);
+    run(BPTree::LEAF_ORDER - 1, 1);
+    run((BPTree::LEAF_ORDER - 1) * (BPTree::INTERNAL_ORDER + 1), 1);
+
+    run_refused();
+
+    return test_result();
+}
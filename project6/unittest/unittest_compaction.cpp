@@ -0,0 +1,310 @@
+// online compaction of a table emptied by deletes. lookups by another
+// thread and inserts and deletes between the batches see every record,
+// the leaves end up in key order, the file shrinks by the bytes reported,
+// and it is read and grown again after a reopen. the tree in the file is
+// whole as soon as it is cut.
+//
+// usage: unittest_compaction [keys] [batch pages]
+
+#include "bpt.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// one key out of this many is kept by the deletes
+constexpr int64_t KEEP_EVERY = 10;
+
+int64_t file_size()
+{
+    struct stat st;
+    return (stat(TABLE_NAME, &st) == 0) ? st.st_size : -1;
+}
+
+void check_records(int table_id, const std::set<int64_t>& keys,
+                   int64_t num_keys)
+{
+    for (int64_t key = 0; key < num_keys; ++key)
+    {
+        const auto record = table_of(table_id).find(key, nullptr);
+        if (keys.count(key) == 0)
+        {
+            expect(!record.has_value(), "a deleted key found");
+            continue;
+        }
+
+        expect(record.has_value() && value_of(key) == record->value,
+               "a record after compaction");
+    }
+}
+
+// ascending keys, then all but every KEEP_EVERY-th one deleted at random
+std::set<int64_t> build(int table_id, int64_t num_keys)
+{
+    std::vector<int64_t> deleted;
+    for (int64_t key = 0; key < num_keys; ++key)
+    {
+        insert(table_id, key);
+        if (key % KEEP_EVERY != 0)
+            deleted.push_back(key);
+    }
+
+    std::mt19937 gen(1);
+    std::shuffle(begin(deleted), end(deleted), gen);
+    for (int64_t key : deleted)
+        expect(db_delete(table_id, key) == SUCCESS, "delete");
+
+    std::set<int64_t> keys;
+    for (int64_t key = 0; key < num_keys; key += KEEP_EVERY)
+        keys.insert(key);
+
+    return keys;
+}
+
+void run(int64_t num_keys, int batch_pages)
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    std::set<int64_t> keys = build(table_id, num_keys);
+
+    const auto before = table_of(table_id).leaf_layout();
+    expect(shutdown_db() == SUCCESS, "shutdown");
+    const int64_t size_before = file_size();
+
+    unlink(LOG_PATH);
+    expect(open_db(), "reopen");
+    table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    // no batch runs while a transaction is active
+    const int trx_id = trx_begin();
+    const auto idle = table_of(table_id).compact(batch_pages);
+    expect(idle.has_value() && !idle->done && idle->merged_leaves == 0 &&
+               idle->moved_pages == 0,
+           "a batch during a transaction");
+    expect(trx_commit(trx_id) == trx_id, "commit");
+
+    // the kept keys of the first half are looked up all along
+    std::atomic<bool> stop{ false };
+    std::thread reader([&] {
+        std::mt19937 gen(2);
+        while (!stop)
+        {
+            const int64_t key = (gen() % (num_keys / 2 / KEEP_EVERY)) *
+                                KEEP_EVERY;
+            const auto record = table_of(table_id).find(key, nullptr);
+            expect(record.has_value() && value_of(key) == record->value,
+                   "a lookup during compaction");
+        }
+    });
+
+    // the second half changes between the batches
+    std::mt19937 gen(3);
+    CompactionStats total;
+    int num_batches = 0;
+    while (!total.done)
+    {
+        const auto stats = table_of(table_id).compact(batch_pages);
+        expect(stats.has_value(), "compact");
+        if (!stats.has_value())
+            break;
+
+        total += stats.value();
+        ++num_batches;
+
+        const int64_t key =
+            num_keys / 2 + gen() % (num_keys / 2 / KEEP_EVERY) * KEEP_EVERY;
+        if (keys.count(key) != 0)
+        {
+            expect(db_delete(table_id, key) == SUCCESS, "delete");
+            keys.erase(key);
+        }
+        else
+        {
+            insert(table_id, key);
+            keys.insert(key);
+        }
+    }
+
+    stop = true;
+    reader.join();
+
+    expect(num_batches > 1, "compaction in batches");
+    expect(total.merged_leaves > 0, "leaves merged");
+    expect(total.truncated_pages > 0, "pages truncated");
+
+    check_records(table_id, keys, num_keys);
+
+    const auto after = table_of(table_id).leaf_layout();
+    expect(before.has_value() && after.has_value() &&
+               after->num_leaves < before->num_leaves / 2,
+           "fewer leaves");
+    expect(after.has_value() && after->fragmentation() < 0.1,
+           "leaves in key order");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+
+    const int64_t size_after = file_size();
+    expect(size_before - size_after ==
+               static_cast<int64_t>(total.reclaimed_bytes()),
+           "reclaimed bytes");
+
+    // what was compacted is read again, and the file grows past its end
+    unlink(LOG_PATH);
+    expect(open_db(), "reopen");
+    table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    check_records(table_id, keys, num_keys);
+    for (int64_t key = num_keys; key < num_keys * 2; ++key)
+    {
+        insert(table_id, key);
+        keys.insert(key);
+    }
+    check_records(table_id, keys, num_keys * 2);
+
+    // a compacted table is compacted again without moving anything
+    int done = 0;
+    int64_t reclaimed = -1;
+    while (!done)
+        expect(db_compact(table_id, batch_pages, &done, &reclaimed) == SUCCESS,
+               "db_compact");
+
+    check_records(table_id, keys, num_keys * 2);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+// the keys of the leaves of the tree in the file, read around the pool
+std::vector<int64_t> keys_in_file()
+{
+    std::vector<int64_t> keys;
+
+    const int fd = open(TABLE_NAME, O_RDONLY);
+    if (fd == -1)
+        return keys;
+
+    const uint64_t num_pages = file_size() / PAGE_SIZE;
+    const auto read_page = [&](pagenum_t pagenum, page_t& page) {
+        return pagenum < num_pages &&
+               pread(fd, &page, PAGE_SIZE, pagenum * PAGE_SIZE) == PAGE_SIZE;
+    };
+
+    page_t page;
+    bool whole = read_page(NULL_PAGE_NUM, page);
+    pagenum_t pagenum = page.file.root_page_number;
+
+    // down to the leftmost leaf, then along the siblings
+    for (uint64_t i = 0; whole && pagenum != NULL_PAGE_NUM && i < num_pages;
+         ++i)
+    {
+        whole = read_page(pagenum, page);
+        if (!whole)
+            break;
+
+        if (!page.node.header.is_leaf)
+        {
+            pagenum = page.node.header.page_a_number;
+            continue;
+        }
+
+        for (int j = 0; j < page.node.header.num_keys; ++j)
+            keys.push_back(page.node.data[j].key);
+        pagenum = page.node.header.page_a_number;
+    }
+
+    close(fd);
+
+    expect(whole, "the tree in the file");
+    return keys;
+}
+
+// compacted without any write after, the file holds the moved nodes
+void run_durable(int64_t num_keys, int batch_pages)
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    const std::set<int64_t> keys = build(table_id, num_keys);
+
+    CompactionStats total;
+    while (!total.done)
+    {
+        const auto stats = table_of(table_id).compact(batch_pages);
+        expect(stats.has_value(), "compact");
+        if (!stats.has_value())
+            break;
+
+        total += stats.value();
+    }
+
+    expect(total.moved_pages > 0 && total.truncated_pages > 0,
+           "nodes moved and pages truncated");
+
+    const std::vector<int64_t> in_file = keys_in_file();
+    expect(std::vector<int64_t>(begin(keys), end(keys)) == in_file,
+           "the records in the file");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+// every record deleted, the file is cut down to the header page
+void run_empty(int batch_pages)
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    for (int64_t key = 0; key < 5000; ++key)
+        insert(table_id, key);
+    for (int64_t key = 0; key < 5000; ++key)
+        expect(db_delete(table_id, key) == SUCCESS, "delete");
+
+    int done = 0;
+    while (!done)
+        expect(db_compact(table_id, batch_pages, &done, nullptr) == SUCCESS,
+               "db_compact");
+
+    char value[PAGE_DATA_VALUE_SIZE];
+    expect(db_find(table_id, 0, value, 0) != SUCCESS, "an empty table");
+    insert(table_id, 0);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+    expect(file_size() <= static_cast<int64_t>(
+                              (1 + File::MIN_EXTENT_PAGES) * PAGE_SIZE),
+           "an emptied file");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int64_t num_keys = (argc > 1) ? std::atoll(argv[1]) : 50000;
+    const int batch_pages = (argc > 2) ? std::atoi(argv[2]) : 16;
+
+    run(num_keys, batch_pages);
+    run_durable(num_keys, batch_pages);
+    run_empty(batch_pages);
+
+    return test_result();
+}
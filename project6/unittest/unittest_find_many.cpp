@@ -0,0 +1,264 @@
+// batched lookups sharing one descent. random batches, with missing and
+// repeated keys in any order, see the records of a std::set, keys in one
+// leaf are resolved with the pins of a single lookup, a batch sees every
+// key kept while another thread splits and merges leaves, waits for the
+// lock of a record being updated, and reads read only tables.
+//
+// usage: unittest_find_many [keys] [batches]
+
+#include "buffer.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// db_find_many() in a transaction, checked against the keys
+void check_batch(int table_id, const std::vector<int64_t>& batch,
+                 const std::set<int64_t>& keys)
+{
+    std::vector<std::vector<char>> values(
+        batch.size(), std::vector<char>(PAGE_DATA_VALUE_SIZE));
+    std::vector<char*> ret_vals;
+    for (auto& value : values)
+        ret_vals.push_back(value.data());
+    std::vector<int> found(batch.size(), -1);
+
+    const int trx_id = trx_begin();
+    expect(db_find_many(table_id, batch.data(), batch.size(), ret_vals.data(),
+                        found.data(), trx_id) == SUCCESS,
+           "db_find_many");
+    expect(trx_commit(trx_id) == trx_id, "commit");
+
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        const bool kept = keys.count(batch[i]) > 0;
+        expect(found[i] == kept, "a key found or not");
+        if (kept)
+            expect(value_of(batch[i]) == ret_vals[i], "a value found");
+    }
+}
+
+uint64_t pins()
+{
+    const BufferStats stats = BufMgr().stats();
+    return stats.hits + stats.misses;
+}
+
+void run_batches(int64_t num_keys, int num_batches)
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    std::set<int64_t> keys;
+    check_batch(table_id, { 1, 2, 3 }, keys);
+
+    std::mt19937 gen(1);
+    for (int64_t i = 0; i < num_keys; ++i)
+    {
+        const int64_t key = gen() % (num_keys * 2);
+        if (keys.insert(key).second)
+            insert(table_id, key);
+    }
+
+    for (int64_t key = 0; key < num_keys * 2; key += 7)
+    {
+        if (keys.erase(key) > 0)
+            expect(db_delete(table_id, key) == SUCCESS, "delete");
+    }
+
+    for (int i = 0; i < num_batches; ++i)
+    {
+        std::vector<int64_t> batch(gen() % 600);
+        for (auto& key : batch)
+            key = static_cast<int64_t>(gen() % (num_keys * 2 + 100)) - 50;
+
+        // a key asked for twice
+        if (!batch.empty())
+            batch.push_back(batch.front());
+
+        check_batch(table_id, batch, keys);
+    }
+
+    // the whole table at once
+    check_batch(table_id, std::vector<int64_t>(keys.rbegin(), keys.rend()),
+                keys);
+
+    // keys in one leaf take the pins of one key
+    Table& table = table_of(table_id);
+    std::vector<std::optional<page_data_t>> records;
+
+    const int64_t first = *keys.begin();
+    BufMgr().reset_stats();
+    expect(table.find_many({ first }, records, nullptr), "find_many");
+    const uint64_t single = pins();
+
+    std::vector<int64_t> leaf_keys(keys.begin(), std::next(keys.begin(), 10));
+    BufMgr().reset_stats();
+    expect(table.find_many(leaf_keys, records, nullptr), "find_many");
+    expect(pins() == single, "one pin per node");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+// the even keys are kept, the odd ones inserted and deleted by a writer
+void run_concurrent(int64_t num_keys)
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+    Table& table = table_of(table_id);
+
+    for (int64_t key = 0; key < num_keys; key += 2)
+        insert(table_id, key);
+
+    std::atomic<bool> stop{ false };
+    std::thread writer([&] {
+        std::mt19937 gen(2);
+        std::set<int64_t> odd;
+        while (!stop)
+        {
+            // runs of keys, so that leaves are split and merged
+            const int64_t first = (gen() % (num_keys / 2)) * 2 + 1;
+            const bool insert_run = odd.count(first) == 0;
+            for (int64_t key = first; key < first + 200 && key < num_keys;
+                 key += 2)
+            {
+                if (insert_run && odd.insert(key).second)
+                    insert(table_id, key);
+                if (!insert_run && odd.erase(key) > 0)
+                    expect(db_delete(table_id, key) == SUCCESS, "delete");
+            }
+        }
+    });
+
+    std::mt19937 gen(3);
+    for (int i = 0; i < 200; ++i)
+    {
+        std::vector<int64_t> batch(200);
+        for (auto& key : batch)
+            key = (gen() % (num_keys / 2)) * 2;
+
+        std::vector<std::optional<page_data_t>> records;
+        expect(table.find_many(batch, records, nullptr), "find_many");
+
+        for (std::size_t j = 0; j < batch.size(); ++j)
+        {
+            expect(records[j].has_value() && records[j]->key == batch[j],
+                   "every key kept");
+        }
+    }
+
+    stop = true;
+    writer.join();
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+void run_locked()
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    for (int64_t key = 0; key < 100; ++key)
+        insert(table_id, key);
+
+    const int writer = trx_begin();
+    char updated[] = "updated";
+    expect(db_update(table_id, 50, updated, writer) == SUCCESS, "update");
+
+    std::atomic<bool> read_updated{ false };
+    std::thread reader([&] {
+        const std::vector<int64_t> batch{ 90, 50, 10, 49, 51 };
+        char values[5][PAGE_DATA_VALUE_SIZE];
+        char* ret_vals[5] = { values[0], values[1], values[2], values[3],
+                              values[4] };
+        int found[5];
+
+        const int trx_id = trx_begin();
+        expect(db_find_many(table_id, batch.data(), batch.size(), ret_vals,
+                            found, trx_id) == SUCCESS,
+               "db_find_many");
+        expect(trx_commit(trx_id) == trx_id, "commit");
+
+        for (int i = 0; i < 5; ++i)
+        {
+            expect(found[i], "a key found after the wait");
+            if (batch[i] != 50)
+                expect(value_of(batch[i]) == values[i], "a value found");
+        }
+
+        read_updated = std::string(values[1]) == updated;
+    });
+
+    // the lookup waits on the record until the update is committed
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    expect(!read_updated, "a record read before the commit");
+    expect(trx_commit(writer) == writer, "commit");
+
+    reader.join();
+    expect(read_updated, "a record read after the commit");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+void run_read_only(int64_t num_keys)
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    std::set<int64_t> keys;
+    for (int64_t key = 0; key < num_keys; key += 3)
+    {
+        insert(table_id, key);
+        keys.insert(key);
+    }
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+
+    unlink(LOG_PATH);
+    expect(open_db(), "reopen");
+    table_id = open_table_read_only(const_cast<char*>(TABLE_NAME));
+    expect(table_id > 0, "open read only");
+
+    std::vector<int64_t> batch;
+    for (int64_t key = num_keys; key >= -3; key -= 5)
+        batch.push_back(key);
+    check_batch(table_id, batch, keys);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int64_t num_keys = (argc > 1) ? std::atoll(argv[1]) : 20000;
+    const int num_batches = (argc > 2) ? std::atoi(argv[2]) : 200;
+
+    run_batches(num_keys, num_batches);
+    run_concurrent(num_keys);
+    run_locked();
+    run_read_only(num_keys);
+
+    return test_result();
+}
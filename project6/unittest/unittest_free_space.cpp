@@ -0,0 +1,418 @@
+// checks FreeSpaceMap against a plain vector of flags under random
+// allocations and frees, and its placement of pages, then the free space
+// of table files: past the bits of the header page, across a reopen, and
+// converted from a free list of an older file, also one whose nodes are
+// where the bitmap pages go, and one whose conversion was cut off.
+//
+// usage: unittest_free_space [operations]
+
+#include "buffer.h"
+#include "common.h"
+#include "dbapi.h"
+#include "free_space.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr int NUM_BUF = 64;
+
+void run_map(int num_operations, unsigned seed)
+{
+    FreeSpaceMap map;
+    std::vector<bool> expected;
+
+    std::mt19937 gen(seed);
+
+    for (int i = 0; i < num_operations; ++i)
+    {
+        switch (gen() % 8)
+        {
+            case 0: {
+                // grow, the new pages are free
+                const uint64_t old_size = map.size();
+                const uint64_t new_size = old_size + gen() % 100;
+                map.resize(new_size);
+                map.set_free(old_size, new_size - old_size, true);
+                expected.resize(new_size, true);
+                break;
+            }
+
+            case 1: {
+                // 0 is no hint
+                const pagenum_t hint =
+                    expected.size() < 2 ? 0 : 1 + gen() % (expected.size() - 1);
+                const uint64_t count = 1 + gen() % 8;
+                const auto first = map.allocate_run(count, hint);
+                if (!first.has_value())
+                    break;
+
+                for (pagenum_t p = first.value(); p < first.value() + count;
+                     ++p)
+                {
+                    expect(p < expected.size() && expected[p],
+                           "a run of free pages");
+                    if (p < expected.size())
+                        expected[p] = false;
+                }
+                break;
+            }
+
+            case 2:
+            case 3: {
+                if (expected.size() < 2)
+                    break;
+
+                const pagenum_t hint = 1 + gen() % (expected.size() - 1);
+                const auto pagenum = map.allocate(hint);
+                if (!pagenum.has_value())
+                {
+                    expect(map.num_free() == 0, "allocate with free pages");
+                    break;
+                }
+
+                // the first free page at or after the hint, wrapping around
+                pagenum_t first = hint;
+                while (!expected[first])
+                    first = (first + 1) % expected.size();
+
+                expect(pagenum.value() == first, "allocate near the hint");
+                expected[pagenum.value()] = false;
+                break;
+            }
+
+            default: {
+                if (expected.empty())
+                    break;
+
+                const pagenum_t pagenum = gen() % expected.size();
+                map.set_free(pagenum, true);
+                expected[pagenum] = true;
+                break;
+            }
+        }
+
+    }
+
+    uint64_t num_free = 0;
+    for (pagenum_t p = 0; p < expected.size(); ++p)
+    {
+        expect(map.is_free(p) == expected[p], "free bits");
+        num_free += expected[p];
+    }
+
+    expect(map.num_free() == num_free, "number of free pages");
+}
+
+void run_near()
+{
+    FreeSpaceMap map;
+    map.resize(1000);
+    map.set_free(100, true);
+    map.set_free(180, true);
+    map.set_free(300, true);
+    map.set_free(500, true);
+
+    // after the page first, then the closest before it, within the distance
+    expect(map.allocate_near(150, 64) == std::optional<pagenum_t>(180),
+           "near after");
+    expect(map.allocate_near(150, 64) == std::optional<pagenum_t>(100),
+           "near before");
+    expect(!map.allocate_near(400, 64).has_value(), "nothing near");
+
+    // the pages taken one after another do not follow the near ones
+    expect(map.allocate() == std::optional<pagenum_t>(300), "allocate");
+    expect(map.allocate() == std::optional<pagenum_t>(500), "allocate next");
+}
+
+void run_in()
+{
+    FreeSpaceMap map;
+    map.resize(300);
+    map.set_free(1, 299, true);
+    map.set_free(70, false);
+    map.set_free(200, false);
+
+    // the last page in use, a word at a time backwards
+    expect(map.last_used(300) == 200, "last used");
+    expect(map.last_used(200) == 70, "last used before");
+    expect(map.last_used(70) == 0, "the header page used");
+
+    // the first free page in the range, the cursor is not moved
+    expect(map.allocate_in(70, 200) == std::optional<pagenum_t>(71),
+           "allocate in");
+    map.set_free(72, 128, false);
+    expect(!map.allocate_in(70, 200).has_value(), "nothing in");
+    expect(map.allocate() == std::optional<pagenum_t>(1), "allocate");
+}
+
+// enough pages to need the bitmap page after the header page's bits
+void run_large_file()
+{
+    remove_db();
+
+    const uint64_t num_pages = File::HEADER_FREE_BITS + 1000;
+
+    expect(open_db(NUM_BUF), "init");
+    int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    std::vector<pagenum_t> pages;
+    for (uint64_t i = 0; i < num_pages; ++i)
+    {
+        pagenum_t pagenum;
+        expect(BufMgr().create_page(table_of(table_id), true, pagenum),
+               "create");
+        pages.push_back(pagenum);
+    }
+
+    const std::set<pagenum_t> unique(begin(pages), end(pages));
+    expect(unique.size() == pages.size(), "a page allocated twice");
+    expect(unique.count(NULL_PAGE_NUM) == 0 &&
+               unique.count(File::HEADER_FREE_BITS) == 0,
+           "the header or the bitmap page allocated");
+    expect(pages[0] == 1 && pages[100] == 101, "consecutive pages");
+
+    // one page freed in the header page's range, two in the bitmap page's
+    const std::vector<pagenum_t> freed{ 10, File::HEADER_FREE_BITS + 5,
+                                        File::HEADER_FREE_BITS + 700 };
+    for (pagenum_t pagenum : freed)
+        expect(BufMgr().free_page(table_of(table_id), pagenum), "free");
+
+    const uint64_t num_free =
+        table_of(table_id).file()->free_space().num_free();
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+    unlink(LOG_PATH);
+
+    expect(open_db(NUM_BUF), "reopen");
+    table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    const FreeSpaceMap& free_space = table_of(table_id).file()->free_space();
+    expect(free_space.num_free() == num_free, "free pages after reopen");
+    for (pagenum_t pagenum : freed)
+        expect(free_space.is_free(pagenum), "a freed page after reopen");
+
+    // the freed pages are taken before the file grows
+    for (pagenum_t pagenum : freed)
+    {
+        pagenum_t reused;
+        expect(BufMgr().create_page(table_of(table_id), true, reused) &&
+                   reused == pagenum,
+               "reuse a freed page");
+    }
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+// a file of the free list format, with pages 3 and 1 on the list
+void run_conversion()
+{
+    unlink("DATA2");
+    unlink(LOG_PATH);
+
+    std::vector<page_t> pages(5);
+    for (auto& page : pages)
+        memset(&page, 0, PAGE_SIZE);
+
+    pages[0].file.num_pages = 5;
+    pages[0].file.free_page_number = 3;
+    pages[0].file.free_space_format =
+        static_cast<uint64_t>(FreeSpaceFormat::FREE_LIST);
+    pages[3].node.free_header.next_free_page_number = 1;
+
+    const int fd = open("DATA2", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    expect(fd != -1 && write(fd, pages.data(), 5 * PAGE_SIZE) ==
+                           static_cast<ssize_t>(5 * PAGE_SIZE),
+           "write an older file");
+    close(fd);
+
+    expect(open_db(NUM_BUF), "init");
+    const int table_id = open_table(const_cast<char*>("DATA2"));
+    expect(table_id > 0, "open an older file");
+
+    const std::vector<pagenum_t> expected{ 1, 3, 5 };
+    for (pagenum_t pagenum : expected)
+    {
+        pagenum_t allocated;
+        expect(BufMgr().create_page(table_of(table_id), true, allocated) &&
+                   allocated == pagenum,
+               "allocate from a converted free list");
+    }
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+// a tree of the free list format, whose root has a leaf before and one at
+// the first bitmap page. pages 3 and 4 are on the list, the ones between
+// are in no use.
+std::vector<std::pair<pagenum_t, page_t>> older_tree(uint64_t num_pages)
+{
+    const pagenum_t moved = File::HEADER_FREE_BITS;
+
+    std::vector<std::pair<pagenum_t, page_t>> pages(5);
+    for (auto& pr : pages)
+        memset(&pr.second, 0, PAGE_SIZE);
+
+    page_t& header = pages[0].second;
+    header.file.num_pages = num_pages;
+    header.file.root_page_number = 1;
+    header.file.free_page_number = 3;
+    header.file.free_space_format =
+        static_cast<uint64_t>(FreeSpaceFormat::FREE_LIST);
+
+    pages[1].first = 1;
+    page_t& root = pages[1].second;
+    root.node.header.num_keys = 1;
+    root.node.header.page_a_number = 2;
+    root.node.branch[0] = { 100, moved };
+
+    pages[2].first = 2;
+    pages[3].first = moved;
+    for (int i = 0; i < 2; ++i)
+    {
+        page_header_t& leaf = pages[2 + i].second.node.header;
+        leaf.parent_page_number = 1;
+        leaf.is_leaf = 1;
+        leaf.num_keys = 10;
+        leaf.page_a_number = (i == 0) ? moved : NULL_PAGE_NUM;
+
+        for (int j = 0; j < 10; ++j)
+        {
+            page_data_t& data = pages[2 + i].second.node.data[j];
+            data.key = i * 100 + j;
+            snprintf(data.value, sizeof(data.value), "old%d", i * 100 + j);
+        }
+    }
+
+    pages[4].first = 3;
+    pages[4].second.node.free_header.next_free_page_number = 4;
+
+    return pages;
+}
+
+bool write_file(const char* filename, uint64_t num_pages,
+                const std::vector<std::pair<pagenum_t, page_t>>& pages)
+{
+    const int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        return false;
+
+    bool success = ftruncate(fd, num_pages * PAGE_SIZE) == 0;
+    for (const auto& pr : pages)
+    {
+        success = success && pwrite(fd, &pr.second, PAGE_SIZE,
+                                    pr.first * PAGE_SIZE) == PAGE_SIZE;
+    }
+
+    close(fd);
+    return success;
+}
+
+// the keys of the older tree and the ones inserted from 200, without the
+// first ones of the leaf moved
+void check_older_tree(int table_id, int64_t num_keys, int64_t num_deleted)
+{
+    Table& table = table_of(table_id);
+    for (int64_t key = 0; key < num_keys; ++key)
+    {
+        const bool old_key = key < 200 && key % 100 < 10;
+        const bool deleted = key >= 100 && key < 100 + num_deleted;
+        const std::string value =
+            (old_key ? "old" : "new") + std::to_string(key);
+
+        const auto record = table.find(key, nullptr);
+        expect(record.has_value() == ((old_key || key >= 200) && !deleted) &&
+                   (!record.has_value() || value == record->value),
+               "a record of a converted tree");
+    }
+}
+
+void run_moved_conversion(bool cut_off)
+{
+    unlink("DATA2");
+    unlink(LOG_PATH);
+
+    const uint64_t num_pages = File::HEADER_FREE_BITS + 10;
+    auto pages = older_tree(num_pages);
+
+    // the leaf is copied and the header written, then it stopped while
+    // the left leaf was pointed at the copy
+    if (cut_off)
+    {
+        page_t& header = pages[0].second;
+        header.file.num_pages = num_pages + 1;
+        header.file.free_space_format =
+            static_cast<uint64_t>(FreeSpaceFormat::CONVERTING);
+        header.file.free_bits[0] = num_pages;
+
+        pages.emplace_back(num_pages, pages[3].second);
+        pages[2].second.node.header.page_a_number = num_pages;
+        memset(&pages[3].second, 0xff, PAGE_SIZE);
+    }
+
+    expect(write_file("DATA2", num_pages, pages), "write an older file");
+
+    expect(open_db(NUM_BUF), "init");
+    int table_id = open_table(const_cast<char*>("DATA2"));
+    expect(table_id > 0, "open an older file");
+
+    const FreeSpaceMap& free_space = table_of(table_id).file()->free_space();
+    expect(free_space.size() == num_pages + 1, "a page for the copy");
+    expect(!free_space.is_free(File::HEADER_FREE_BITS) &&
+               !free_space.is_free(num_pages),
+           "the bitmap page and the copy in use");
+    expect(free_space.is_free(3) && free_space.is_free(4) &&
+               free_space.is_free(5),
+           "the free pages");
+    check_older_tree(table_id, 200, 0);
+
+    // the parents of the moved leaf and of the split ones are right
+    char value[PAGE_DATA_VALUE_SIZE];
+    for (int64_t key = 200; key < 2000; ++key)
+    {
+        snprintf(value, sizeof(value), "new%ld", key);
+        expect(db_insert(table_id, key, value) == SUCCESS, "insert");
+    }
+    for (int64_t key = 0; key < 5; ++key)
+        expect(db_delete(table_id, 100 + key) == SUCCESS, "delete");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+    unlink(LOG_PATH);
+
+    expect(open_db(NUM_BUF), "reopen");
+    table_id = open_table(const_cast<char*>("DATA2"));
+    check_older_tree(table_id, 2000, 5);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_operations = (argc > 1) ? std::atoi(argv[1]) : 20000;
+
+    for (unsigned seed = 1; seed <= 4; ++seed)
+        run_map(num_operations, seed);
+    run_near();
+    run_in();
+
+    run_large_file();
+    run_conversion();
+    run_moved_conversion(false);
+    run_moved_conversion(true);
+
+    unlink("DATA2");
+
+    return test_result();
+}
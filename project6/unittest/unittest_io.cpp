@@ -0,0 +1,98 @@
+// the table files through every i/o backend. a small pool makes the
+// concurrent readers miss, so that many reads are in flight at once, and
+// a reopen reads back what the batched and single writes left.
+//
+// usage: unittest_io [keys] [threads]
+
+#include "buffer.h"
+#include "common.h"
+#include "dbapi.h"
+#include "io.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr int NUM_BUF = 128;
+
+DBConfig config_of(IOBackendType backend)
+{
+    DBConfig config;
+    config.io_backend = backend;
+    config.io_queue_depth = 16;
+    return config;
+}
+
+void find_all(int table_id, int num_keys, int num_threads)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([=] {
+            Table& table = table_of(table_id);
+
+            // every thread starts in another part of the table
+            for (int i = 0; i < num_keys; ++i)
+            {
+                const int64_t key = (i + t * num_keys / num_threads) % num_keys;
+
+                const auto record = table.find(key, nullptr);
+                expect(record.has_value() &&
+                           value_of(key) == record.value().value,
+                       "find");
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void run(IOBackendType backend, int num_keys, int num_threads)
+{
+    remove_db();
+
+    expect(open_db(NUM_BUF, config_of(backend)), "init");
+
+    int table_id = open_table(const_cast<char*>(TABLE_NAME));
+    for (int64_t key = 0; key < num_keys; ++key)
+        insert(table_id, key);
+
+    find_all(table_id, num_keys, num_threads);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+    unlink(LOG_PATH);
+
+    expect(open_db(NUM_BUF, config_of(backend)), "reopen");
+
+    table_id = open_table(const_cast<char*>(TABLE_NAME));
+    find_all(table_id, num_keys, num_threads);
+
+    expect(shutdown_db() == SUCCESS, "shutdown after reopen");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_keys = (argc > 1) ? std::atoi(argv[1]) : 5000;
+    const int num_threads = (argc > 2) ? std::atoi(argv[2]) : 8;
+
+    for (IOBackendType backend :
+         { IOBackendType::PREAD, IOBackendType::THREAD_POOL,
+           IOBackendType::IO_URING })
+    {
+        run(backend, num_keys, num_threads);
+    }
+
+    return test_result();
+}
@@ -0,0 +1,189 @@
+// the key search kernels. every kernel the cpu supports finds the same
+// entries as std::lower_bound and std::upper_bound in nodes of every size,
+// with repeated and extreme keys, and the same child as a linear search, in
+// pages filled up to their end. a tree searched without the vector kernels
+// still finds its records.
+//
+// usage: unittest_key_search [rounds]
+
+#include "bpt.h"
+#include "common.h"
+#include "dbapi.h"
+#include "key_search.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr int64_t MIN = std::numeric_limits<int64_t>::min();
+constexpr int64_t MAX = std::numeric_limits<int64_t>::max();
+
+// sorted keys, close enough to each other to repeat
+std::vector<int64_t> random_keys(std::mt19937_64& gen, int size)
+{
+    std::vector<int64_t> keys(size);
+    const int64_t range = (gen() % 2 == 0) ? size * 2 : MAX;
+    for (auto& key : keys)
+        key = static_cast<int64_t>(gen() % range) - range / 2;
+
+    if (size > 0 && gen() % 4 == 0)
+        keys.front() = MIN;
+    if (size > 1 && gen() % 4 == 0)
+        keys.back() = MAX;
+
+    std::sort(begin(keys), end(keys));
+    return keys;
+}
+
+std::vector<int64_t> probes(const std::vector<int64_t>& keys)
+{
+    std::vector<int64_t> result{ MIN, MAX, 0 };
+    for (int64_t key : keys)
+    {
+        result.push_back(key);
+        if (key != MIN)
+            result.push_back(key - 1);
+        if (key != MAX)
+            result.push_back(key + 1);
+    }
+
+    return result;
+}
+
+template <typename T>
+int expected_lower(const T* entries, int size, int64_t key)
+{
+    return std::lower_bound(entries, entries + size, key,
+                            [](const T& lhs, int64_t rhs) {
+                                return lhs.key < rhs;
+                            }) -
+           entries;
+}
+
+int expected_upper(const page_branch_t* branches, int size, int64_t key)
+{
+    return std::upper_bound(branches, branches + size, key,
+                            [](int64_t lhs, const page_branch_t& rhs) {
+                                return lhs < rhs.key;
+                            }) -
+           branches;
+}
+
+void run_kernel(SearchKernel kernel, int rounds)
+{
+    expect(key_search::set_kernel(kernel), "a supported kernel");
+    expect(key_search::kernel() == kernel, "the kernel set");
+
+    std::mt19937_64 gen(static_cast<int>(kernel) + 1);
+    auto page = std::make_unique<page_t>();
+
+    // the entries end with the page, so that no kernel reads past them
+    for (int round = 0; round < rounds; ++round)
+    {
+        const int leaf_size = round % BPTree::LEAF_ORDER;
+        const auto leaf_keys = random_keys(gen, leaf_size);
+        page_data_t* data =
+            page->node.data + (BPTree::LEAF_ORDER - 1 - leaf_size);
+        for (int i = 0; i < leaf_size; ++i)
+            data[i].key = leaf_keys[i];
+
+        for (int64_t key : probes(leaf_keys))
+        {
+            expect(key_search::lower_bound(data, leaf_size, key) ==
+                       expected_lower(data, leaf_size, key),
+                   "a lower bound in a leaf");
+        }
+
+        const int size = round % BPTree::INTERNAL_ORDER;
+        const auto keys = random_keys(gen, size);
+        page_branch_t* branches =
+            page->node.branch + (BPTree::INTERNAL_ORDER - 1 - size);
+        for (int i = 0; i < size; ++i)
+        {
+            branches[i].key = keys[i];
+            branches[i].child_page_number = gen() % (size * 2 + 1);
+        }
+
+        for (int64_t key : probes(keys))
+        {
+            expect(key_search::lower_bound(branches, size, key) ==
+                       expected_lower(branches, size, key),
+                   "a lower bound in an inner node");
+            expect(key_search::upper_bound(branches, size, key) ==
+                       expected_upper(branches, size, key),
+                   "an upper bound in an inner node");
+        }
+
+        for (int i = 0; i < size * 2 + 1; ++i)
+        {
+            const pagenum_t child = i;
+            const int expected =
+                std::find_if(branches, branches + size,
+                             [&](const page_branch_t& branch) {
+                                 return branch.child_page_number == child;
+                             }) -
+                branches;
+
+            expect(key_search::find_child(branches, size, child) == expected,
+                   "a child");
+        }
+    }
+}
+
+void run_tree()
+{
+    remove_db();
+
+    DBConfig config;
+    config.simd_search = false;
+    expect(open_db(TEST_NUM_BUF, config), "init");
+    expect(key_search::kernel() == SearchKernel::SCALAR, "a scalar search");
+
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    char value[] = "value";
+    for (int64_t key = 0; key < 20000; key += 2)
+        expect(db_insert(table_id, key, value) == SUCCESS, "insert");
+
+    Table& table = table_of(table_id);
+    for (int64_t key = -1; key < 20001; ++key)
+    {
+        expect(table.find(key, nullptr).has_value() ==
+                   (key % 2 == 0 && key < 20000),
+               "a key found or not");
+    }
+
+    for (int64_t key = 0; key < 20000; key += 4)
+        expect(db_delete(table_id, key) == SUCCESS, "delete");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int rounds = (argc > 1) ? std::atoi(argv[1]) : 2000;
+
+    const SearchKernel best = key_search::detect();
+    for (SearchKernel kernel :
+         { SearchKernel::SCALAR, SearchKernel::SSE42, SearchKernel::AVX2 })
+    {
+        if (static_cast<int>(kernel) <= static_cast<int>(best))
+            run_kernel(kernel, rounds);
+        else
+            expect(!key_search::set_kernel(kernel), "an unsupported kernel");
+    }
+
+    run_tree();
+
+    return test_result();
+}
@@ -0,0 +1,96 @@
+// checks PageTable against std::unordered_map under random inserts and
+// erases, with the table kept as full as a buffer partition keeps it.
+//
+// usage: unittest_page_table [operations]
+
+#include "page_table.h"
+#include "test_util.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+BufferBlock* fake_block(std::size_t i)
+{
+    // never dereferenced
+    return reinterpret_cast<BufferBlock*>((i + 1) * 64);
+}
+
+void run(std::size_t max_entries, int num_operations, unsigned seed)
+{
+    PageTable table(max_entries);
+    std::unordered_map<table_page_t, BufferBlock*> expected;
+    std::vector<table_page_t> keys;
+
+    std::mt19937 gen(seed);
+
+    // a small key space, so that erased pages come back often
+    std::uniform_int_distribution<pagenum_t> pagenum(0, 4 * max_entries);
+    std::uniform_int_distribution<table_id_t> table_id(1, 3);
+
+    for (int i = 0; i < num_operations; ++i)
+    {
+        const bool full = keys.size() == max_entries;
+
+        if (!keys.empty() && (full || gen() % 2 == 0))
+        {
+            const std::size_t victim = gen() % keys.size();
+            const table_page_t tpid = keys[victim];
+
+            table.erase(tpid);
+            expected.erase(tpid);
+
+            keys[victim] = keys.back();
+            keys.pop_back();
+        }
+        else
+        {
+            const table_page_t tpid{ table_id(gen), pagenum(gen) };
+            if (expected.count(tpid) > 0)
+                continue;
+
+            table.insert(tpid, fake_block(i));
+            expected.emplace(tpid, fake_block(i));
+            keys.emplace_back(tpid);
+        }
+
+        expect(table.size() == expected.size(), "size");
+
+        // every mapped page is found, and a few unmapped ones are not
+        if (i % 64 == 0)
+        {
+            for (const auto& [tpid, block] : expected)
+                expect(table.find(tpid) == block, "find of a mapped page");
+
+            for (int j = 0; j < 16; ++j)
+            {
+                const table_page_t tpid{ table_id(gen), pagenum(gen) };
+                if (expected.count(tpid) == 0)
+                    expect(table.find(tpid) == nullptr,
+                           "find of an unmapped page");
+            }
+        }
+    }
+
+    // erasing an unmapped page is a no-op
+    table.erase({ 100, 0 });
+    expect(table.size() == expected.size(), "erase of an unmapped page");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_operations = (argc > 1) ? std::atoi(argv[1]) : 200000;
+
+    for (std::size_t max_entries : { 1, 7, 64, 1000 })
+    {
+        for (unsigned seed = 1; seed <= 3; ++seed)
+            run(max_entries, num_operations, seed);
+    }
+
+    return test_result();
+}
@@ -0,0 +1,151 @@
+// explicit prefetches and the sequential read-ahead of the buffer pool.
+// prefetched pages have to be served as hits with the right contents, and a
+// table has to close cleanly with prefetches still queued.
+//
+// usage: unittest_prefetch [keys]
+
+#include "buffer.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// smaller than the table, so that reads go to the file
+constexpr int NUM_BUF = 128;
+constexpr int NUM_PREFETCH = 32;
+
+// the prefetcher runs in the background
+bool wait_prefetched(uint64_t num_pages)
+{
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+    while (BufMgr().stats().prefetched < num_pages)
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return true;
+}
+
+bool build(int num_keys)
+{
+    CHECK_FAILURE(open_db(4 * NUM_BUF));
+
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+    CHECK_FAILURE(table_id > 0);
+
+    for (int64_t key = 0; key < num_keys; ++key)
+    {
+        CHECK_FAILURE(db_insert(table_id, key,
+                                const_cast<char*>(value_of(key).c_str())) ==
+                      SUCCESS);
+    }
+
+    return shutdown_db() == SUCCESS;
+}
+
+void check_explicit_prefetch(Table& table)
+{
+    BufMgr().reset_stats();
+
+    std::vector<pagenum_t> pagenums;
+    for (int i = 1; i <= NUM_PREFETCH; ++i)
+        pagenums.emplace_back(i);
+
+    BufMgr().prefetch(table, pagenums);
+    expect(wait_prefetched(NUM_PREFETCH), "explicit prefetch");
+
+    for (pagenum_t pagenum : pagenums)
+    {
+        std::optional<Page> page;
+        expect(BufMgr().get_page(table, pagenum, page, PageLatch::SHARED),
+               "get_page of a prefetched page");
+    }
+
+    const BufferStats stats = BufMgr().stats();
+    expect(stats.misses == 0, "prefetched pages are hits");
+    expect(stats.hits == NUM_PREFETCH, "hits of the prefetched pages");
+}
+
+void check_read_ahead(Table& table, int num_keys)
+{
+    BufMgr().reset_stats();
+
+    // finds in key order walk the leaves along the sibling chain
+    for (int64_t key = 0; key < num_keys; ++key)
+    {
+        const auto record = table.find(key, nullptr);
+        expect(record.has_value(), "find during read-ahead");
+
+        if (record.has_value())
+            expect(value_of(key) == record.value().value,
+                   "value during read-ahead");
+    }
+
+    expect(BufMgr().stats().prefetched > 0, "sequential read-ahead");
+}
+
+void check_close_with_queued_prefetches(Table& table)
+{
+    for (int round = 0; round < 4; ++round)
+        BufMgr().prefetch_siblings(table, 1, NUM_BUF);
+
+    std::vector<pagenum_t> pagenums;
+    for (int i = 1; i <= NUM_BUF; ++i)
+        pagenums.emplace_back(i);
+    BufMgr().prefetch(table, pagenums);
+
+    expect(close_table(table.id()) == SUCCESS, "close with prefetches");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_keys = (argc > 1) ? std::atoi(argv[1]) : 20000;
+
+    remove_db();
+
+    if (!build(num_keys))
+    {
+        std::fprintf(stderr, "failed to build the table\n");
+        return 1;
+    }
+    unlink(LOG_PATH);
+
+    DBConfig config;
+    config.cleaner_interval_ms = 0;
+    config.read_ahead_pages = 16;
+
+    if (!open_db(NUM_BUF, config))
+    {
+        std::fprintf(stderr, "failed to initialize\n");
+        return 1;
+    }
+
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+    Table& table = table_of(table_id);
+
+    check_explicit_prefetch(table);
+    check_read_ahead(table, num_keys);
+    check_close_with_queued_prefetches(table);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+
+    return test_result();
+}
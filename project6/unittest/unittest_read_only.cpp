@@ -0,0 +1,250 @@
+// read only tables served from the mapped file. concurrent lookups see
+// what the writer left, writes are refused, and a file open for writing is
+// not opened read only, whether the writer is this process or another one.
+// a broken file ends a lookup or a scan instead of leaving the map.
+//
+// usage: unittest_read_only [keys] [threads]
+
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr int NUM_BUF = 128;
+
+// keys are inserted with a gap, so that the odd ones are missing
+void build(int num_keys)
+{
+    remove_db();
+
+    expect(open_db(NUM_BUF), "init");
+
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+    for (int64_t key = 0; key < num_keys; key += 2)
+    {
+        expect(db_insert(table_id, key,
+                         const_cast<char*>(value_of(key).c_str())) == SUCCESS,
+               "insert");
+    }
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+void find_all(int table_id, int num_keys, int num_threads)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([=] {
+            Table& table = table_of(table_id);
+
+            for (int i = 0; i < num_keys; ++i)
+            {
+                const int64_t key = (i + t * num_keys / num_threads) % num_keys;
+
+                const auto record = table.find(key, nullptr);
+                if (key % 2 == 1)
+                {
+                    expect(!record.has_value(), "find a missing key");
+                    continue;
+                }
+
+                expect(record.has_value() &&
+                           value_of(key) == record.value().value,
+                       "find");
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void test_read_only(int num_keys, int num_threads)
+{
+    expect(open_db(NUM_BUF), "init");
+
+    const int table_id = open_table_read_only(const_cast<char*>(TABLE_NAME));
+    expect(table_id > 0, "open read only");
+
+    find_all(table_id, num_keys, num_threads);
+
+    // the transactional find goes through the same path
+    const int trx_id = trx_begin();
+    char value[PAGE_DATA_VALUE_SIZE];
+    expect(db_find(table_id, 0, value, trx_id) == SUCCESS &&
+               value_of(0) == value,
+           "db_find");
+    expect(trx_commit(trx_id) == trx_id, "commit");
+
+    char new_value[] = "new";
+    expect(db_insert(table_id, num_keys + 1, new_value) != SUCCESS,
+           "insert into a read only table");
+    expect(db_delete(table_id, 0) != SUCCESS, "delete from a read only table");
+
+    expect(open_table(const_cast<char*>(TABLE_NAME)) == -1,
+           "open for writing while open read only");
+    expect(open_table_read_only(const_cast<char*>(TABLE_NAME)) == table_id,
+           "open read only twice");
+
+    expect(close_table(table_id) == SUCCESS, "close");
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+void test_writer_open(int num_keys)
+{
+    expect(open_db(NUM_BUF), "init");
+
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+    expect(table_id > 0, "open for writing");
+    expect(open_table_read_only(const_cast<char*>(TABLE_NAME)) == -1,
+           "open read only while open for writing");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+
+    // another process holds the table open for writing until it is told
+    int opened[2], done[2];
+    expect(pipe(opened) == 0 && pipe(done) == 0, "pipe");
+
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        char c = 0;
+        const bool success =
+            open_db(NUM_BUF) && open_table(const_cast<char*>(TABLE_NAME)) > 0;
+
+        if (write(opened[1], &c, 1) != 1 || read(done[0], &c, 1) != 1)
+            _exit(1);
+
+        _exit(success && shutdown_db() == SUCCESS ? 0 : 1);
+    }
+
+    char c = 0;
+    expect(read(opened[0], &c, 1) == 1, "wait for the writer");
+
+    expect(open_db(NUM_BUF), "init");
+    expect(open_table_read_only(const_cast<char*>(TABLE_NAME)) == -1,
+           "open read only while another process writes");
+
+    expect(write(done[1], &c, 1) == 1, "stop the writer");
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "writer");
+
+    // the writer is gone
+    const int read_only_id =
+        open_table_read_only(const_cast<char*>(TABLE_NAME));
+    expect(read_only_id > 0, "open read only after the writer");
+    find_all(read_only_id, num_keys, 1);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+
+    for (int fd : { opened[0], opened[1], done[0], done[1] })
+        close(fd);
+}
+
+// the keys db_scan_*() returns from a read only table
+int num_scanned(int table_id, int64_t lo, int64_t hi)
+{
+    const int trx_id = trx_begin();
+    const int scan_id = db_scan_open(table_id, lo, hi, trx_id);
+    expect(scan_id != 0, "db_scan_open");
+
+    int num_keys = 0;
+    int64_t key;
+    char value[PAGE_DATA_VALUE_SIZE];
+    while (db_scan_next(scan_id, &key, value) == SUCCESS)
+        ++num_keys;
+
+    expect(db_scan_close(scan_id) == SUCCESS, "db_scan_close");
+    expect(trx_commit(trx_id) == trx_id, "commit");
+
+    return num_keys;
+}
+
+// the first leaf is made its own sibling, the second one holds far more
+// keys than a leaf can, and the last child of the root is the root
+void test_broken_pages()
+{
+    build(600);
+
+    const int fd = open(TABLE_NAME, O_RDWR);
+    expect(fd != -1, "open the file");
+
+    const auto read_page = [fd](pagenum_t pagenum, page_t& page) {
+        return pread(fd, &page, PAGE_SIZE, pagenum * PAGE_SIZE) == PAGE_SIZE;
+    };
+    const auto write_page = [fd](pagenum_t pagenum, const page_t& page) {
+        return pwrite(fd, &page, PAGE_SIZE, pagenum * PAGE_SIZE) == PAGE_SIZE;
+    };
+
+    page_t header, root, first, second;
+    expect(read_page(NULL_PAGE_NUM, header), "read the header");
+    const pagenum_t root_num = header.file.root_page_number;
+    expect(read_page(root_num, root) && !root.node.header.is_leaf &&
+               root.node.header.num_keys >= 2,
+           "an inner root");
+
+    const pagenum_t first_num = root.node.header.page_a_number;
+    expect(read_page(first_num, first), "read the first leaf");
+    first.node.header.page_a_number = first_num;
+    expect(write_page(first_num, first), "write the first leaf");
+
+    const pagenum_t second_num = root.node.branch[0].child_page_number;
+    expect(read_page(second_num, second), "read the second leaf");
+    const int64_t second_key = second.node.data[0].key;
+    second.node.header.num_keys = 1 << 24;
+    expect(write_page(second_num, second), "write the second leaf");
+
+    const int last = root.node.header.num_keys - 1;
+    const int64_t last_key = root.node.branch[last].key;
+    root.node.branch[last].child_page_number = root_num;
+    expect(write_page(root_num, root), "write the root");
+
+    close(fd);
+
+    expect(open_db(NUM_BUF), "init");
+    const int table_id = open_table_read_only(const_cast<char*>(TABLE_NAME));
+    expect(table_id > 0, "open a broken file read only");
+
+    Table& table = table_of(table_id);
+    expect(table.find(0, nullptr).has_value(), "find in an intact leaf");
+    expect(!table.find(second_key, nullptr).has_value(),
+           "find in a leaf with too many keys");
+    expect(!table.find(last_key, nullptr).has_value(),
+           "find under a child pointer back to the root");
+
+    // the first leaf once, then the scan ends on its way back to it
+    expect(num_scanned(table_id, 0, 600) == first.node.header.num_keys,
+           "scan along a sibling pointer back to the leaf");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_keys = (argc > 1) ? std::atoi(argv[1]) : 10000;
+    const int num_threads = (argc > 2) ? std::atoi(argv[2]) : 8;
+
+    build(num_keys);
+    test_read_only(num_keys, num_threads);
+    test_writer_open(num_keys);
+    test_broken_pages();
+
+    return test_result();
+}
@@ -0,0 +1,249 @@
+// drives each replacement policy on blocks outside a partition: the LRU
+// order, the second chance of CLOCK, the promotion of 2Q pages remembered
+// in A1out, then random operations that must never make a pinned or an
+// erased block the victim.
+//
+// usage: unittest_replacer [operations]
+
+#include "buffer.h"
+#include "replacer.h"
+#include "test_util.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+class ReplacerTestAccess final
+{
+ public:
+    static void hold(BufferBlock& block, pagenum_t pagenum)
+    {
+        block.table_id_ = 1;
+        block.pagenum_ = pagenum;
+    }
+
+    static void set_pins(BufferBlock& block, int pin_count)
+    {
+        block.pin_count_ = pin_count;
+    }
+
+    static int pin_count(const BufferBlock& block)
+    {
+        return block.pin_count();
+    }
+
+    static int queue(const BufferBlock& block)
+    {
+        return block.queue_;
+    }
+};
+
+namespace
+{
+using Access = ReplacerTestAccess;
+
+constexpr ReplacementPolicy POLICIES[] = { ReplacementPolicy::LRU,
+                                           ReplacementPolicy::CLOCK,
+                                           ReplacementPolicy::TWO_Q };
+
+void insert(Replacer& replacer, BufferBlock& block, pagenum_t pagenum)
+{
+    Access::hold(block, pagenum);
+    replacer.insert(&block);
+}
+
+// the victim leaves the replacer, as it does when a partition evicts it
+BufferBlock* evict(Replacer& replacer)
+{
+    BufferBlock* victim = replacer.victim();
+    if (victim != nullptr)
+        replacer.erase(victim);
+
+    return victim;
+}
+
+void run_lru()
+{
+    std::vector<BufferBlock> blocks(4);
+    auto replacer = Replacer::create(ReplacementPolicy::LRU, 4);
+    for (int i = 0; i < 4; ++i)
+        insert(*replacer, blocks[i], i + 1);
+
+    replacer->touch(&blocks[0]);
+    expect(evict(*replacer) == &blocks[1], "lru: the least recent first");
+
+    Access::set_pins(blocks[2], 1);
+    expect(evict(*replacer) == &blocks[3], "lru: a pinned block skipped");
+    expect(evict(*replacer) == &blocks[0], "lru: the touched block last");
+    expect(replacer->victim() == nullptr, "lru: only a pinned block left");
+}
+
+void run_clock()
+{
+    std::vector<BufferBlock> blocks(4);
+    auto replacer = Replacer::create(ReplacementPolicy::CLOCK, 4);
+    for (int i = 0; i < 4; ++i)
+        insert(*replacer, blocks[i], i + 1);
+
+    // the hand clears the bits of the touched blocks and passes them
+    replacer->touch(&blocks[0]);
+    replacer->touch(&blocks[1]);
+    expect(evict(*replacer) == &blocks[2], "clock: a second chance");
+
+    // placed behind the hand, the new block outlives one sweep
+    insert(*replacer, blocks[2], 5);
+    expect(evict(*replacer) == &blocks[3], "clock: the hand goes on");
+    expect(evict(*replacer) == &blocks[0], "clock: the chance used up");
+
+    Access::set_pins(blocks[1], 1);
+    expect(evict(*replacer) == &blocks[2], "clock: a pinned block skipped");
+    expect(replacer->victim() == nullptr, "clock: only a pinned block left");
+}
+
+void run_two_q()
+{
+    // A1in keeps 2 blocks and A1out remembers 4 pages
+    std::vector<BufferBlock> blocks(4);
+    auto replacer = Replacer::create(ReplacementPolicy::TWO_Q, 8);
+    for (int i = 0; i < 4; ++i)
+    {
+        insert(*replacer, blocks[i], i + 1);
+        expect(Access::queue(blocks[i]) == BufferBlock::QUEUE_A1IN,
+               "2q: a first reference in A1in");
+    }
+
+    // touches in A1in do not keep a block, it is a FIFO
+    replacer->touch(&blocks[0]);
+    expect(evict(*replacer) == &blocks[0], "2q: A1in in order");
+    expect(evict(*replacer) == &blocks[1], "2q: A1in in order");
+
+    // page 1 is remembered in A1out, page 5 is not
+    insert(*replacer, blocks[0], 1);
+    expect(Access::queue(blocks[0]) == BufferBlock::QUEUE_AM,
+           "2q: promoted from A1out to Am");
+    insert(*replacer, blocks[1], 5);
+    expect(Access::queue(blocks[1]) == BufferBlock::QUEUE_A1IN,
+           "2q: a new page in A1in");
+
+    // Am is only evicted from once A1in is down to its size
+    expect(evict(*replacer) == &blocks[2], "2q: A1in over its size first");
+    expect(evict(*replacer) == &blocks[0], "2q: then Am");
+
+    // a page evicted from Am is not remembered
+    insert(*replacer, blocks[0], 1);
+    expect(Access::queue(blocks[0]) == BufferBlock::QUEUE_A1IN,
+           "2q: not remembered from Am");
+
+    // pages 4, 5 and 1 push page 2 out of A1out, page 3 is still there
+    expect(evict(*replacer) == &blocks[3], "2q: A1in in order");
+    expect(evict(*replacer) == &blocks[1], "2q: A1in in order");
+    expect(evict(*replacer) == &blocks[0], "2q: A1in in order");
+
+    insert(*replacer, blocks[0], 2);
+    expect(Access::queue(blocks[0]) == BufferBlock::QUEUE_A1IN,
+           "2q: forgotten by A1out");
+    insert(*replacer, blocks[1], 3);
+    expect(Access::queue(blocks[1]) == BufferBlock::QUEUE_AM,
+           "2q: still in A1out");
+
+    Access::set_pins(blocks[0], 1);
+    expect(evict(*replacer) == &blocks[1], "2q: a pinned block skipped");
+    expect(replacer->victim() == nullptr, "2q: only a pinned block left");
+}
+
+// the victim is always a block in the replacer that is not pinned, and
+// there is one unless every block in the replacer is pinned
+void run_random(ReplacementPolicy policy, int num_operations, unsigned seed)
+{
+    constexpr int NUM_BLOCKS = 16;
+
+    std::vector<BufferBlock> blocks(NUM_BLOCKS);
+    auto replacer = Replacer::create(policy, NUM_BLOCKS);
+
+    std::set<BufferBlock*> inserted;
+    std::set<pagenum_t> cached;
+
+    std::mt19937 gen(seed);
+    const auto pick = [&](const std::set<BufferBlock*>& set) {
+        return *std::next(begin(set), gen() % set.size());
+    };
+
+    for (int i = 0; i < num_operations; ++i)
+    {
+        const int op = gen() % 5;
+
+        if (op == 0 && inserted.size() < NUM_BLOCKS)
+        {
+            // a small page range, so that A1out is hit often
+            pagenum_t pagenum = gen() % (2 * NUM_BLOCKS);
+            while (cached.count(pagenum) > 0)
+                pagenum = gen() % (2 * NUM_BLOCKS);
+
+            BufferBlock* block = &blocks[0];
+            while (inserted.count(block) > 0)
+                ++block;
+
+            Access::set_pins(*block, 0);
+            insert(*replacer, *block, pagenum);
+            inserted.insert(block);
+            cached.insert(pagenum);
+        }
+        else if (op == 1 && !inserted.empty())
+        {
+            replacer->touch(pick(inserted));
+        }
+        else if (op == 2 && !inserted.empty())
+        {
+            BufferBlock* block = pick(inserted);
+            Access::set_pins(*block, 1 - Access::pin_count(*block));
+        }
+        else if (op == 3 && !inserted.empty())
+        {
+            // dropped without being the victim, as close_table() does
+            BufferBlock* block = pick(inserted);
+            replacer->erase(block);
+            inserted.erase(block);
+            cached.erase(block->pagenum());
+        }
+        else
+        {
+            bool all_pinned = true;
+            for (BufferBlock* block : inserted)
+                all_pinned = all_pinned && Access::pin_count(*block) > 0;
+
+            BufferBlock* victim = evict(*replacer);
+            if (victim == nullptr)
+            {
+                expect(all_pinned, "no victim with an unpinned block");
+                continue;
+            }
+
+            expect(inserted.count(victim) > 0, "an erased block evicted");
+            expect(Access::pin_count(*victim) == 0, "a pinned block evicted");
+            inserted.erase(victim);
+            cached.erase(victim->pagenum());
+        }
+    }
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_operations = (argc > 1) ? std::atoi(argv[1]) : 100000;
+
+    run_lru();
+    run_clock();
+    run_two_q();
+
+    for (ReplacementPolicy policy : POLICIES)
+    {
+        for (unsigned seed = 1; seed <= 4; ++seed)
+            run_random(policy, num_operations, seed);
+    }
+
+    return test_result();
+}
@@ -0,0 +1,260 @@
+// range scans along the leaf sibling chain. random ranges see the records
+// of a std::set, a scan sees every key kept while another thread splits
+// and merges leaves under it, a scan waits for the lock of a record being
+// updated, and read only tables are scanned from the mapped file.
+//
+// usage: unittest_scan [keys] [ranges]
+
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// the keys db_scan_*() returns in a transaction, whose values are checked
+std::vector<int64_t> scan(int table_id, int64_t lo, int64_t hi)
+{
+    std::vector<int64_t> keys;
+
+    const int trx_id = trx_begin();
+    const int scan_id = db_scan_open(table_id, lo, hi, trx_id);
+    expect(scan_id != 0, "db_scan_open");
+
+    int64_t key;
+    char value[PAGE_DATA_VALUE_SIZE];
+    while (db_scan_next(scan_id, &key, value) == SUCCESS)
+    {
+        expect(value_of(key) == value, "a value scanned");
+        keys.push_back(key);
+    }
+
+    expect(db_scan_close(scan_id) == SUCCESS, "db_scan_close");
+    expect(db_scan_next(scan_id, &key, value) != SUCCESS,
+           "a closed scan");
+    expect(trx_commit(trx_id) == trx_id, "commit");
+
+    return keys;
+}
+
+std::vector<int64_t> keys_in(const std::set<int64_t>& keys, int64_t lo,
+                             int64_t hi)
+{
+    if (lo > hi)
+        return {};
+
+    return std::vector<int64_t>(keys.lower_bound(lo), keys.upper_bound(hi));
+}
+
+void run_ranges(int64_t num_keys, int num_ranges)
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    expect(scan(table_id, 0, num_keys).empty(), "an empty table");
+
+    std::mt19937 gen(1);
+    std::set<int64_t> keys;
+    for (int64_t i = 0; i < num_keys; ++i)
+    {
+        const int64_t key = gen() % (num_keys * 4);
+        if (keys.insert(key).second)
+            insert(table_id, key);
+    }
+
+    // leaves emptied by deletes are passed over
+    for (int64_t key = num_keys; key < num_keys * 2; ++key)
+    {
+        if (keys.erase(key) > 0)
+            expect(db_delete(table_id, key) == SUCCESS, "delete");
+    }
+
+    for (int i = 0; i < num_ranges; ++i)
+    {
+        const int64_t lo = gen() % (num_keys * 5) - num_keys / 2;
+        const int64_t hi = lo + gen() % (num_keys / 2) - num_keys / 100;
+
+        expect(scan(table_id, lo, hi) == keys_in(keys, lo, hi),
+               "a range");
+    }
+
+    constexpr int64_t MIN = std::numeric_limits<int64_t>::min();
+    constexpr int64_t MAX = std::numeric_limits<int64_t>::max();
+    expect(scan(table_id, MIN, MAX) == keys_in(keys, MIN, MAX),
+           "the whole table");
+    expect(scan(table_id, *keys.begin(), *keys.begin()).size() == 1,
+           "a single key");
+    expect(scan(table_id, MAX, MAX).empty(), "past the last key");
+
+    expect(db_scan_open(table_id, 0, 1, 0) == 0,
+           "a scan without a transaction");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+// the even keys are kept, the odd ones inserted and deleted by a writer
+void run_concurrent(int64_t num_keys)
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+    Table& table = table_of(table_id);
+
+    for (int64_t key = 0; key < num_keys; key += 2)
+        insert(table_id, key);
+
+    std::atomic<bool> stop{ false };
+    std::thread writer([&] {
+        std::mt19937 gen(2);
+        std::set<int64_t> odd;
+        while (!stop)
+        {
+            // runs of keys, so that leaves are split and merged
+            const int64_t first = (gen() % (num_keys / 2)) * 2 + 1;
+            const bool insert_run = odd.count(first) == 0;
+            for (int64_t key = first; key < first + 200 && key < num_keys;
+                 key += 2)
+            {
+                if (insert_run && odd.insert(key).second)
+                    insert(table_id, key);
+                if (!insert_run && odd.erase(key) > 0)
+                    expect(db_delete(table_id, key) == SUCCESS, "delete");
+            }
+        }
+    });
+
+    for (int i = 0; i < 20; ++i)
+    {
+        ScanCursor cursor;
+        cursor.next_key = 0;
+        cursor.hi = num_keys;
+
+        int64_t expected = 0;
+        int64_t last = -1;
+        while (!cursor.done)
+        {
+            expect(table.scan(cursor, nullptr), "scan");
+            for (const page_data_t& record : cursor.records)
+            {
+                expect(record.key > last, "keys in order");
+                last = record.key;
+
+                if (record.key % 2 != 0)
+                    continue;
+
+                expect(record.key == expected, "every key kept");
+                expected = record.key + 2;
+            }
+        }
+
+        expect(expected >= num_keys, "a scan to the end");
+    }
+
+    stop = true;
+    writer.join();
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+void run_locked()
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    for (int64_t key = 0; key < 100; ++key)
+        insert(table_id, key);
+
+    const int writer = trx_begin();
+    char updated[] = "updated";
+    expect(db_update(table_id, 50, updated, writer) == SUCCESS, "update");
+
+    std::atomic<bool> read_updated{ false };
+    std::thread reader([&] {
+        const int trx_id = trx_begin();
+        const int scan_id = db_scan_open(table_id, 40, 60, trx_id);
+
+        int64_t key;
+        char value[PAGE_DATA_VALUE_SIZE];
+        while (db_scan_next(scan_id, &key, value) == SUCCESS)
+        {
+            if (key == 50)
+                read_updated = std::string(value) == updated;
+        }
+
+        expect(db_scan_close(scan_id) == SUCCESS, "db_scan_close");
+        expect(trx_commit(trx_id) == trx_id, "commit");
+    });
+
+    // the scan waits on the record until the update is committed
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    expect(!read_updated, "a record read before the commit");
+    expect(trx_commit(writer) == writer, "commit");
+
+    reader.join();
+    expect(read_updated, "a record read after the commit");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+void run_read_only(int64_t num_keys)
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    std::set<int64_t> keys;
+    for (int64_t key = 0; key < num_keys; key += 3)
+    {
+        insert(table_id, key);
+        keys.insert(key);
+    }
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+
+    unlink(LOG_PATH);
+    expect(open_db(), "reopen");
+    table_id = open_table_read_only(const_cast<char*>(TABLE_NAME));
+    expect(table_id > 0, "open read only");
+
+    expect(scan(table_id, 10, num_keys / 2) ==
+               keys_in(keys, 10, num_keys / 2),
+           "a read only range");
+    expect(scan(table_id, -5, num_keys * 2) ==
+               keys_in(keys, -5, num_keys * 2),
+           "a read only table");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int64_t num_keys = (argc > 1) ? std::atoll(argv[1]) : 20000;
+    const int num_ranges = (argc > 2) ? std::atoi(argv[2]) : 200;
+
+    run_ranges(num_keys, num_ranges);
+    run_concurrent(num_keys);
+    run_locked();
+    run_read_only(num_keys);
+
+    return test_result();
+}
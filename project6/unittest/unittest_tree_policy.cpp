@@ -0,0 +1,139 @@
+// split and merge policies of the b+ tree. random inserts and deletes
+// under every policy are checked against a std::set, a policy out of range
+// is refused, and the split fill is seen in the number of leaves.
+//
+// usage: unittest_tree_policy [operations]
+
+#include "bpt.h"
+#include "common.h"
+#include "dbapi.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace
+{
+constexpr int64_t KEY_RANGE = 20000;
+
+// a new table in a new database, split and merged by the policy
+int open_new_table(const TreePolicy& policy)
+{
+    remove_db();
+
+    DBConfig config;
+    config.tree_policy = policy;
+
+    if (!open_db(TEST_NUM_BUF, config))
+        return -1;
+
+    return open_table(const_cast<char*>(TABLE_NAME));
+}
+
+void run_random(const TreePolicy& policy, int num_operations)
+{
+    const int table_id = open_new_table(policy);
+    expect(table_id > 0, "init");
+
+    std::mt19937 gen(1);
+    std::set<int64_t> keys;
+    char value[] = "value";
+
+    for (int i = 0; i < num_operations; ++i)
+    {
+        const int64_t key = gen() % KEY_RANGE;
+
+        // inserts win at first, deletes later, so that nodes fill up and
+        // empty again
+        const bool insert = (i < num_operations / 2) ? gen() % 4 != 0
+                                                     : gen() % 4 == 0;
+        if (insert)
+        {
+            const bool inserted = keys.insert(key).second;
+            expect((db_insert(table_id, key, value) == SUCCESS) == inserted,
+                   "insert");
+        }
+        else
+        {
+            const bool erased = keys.erase(key) > 0;
+            expect((db_delete(table_id, key) == SUCCESS) == erased,
+                   "delete");
+        }
+    }
+
+    for (int64_t key = 0; key < KEY_RANGE; ++key)
+    {
+        expect(table_of(table_id).find(key, nullptr).has_value() ==
+                   (keys.count(key) > 0),
+               "find");
+    }
+
+    const auto layout = table_of(table_id).leaf_layout();
+    expect(layout.has_value(), "sibling chain");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+uint64_t append_leaves(const TreePolicy& policy, int num_keys)
+{
+    const int table_id = open_new_table(policy);
+    expect(table_id > 0, "init");
+
+    char value[] = "value";
+    for (int64_t key = 0; key < num_keys; ++key)
+        expect(db_insert(table_id, key, value) == SUCCESS, "append");
+
+    const auto layout = table_of(table_id).leaf_layout();
+    expect(shutdown_db() == SUCCESS, "shutdown");
+
+    return layout.has_value() ? layout->num_leaves : 0;
+}
+
+void run_invalid()
+{
+    const int table_id = open_new_table(TreePolicy());
+    expect(table_id > 0, "init");
+
+    expect(db_set_tree_policy(table_id, { 0.5, 0, 0.5 }) != SUCCESS,
+           "a merge threshold of a half");
+    expect(db_set_tree_policy(table_id, { 0, 1, 0.5 }) != SUCCESS,
+           "a bias of one");
+    expect(db_set_tree_policy(table_id, { 0, 0, 0 }) != SUCCESS,
+           "a split fill of zero");
+    expect(db_set_tree_policy(table_id, { 0.2, 0.3, 0.8 }) == SUCCESS,
+           "a valid policy");
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+
+    DBConfig config;
+    config.tree_policy.split_fill = 1;
+    expect(!open_db(TEST_NUM_BUF, config), "an invalid default policy");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_operations = (argc > 1) ? std::atoi(argv[1]) : 40000;
+
+    const std::vector<TreePolicy> policies{
+        { 0, 0, 0.5 },   { 0, 0, 0.9 },      { 0, 0, 0.1 },
+        { 0.25, 0, 0.5 }, { 0.25, 0.25, 0.5 }, { 0.45, 0.9, 0.99 },
+    };
+    for (const auto& policy : policies)
+        run_random(policy, num_operations);
+
+    // increasing keys leave the left leaves as they were split
+    const uint64_t half = append_leaves({ 0, 0, 0.5 }, 10000);
+    const uint64_t ninety = append_leaves({ 0, 0, 0.9 }, 10000);
+    expect(ninety * 10 < half * 6, "leaves filled by the split");
+
+    run_invalid();
+
+    return test_result();
+}
@@ -0,0 +1,361 @@
+// batched inserts and updates grouped by leaf. random batches, with keys
+// given twice or already in the table, see the records of a std::map, a
+// batch update logs one update record per key and is rolled back by an
+// abort, waits for the lock of a record updated by another transaction,
+// aborts on a deadlock, and batches of threads inserting keys of the same
+// leaves all end up in the tree.
+//
+// usage: unittest_write_batch [keys] [batches]
+
+#include "common.h"
+#include "dbapi.h"
+#include "log.h"
+#include "table.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// the values of a batch, kept alive for its char* pointers
+struct Batch final
+{
+    std::vector<int64_t> keys;
+    std::vector<std::string> values;
+    std::vector<char*> pointers;
+
+    void add(int64_t key, const std::string& value)
+    {
+        keys.push_back(key);
+        values.push_back(value);
+    }
+
+    char** data()
+    {
+        pointers.clear();
+        for (auto& value : values)
+            pointers.push_back(value.data());
+
+        return pointers.data();
+    }
+
+    int size() const
+    {
+        return keys.size();
+    }
+};
+
+// the whole table, checked against the records
+void check_table(int table_id, const std::map<int64_t, std::string>& records,
+                 int64_t max_key)
+{
+    Table& table = table_of(table_id);
+
+    bool same = true;
+    for (int64_t key = 0; key < max_key; ++key)
+    {
+        const auto record = table.find(key, nullptr);
+        auto it = records.find(key);
+
+        if (record.has_value() != (it != records.end()) ||
+            (record.has_value() && it->second != record->value))
+            same = false;
+    }
+
+    expect(same, "the records of the table");
+}
+
+void run_batches(int64_t num_keys, int num_batches)
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    std::map<int64_t, std::string> records;
+    std::mt19937 gen(1);
+
+    for (int i = 0; i < num_batches; ++i)
+    {
+        Batch batch;
+        const int size = gen() % 500;
+        for (int j = 0; j < size; ++j)
+        {
+            const int64_t key = gen() % num_keys;
+            batch.add(key, "insert" + std::to_string(key) + "-" +
+                               std::to_string(i));
+        }
+
+        // a key given twice, the first one is inserted
+        if (size > 0)
+            batch.add(batch.keys.front(), "again");
+
+        std::vector<int> inserted(batch.size(), -1);
+        expect(db_insert_batch(table_id, batch.keys.data(), batch.data(),
+                               batch.size(), inserted.data()) == SUCCESS,
+               "db_insert_batch");
+
+        for (int j = 0; j < batch.size(); ++j)
+        {
+            const bool is_new =
+                records.emplace(batch.keys[j], batch.values[j]).second;
+            expect(inserted[j] == is_new, "a record inserted or not");
+        }
+
+        // every other batch updates the keys instead
+        if (i % 2 == 0)
+            continue;
+
+        Batch update;
+        for (int j = 0; j < size; ++j)
+        {
+            const int64_t key = gen() % (num_keys + 100);
+            update.add(key, "update" + std::to_string(key) + "-" +
+                                std::to_string(i) + "-" + std::to_string(j));
+        }
+
+        std::vector<int> updated(update.size(), -1);
+        const int trx_id = trx_begin();
+        expect(db_update_batch(table_id, update.keys.data(), update.data(),
+                               update.size(), updated.data(),
+                               trx_id) == SUCCESS,
+               "db_update_batch");
+        expect(trx_commit(trx_id) == trx_id, "commit");
+
+        // the last value given for a key is kept
+        for (int j = 0; j < update.size(); ++j)
+        {
+            auto it = records.find(update.keys[j]);
+            expect(updated[j] == (it != records.end()),
+                   "a record updated or not");
+            if (it != records.end())
+                it->second = update.values[j];
+        }
+    }
+
+    check_table(table_id, records, num_keys + 100);
+
+    // the tree is still whole once the records are deleted
+    for (const auto& pr : records)
+        expect(db_delete(table_id, pr.first) == SUCCESS, "delete");
+    check_table(table_id, {}, num_keys + 100);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+void run_logging()
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    Batch batch;
+    std::map<int64_t, std::string> records;
+    for (int64_t key = 0; key < 1000; ++key)
+    {
+        batch.add(key, "value" + std::to_string(key));
+        records.emplace(key, batch.values.back());
+    }
+    expect(db_insert_batch(table_id, batch.keys.data(), batch.data(),
+                           batch.size(), nullptr) == SUCCESS,
+           "db_insert_batch");
+
+    Batch update;
+    for (int64_t key = 0; key < 1000; key += 3)
+        update.add(key, "updated");
+    update.add(2000, "missing");
+
+    const int record_size =
+        Log::create_update(0, 0, 0, HierarchyID(), PAGE_DATA_VALUE_SIZE,
+                           "", "")
+            .size();
+
+    // one update record per key found, then all undone by the abort
+    const int trx_id = trx_begin();
+    const lsn_t before = LogMgr().next_lsn();
+    expect(db_update_batch(table_id, update.keys.data(), update.data(),
+                           update.size(), nullptr, trx_id) == SUCCESS,
+           "db_update_batch");
+    expect(LogMgr().next_lsn() - before ==
+               static_cast<lsn_t>(record_size * (update.size() - 1)),
+           "an update record per key");
+
+    char value[PAGE_DATA_VALUE_SIZE];
+    expect(db_find(table_id, 3, value, trx_id) == SUCCESS &&
+               std::string(value) == "updated",
+           "a record updated");
+    expect(trx_abort(trx_id) == trx_id, "abort");
+
+    check_table(table_id, records, 1000);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+void run_locked()
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    Batch batch;
+    for (int64_t key = 0; key < 100; ++key)
+        batch.add(key, "value" + std::to_string(key));
+    expect(db_insert_batch(table_id, batch.keys.data(), batch.data(),
+                           batch.size(), nullptr) == SUCCESS,
+           "db_insert_batch");
+
+    const int writer = trx_begin();
+    char first[] = "first";
+    expect(db_update(table_id, 50, first, writer) == SUCCESS, "update");
+
+    std::atomic<bool> updated{ false };
+    std::thread other([&] {
+        Batch update;
+        for (int64_t key : { 90, 50, 10, 49, 51 })
+            update.add(key, "second");
+
+        const int trx_id = trx_begin();
+        expect(db_update_batch(table_id, update.keys.data(), update.data(),
+                               update.size(), nullptr, trx_id) == SUCCESS,
+               "db_update_batch");
+        updated = true;
+        expect(trx_commit(trx_id) == trx_id, "commit");
+    });
+
+    // the batch waits on the record until the update is committed
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    expect(!updated, "a record updated before the commit");
+    expect(trx_commit(writer) == writer, "commit");
+
+    other.join();
+    expect(updated, "a record updated after the commit");
+
+    std::map<int64_t, std::string> records;
+    for (int64_t key = 0; key < 100; ++key)
+        records.emplace(key, "value" + std::to_string(key));
+    for (int64_t key : { 90, 50, 10, 49, 51 })
+        records[key] = "second";
+    check_table(table_id, records, 100);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+void run_deadlock()
+{
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    Batch batch;
+    for (int64_t key = 0; key < 100; ++key)
+        batch.add(key, "value" + std::to_string(key));
+    expect(db_insert_batch(table_id, batch.keys.data(), batch.data(),
+                           batch.size(), nullptr) == SUCCESS,
+           "db_insert_batch");
+
+    char value[] = "locked";
+    const int first = trx_begin();
+    const int second = trx_begin();
+    expect(db_update(table_id, 10, value, first) == SUCCESS, "update");
+    expect(db_update(table_id, 20, value, second) == SUCCESS, "update");
+
+    // the first waits for the second
+    std::thread waiter([&] {
+        Batch update;
+        update.add(20, "first");
+        expect(db_update_batch(table_id, update.keys.data(), update.data(),
+                               update.size(), nullptr, first) == SUCCESS,
+               "db_update_batch");
+        expect(trx_commit(first) == first, "commit");
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // and the second for the first, which is a deadlock
+    Batch update;
+    update.add(5, "second");
+    update.add(10, "second");
+    expect(db_update_batch(table_id, update.keys.data(), update.data(),
+                           update.size(), nullptr, second) != SUCCESS,
+           "a deadlock");
+
+    waiter.join();
+
+    std::map<int64_t, std::string> records;
+    for (int64_t key = 0; key < 100; ++key)
+        records.emplace(key, "value" + std::to_string(key));
+    records[10] = "locked";
+    records[20] = "first";
+    check_table(table_id, records, 100);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+
+// each thread inserts the keys equal to its index modulo the threads
+void run_concurrent(int64_t num_keys)
+{
+    constexpr int NUM_THREADS = 4;
+
+    remove_db();
+
+    expect(open_db(), "init");
+    const int table_id = open_table(const_cast<char*>(TABLE_NAME));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t)
+    {
+        threads.emplace_back([&, t] {
+            for (int64_t first = 0; first < num_keys; first += 1000)
+            {
+                Batch batch;
+                for (int64_t key = first + t;
+                     key < first + 1000 && key < num_keys;
+                     key += NUM_THREADS)
+                    batch.add(key, "value" + std::to_string(key));
+
+                expect(db_insert_batch(table_id, batch.keys.data(),
+                                       batch.data(), batch.size(),
+                                       nullptr) == SUCCESS,
+                       "db_insert_batch");
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    std::map<int64_t, std::string> records;
+    for (int64_t key = 0; key < num_keys; ++key)
+        records.emplace(key, "value" + std::to_string(key));
+    check_table(table_id, records, num_keys);
+
+    expect(shutdown_db() == SUCCESS, "shutdown");
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int64_t num_keys = (argc > 1) ? std::atoll(argv[1]) : 20000;
+    const int num_batches = (argc > 2) ? std::atoi(argv[2]) : 100;
+
+    run_batches(num_keys, num_batches);
+    run_logging();
+    run_locked();
+    run_deadlock();
+    run_concurrent(num_keys);
+
+    return test_result();
+}